@@ -0,0 +1,770 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime and sysconf under -std=c11
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../examples/discord.h"
+#include "../examples/features.h"
+
+MASON_IMPL(IdentifyProperties, IDENTIFY_PROPERTIES_FIELDS)
+MASON_IMPL(IdentifyActivityButton, IDENTIFY_ACTIVITY_BUTTON_FIELDS)
+MASON_IMPL(IdentifyActivity, IDENTIFY_ACTIVITY_FIELDS)
+MASON_IMPL(IdentifyPresence, IDENTIFY_PRESENCE_FIELDS)
+MASON_IMPL(IdentifyEventData, IDENTIFY_EVENT_FIELDS)
+MASON_IMPL(ResumeEventData, RESUME_EVENT_FIELDS)
+MASON_IMPL(GatewayEventPayload, GATEWAY_EVENT_FIELDS)
+
+MASON_IMPL(Address, ADDRESS_FIELDS)
+MASON_IMPL(Person, PERSON_FIELDS)
+MASON_IMPL(Report, REPORT_FIELDS)
+
+/* Same payload as Person, with borrowed strings for the in-place decoder */
+#define TAGGED_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string_view, name)                                                  \
+    ARRAY(string_view, tags)
+
+MASON_STRUCT_DEFINE(Tagged, TAGGED_FIELDS)
+MASON_IMPL(Tagged, TAGGED_FIELDS)
+
+/* Snowflake IDs past 2^53, quoted the way Discord sends them and as plain numbers */
+#define SNOWFLAKES_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(int64_t, id)                                                            \
+    ARRAY(int64_t, ids)
+
+MASON_STRUCT_DEFINE(Snowflakes, SNOWFLAKES_FIELDS)
+MASON_IMPL(Snowflakes, SNOWFLAKES_FIELDS)
+
+char *mason_read_file_to_string(const char *path, size_t *out_len);
+
+/* Allocation Counting
+ *
+ * The benchmark binary interposes the C allocator so allocations made inside
+ * libcjson are counted too, without installing cJSON hooks (which would change
+ * how cJSON grows its print buffers).
+ */
+
+static atomic_size_t bench_alloc_count;
+
+#if defined(__GLIBC__)
+#define BENCH_COUNTS_ALLOCS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+#else
+#define BENCH_COUNTS_ALLOCS 0
+#endif
+
+/* Timing */
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Only the region between bench_begin/bench_end is measured */
+typedef struct {
+    uint64_t ns;
+    size_t allocs;
+    uint64_t start_ns;
+    size_t start_allocs;
+} bench_meter;
+
+static inline void bench_begin(bench_meter *m) {
+    m->start_allocs = atomic_load_explicit(&bench_alloc_count, memory_order_relaxed);
+    m->start_ns = bench_now_ns();
+}
+
+static inline void bench_end(bench_meter *m) {
+    m->ns += bench_now_ns() - m->start_ns;
+    m->allocs += atomic_load_explicit(&bench_alloc_count, memory_order_relaxed) - m->start_allocs;
+}
+
+/* Per-Type Operations */
+
+typedef struct {
+    void *(*from_string)(const char *json_str, size_t len);
+    void *(*decode)(const char *json_str, size_t len);
+    void *(*decode_arena)(mason_arena *arena, const char *json_str, size_t len);
+    void *(*decode_inplace)(char *json_str, size_t len);
+    MASON_Parsed (*to_json)(void *obj);
+    bool (*write)(void *obj, mason_buf *out);
+    size_t (*size_hint)(void *obj);
+    bool (*view_one)(const char *json_str, size_t len);
+    void *(*from_etf)(const uint8_t *data, size_t len);
+    bool (*to_etf)(void *obj, mason_buf *out);
+    size_t (*snapshot_size)(void *obj);
+    size_t (*snapshot_write)(void *obj, void *buf, size_t cap);
+    void *(*snapshot_load)(void *image, size_t len);
+    void *(*decode_push)(const char *json_str, size_t len, size_t chunk);
+    uint64_t (*hash)(void *obj, uint64_t seed);
+    void (*free)(void *obj);
+    bool borrows; // string_view fields, which only the in-place and arena decoders accept
+} bench_type;
+
+#define BENCH_TYPE_DEFINE(type, probe, borrows)                                                               \
+    static void *type##_bench_from_string(const char *s, size_t n) { return type##_from_string_sized(s, n); } \
+    static void *type##_bench_decode(const char *s, size_t n) { return type##_decode(s, n); }                 \
+    static void *type##_bench_decode_arena(mason_arena *a, const char *s, size_t n) {                         \
+        return type##_from_string_sized_arena(a, s, n);                                                       \
+    }                                                                                                         \
+    static void *type##_bench_decode_inplace(char *s, size_t n) { return type##_decode_inplace(s, n); }       \
+    static MASON_Parsed type##_bench_to_json(void *obj) { return type##_to_json((type *)obj); }               \
+    static bool type##_bench_write(void *obj, mason_buf *out) { return type##_write((type *)obj, out); }      \
+    static size_t type##_bench_size_hint(void *obj) { return type##_serialized_size_hint((type *)obj); }      \
+    static bool type##_bench_view_one(const char *s, size_t n) {                                              \
+        type##_view *v = type##_view_from_string_sized(s, n);                                                 \
+        bool ok = v && MASON_VIEW_HAS(type, v, probe);                                                        \
+        if (ok)                                                                                               \
+            (void)MASON_VIEW_GET(type, v, probe);                                                             \
+        type##_view_free(v);                                                                                  \
+        return ok;                                                                                            \
+    }                                                                                                         \
+    static void *type##_bench_from_etf(const uint8_t *d, size_t n) { return type##_from_etf(d, n); }          \
+    static bool type##_bench_to_etf(void *obj, mason_buf *out) { return type##_to_etf((type *)obj, out); }    \
+    static size_t type##_bench_snapshot_size(void *obj) { return type##_snapshot_size((type *)obj); }         \
+    static size_t type##_bench_snapshot_write(void *obj, void *buf, size_t cap) {                             \
+        return type##_snapshot_write((type *)obj, buf, cap);                                                  \
+    }                                                                                                         \
+    static void *type##_bench_snapshot_load(void *image, size_t n) { return type##_snapshot_load(image, n); } \
+    static void *type##_bench_decode_push(const char *s, size_t n, size_t chunk) {                            \
+        type##_decoder *dec = type##_decoder_create(0);                                                       \
+        mason_push_status st = MASON_PUSH_MORE;                                                               \
+        for (size_t off = 0; dec && off < n && st == MASON_PUSH_MORE; off += chunk)                           \
+            st = type##_decoder_feed(dec, s + off, n - off < chunk ? n - off : chunk, NULL);                  \
+        type *obj = dec ? type##_decoder_finish(dec) : NULL;                                                  \
+        type##_decoder_free(dec);                                                                             \
+        return obj;                                                                                           \
+    }                                                                                                         \
+    static uint64_t type##_bench_hash(void *obj, uint64_t seed) { return type##_hash((type *)obj, seed); }    \
+    static void type##_bench_free(void *obj) { type##_free((type *)obj); }                                    \
+    static const bench_type type##_bench = {                                                                  \
+        type##_bench_from_string,    type##_bench_decode,   type##_bench_decode_arena,                        \
+        type##_bench_decode_inplace, type##_bench_to_json,  type##_bench_write,                               \
+        type##_bench_size_hint,      type##_bench_view_one, type##_bench_from_etf,                            \
+        type##_bench_to_etf,         type##_bench_snapshot_size, type##_bench_snapshot_write,                 \
+        type##_bench_snapshot_load,  type##_bench_decode_push, type##_bench_hash,                             \
+        type##_bench_free,           borrows};
+
+/* The probe is the single field the lazy-view benchmark reads */
+BENCH_TYPE_DEFINE(GatewayEventPayload, op, false)
+BENCH_TYPE_DEFINE(Report, owner, false)
+BENCH_TYPE_DEFINE(Person, name, false)
+BENCH_TYPE_DEFINE(Tagged, name, true)
+BENCH_TYPE_DEFINE(Snowflakes, id, false)
+
+/* Workloads */
+
+typedef struct {
+    const char *name;
+    const bench_type *type;
+    char *json;
+    size_t len;
+    void *obj;          // decoded once, input for the serialize benchmarks
+    MASON_Parsed tree;  // parsed once, input for the raw cJSON print baseline
+    size_t out_len;     // compact serialized size
+    char *obj_src;      // writable copy of json that obj's string_view fields borrow
+    char *etf;          // obj encoded as an Erlang term, input for the ETF decode benchmark
+    size_t etf_len;
+    char *snapshot;     // obj as a flat snapshot image, input for the snapshot load benchmark
+    size_t snapshot_len;
+} bench_workload;
+
+typedef struct {
+    const char *workload;
+    const char *op;
+    size_t iters;
+    size_t bytes; // bytes processed per op (input for parsing, output for serializing)
+    double ns_per_op;
+    double allocs_per_op;
+} bench_result;
+
+typedef void (*bench_op_fn)(bench_workload *w, bench_meter *m, void *scratch);
+
+static void op_cjson_parse(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    MASON_Parsed tree = mason_parse_sized(w->json, w->len);
+    mason_delete(tree);
+    bench_end(m);
+}
+
+static void op_cjson_print(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    char *s = cJSON_PrintUnformatted(w->tree);
+    cJSON_free(s);
+    bench_end(m);
+}
+
+static void op_from_string(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    void *obj = w->type->from_string(w->json, w->len);
+    bench_end(m);
+    w->type->free(obj);
+}
+
+static void op_decode(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    void *obj = w->type->decode(w->json, w->len);
+    bench_end(m);
+    w->type->free(obj);
+}
+
+static void op_decode_arena(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_arena *arena = (mason_arena *)scratch;
+    bench_begin(m);
+    w->type->decode_arena(arena, w->json, w->len);
+    mason_arena_reset(arena);
+    bench_end(m);
+}
+
+/* The input is consumed, so each run decodes a fresh copy (not measured) */
+static void op_decode_inplace(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *copy = (mason_buf *)scratch;
+    mason_buf_reset(copy);
+    mason_buf_append(copy, w->json, w->len);
+    if (copy->failed)
+        return;
+    bench_begin(m);
+    void *obj = w->type->decode_inplace(copy->data, copy->len);
+    bench_end(m);
+    w->type->free(obj);
+}
+
+#define BENCH_PUSH_CHUNK 4096
+
+/* Feeds the input in network-sized chunks, as if it arrived over a socket */
+static void op_decode_push(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    void *obj = w->type->decode_push(w->json, w->len, BENCH_PUSH_CHUNK);
+    bench_end(m);
+    w->type->free(obj);
+}
+
+/* ETF and snapshot ops report the JSON byte counts, so MB/s compares directly with decode/write */
+static void op_decode_etf(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    void *obj = w->type->from_etf((const uint8_t *)w->etf, w->etf_len);
+    bench_end(m);
+    w->type->free(obj);
+}
+
+/* Loading patches the image, so each run loads a fresh copy (not measured) */
+static void op_snapshot_load(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *copy = (mason_buf *)scratch;
+    mason_buf_reset(copy);
+    mason_buf_append(copy, w->snapshot, w->snapshot_len);
+    if (copy->failed)
+        return;
+    bench_begin(m);
+    w->type->snapshot_load(copy->data, copy->len);
+    bench_end(m);
+}
+
+static void op_view_one(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    w->type->view_one(w->json, w->len);
+    bench_end(m);
+}
+
+static void op_free(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    void *obj = w->type->decode(w->json, w->len);
+    bench_begin(m);
+    w->type->free(obj);
+    bench_end(m);
+}
+
+static void op_to_string(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    MASON_Parsed json = w->type->to_json(w->obj);
+    char *s = cJSON_PrintUnformatted(json);
+    cJSON_free(s);
+    mason_delete(json);
+    bench_end(m);
+}
+
+static void op_write(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *out = (mason_buf *)scratch;
+    bench_begin(m);
+    mason_buf_reset(out);
+    w->type->write(w->obj, out);
+    bench_end(m);
+}
+
+/* Sized once from the hint, then serialized without allocating */
+static void op_write_fixed(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *storage = (mason_buf *)scratch;
+    bench_begin(m);
+    size_t hint = w->type->size_hint(w->obj);
+    if (mason_buf_reserve(storage, hint)) {
+        mason_buf out;
+        mason_buf_init_fixed(&out, storage->data, storage->cap);
+        w->type->write(w->obj, &out);
+    }
+    bench_end(m);
+}
+
+static void op_write_etf(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *out = (mason_buf *)scratch;
+    bench_begin(m);
+    mason_buf_reset(out);
+    w->type->to_etf(w->obj, out);
+    bench_end(m);
+}
+
+static void op_snapshot_write(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *storage = (mason_buf *)scratch;
+    bench_begin(m);
+    size_t size = w->type->snapshot_size(w->obj);
+    if (mason_buf_reserve(storage, size))
+        w->type->snapshot_write(w->obj, storage->data, storage->cap);
+    bench_end(m);
+}
+
+/* What a dedupe cache pays per lookup instead of serializing */
+static void op_hash(bench_workload *w, bench_meter *m, void *scratch) {
+    (void)scratch;
+    bench_begin(m);
+    volatile uint64_t h = w->type->hash(w->obj, 0);
+    (void)h;
+    bench_end(m);
+}
+
+static void op_round_trip(bench_workload *w, bench_meter *m, void *scratch) {
+    mason_buf *out = (mason_buf *)scratch;
+    bench_begin(m);
+    void *obj = w->type->decode(w->json, w->len);
+    mason_buf_reset(out);
+    w->type->write(obj, out);
+    w->type->free(obj);
+    bench_end(m);
+}
+
+typedef struct {
+    const char *name;
+    bench_op_fn fn;
+    bool output_bytes;
+    bool copies; // decodes through a copying decoder, skipped for borrowing types
+} bench_op;
+
+static const bench_op bench_ops[] = {
+    {"cjson_parse", op_cjson_parse, false, false},
+    {"from_string", op_from_string, false, true},
+    {"decode", op_decode, false, true},
+    {"decode_arena", op_decode_arena, false, false},
+    {"decode_inplace", op_decode_inplace, false, false},
+    {"decode_push", op_decode_push, false, true},
+    {"decode_etf", op_decode_etf, false, true},
+    {"snapshot_load", op_snapshot_load, false, false},
+    {"view_one", op_view_one, false, false},
+    {"free", op_free, false, true},
+    {"cjson_print", op_cjson_print, false, false}, // prints the full input tree
+    {"to_string", op_to_string, true, false},
+    {"write", op_write, true, false},
+    {"write_fixed", op_write_fixed, true, false},
+    {"write_etf", op_write_etf, true, false},
+    {"snapshot_write", op_snapshot_write, true, false},
+    {"hash", op_hash, true, false},
+    {"round_trip", op_round_trip, false, true},
+};
+
+/* Synthetic Payloads */
+
+static void gen_person(mason_buf *b, size_t i, size_t extra_keys, size_t tags) {
+    char tmp[160];
+    int n = snprintf(tmp, sizeof(tmp),
+                     "{\"name\":\"person-%zu\",\"id\":%zu,\"score\":%zu.25,\"active\":%s,\"status\":%zu,\"tags\":[",
+                     i, 100000 + i, i % 100, i % 2 ? "true" : "false", i % 2);
+    mason_buf_append(b, tmp, (size_t)n);
+    for (size_t t = 0; t < tags; t++) {
+        n = snprintf(tmp, sizeof(tmp), "%s\"tag-%zu\"", t ? "," : "", t);
+        mason_buf_append(b, tmp, (size_t)n);
+    }
+    _MASON_WRITE_LITERAL(b, "],\"address\":{\"street\":\"Main St\",\"zip\":90210},"
+                            "\"history\":[{\"street\":\"1st Ave\",\"zip\":11111}],\"raw\":[1,2.5,\"x\",null,true]");
+    /* Undeclared keys exercise the skip path */
+    for (size_t k = 0; k < extra_keys; k++) {
+        n = snprintf(tmp, sizeof(tmp), ",\"unused_%zu\":{\"v\":[%zu,\"%zu\"]}", k, k, k);
+        mason_buf_append(b, tmp, (size_t)n);
+    }
+    mason_buf_putc(b, '}');
+}
+
+static char *gen_report(size_t people, size_t extra_keys, size_t *len) {
+    mason_buf b;
+    mason_buf_init(&b);
+    _MASON_WRITE_LITERAL(&b, "{\"owner\":");
+    gen_person(&b, 0, extra_keys, 2);
+    _MASON_WRITE_LITERAL(&b, ",\"people\":[");
+    for (size_t i = 0; i < people; i++) {
+        if (i)
+            mason_buf_putc(&b, ',');
+        gen_person(&b, i + 1, extra_keys, 2);
+    }
+    _MASON_WRITE_LITERAL(&b, "]}");
+    *len = b.len;
+    return mason_buf_detach(&b);
+}
+
+static char *gen_tags(size_t tags, size_t *len) {
+    mason_buf b;
+    mason_buf_init(&b);
+    gen_person(&b, 0, 0, tags);
+    *len = b.len;
+    return mason_buf_detach(&b);
+}
+
+/* Nested arrays inside ARRAY_MULTI plus an undeclared nested object */
+static char *gen_deep(size_t depth, size_t *len) {
+    mason_buf b;
+    mason_buf_init(&b);
+    _MASON_WRITE_LITERAL(&b, "{\"name\":\"deep\",\"raw\":[");
+    for (size_t i = 0; i < depth; i++)
+        mason_buf_putc(&b, '[');
+    for (size_t i = 0; i < depth; i++)
+        mason_buf_putc(&b, ']');
+    _MASON_WRITE_LITERAL(&b, "],\"unused\":");
+    for (size_t i = 0; i < depth; i++)
+        _MASON_WRITE_LITERAL(&b, "{\"k\":");
+    mason_buf_putc(&b, '1');
+    for (size_t i = 0; i < depth; i++)
+        mason_buf_putc(&b, '}');
+    mason_buf_putc(&b, '}');
+    *len = b.len;
+    return mason_buf_detach(&b);
+}
+
+/* Long token, url and message-like text, mostly clean with an escape every few hundred bytes */
+static void gen_text(mason_buf *b, size_t len, size_t seed) {
+    static const char words[] = "the quick brown fox jumps over the lazy dog while the gateway keeps sending events ";
+    for (size_t i = 0; i < len; i++) {
+        if ((i + seed) % 300 == 299 && i % 2)
+            _MASON_WRITE_LITERAL(b, "\\n");
+        else if ((i + seed) % 300 == 299)
+            _MASON_WRITE_LITERAL(b, "\\\"");
+        else
+            mason_buf_putc(b, words[(i + seed) % (sizeof(words) - 1)]);
+    }
+}
+
+static char *gen_strings(size_t activities, size_t *len) {
+    mason_buf b;
+    mason_buf_init(&b);
+    _MASON_WRITE_LITERAL(&b, "{\"op\":2,\"d\":{\"token\":\"");
+    for (size_t i = 0; i < 1024; i++)
+        mason_buf_putc(&b, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"[i * 7 % 64]);
+    _MASON_WRITE_LITERAL(&b, "\",\"properties\":{\"os\":\"linux\",\"browser\":\"mason\",\"device\":\"mason\"},"
+                             "\"presence\":{\"since\":0,\"status\":\"online\",\"afk\":false,\"activities\":[");
+    for (size_t i = 0; i < activities; i++) {
+        if (i)
+            mason_buf_putc(&b, ',');
+        _MASON_WRITE_LITERAL(&b, "{\"name\":\"");
+        gen_text(&b, 1000, i);
+        _MASON_WRITE_LITERAL(&b, "\",\"type\":0,\"url\":\"https://cdn.example.com/attachments/");
+        gen_text(&b, 200, i * 3);
+        _MASON_WRITE_LITERAL(&b, "\",\"buttons\":[{\"label\":\"open\",\"url\":\"https://example.com/");
+        gen_text(&b, 120, i * 5);
+        _MASON_WRITE_LITERAL(&b, "\"}]}");
+    }
+    _MASON_WRITE_LITERAL(&b, "]},\"intents\":513}}");
+    *len = b.len;
+    return mason_buf_detach(&b);
+}
+
+static char *gen_snowflakes(size_t count, size_t *len) {
+    mason_buf b;
+    mason_buf_init(&b);
+    char tmp[32];
+    _MASON_WRITE_LITERAL(&b, "{\"id\":\"1234567890123456789\",\"ids\":[");
+    for (size_t i = 0; i < count; i++) {
+        /* Millisecond timestamp in the top bits, worker and sequence below */
+        uint64_t id = ((uint64_t)(1420070400000u + i * 997) << 22) | (i & 0x3FFFFF);
+        int n = snprintf(tmp, sizeof(tmp), "%s%llu", i ? "," : "", (unsigned long long)id);
+        mason_buf_append(&b, tmp, (size_t)n);
+    }
+    _MASON_WRITE_LITERAL(&b, "]}");
+    *len = b.len;
+    return mason_buf_detach(&b);
+}
+
+/* Copied so every workload buffer belongs to the active Mason allocator */
+static char *bench_load_file(const char *path, size_t *len) {
+    char *data = mason_read_file_to_string(path, len);
+    if (!data)
+        return NULL;
+    mason_buf b;
+    mason_buf_init(&b);
+    mason_buf_append(&b, data, *len);
+    free(data);
+    return mason_buf_detach(&b);
+}
+
+/* Runner */
+
+static double bench_min_seconds = 0.25;
+
+static bench_result bench_run(bench_workload *w, const bench_op *op) {
+    mason_buf out;
+    mason_arena arena;
+    mason_buf_init(&out);
+    mason_arena_init(&arena, 0);
+    void *scratch = op->fn == op_decode_arena ? (void *)&arena : (void *)&out;
+
+    /* Warm up, then run until the measured time reaches the target */
+    bench_meter warm = {0};
+    op->fn(w, &warm, scratch);
+
+    bench_meter m = {0};
+    size_t iters = 0;
+    uint64_t target = (uint64_t)(bench_min_seconds * 1e9);
+    uint64_t wall_start = bench_now_ns();
+    while (iters < 3 || (m.ns < target && bench_now_ns() - wall_start < 4 * target)) {
+        op->fn(w, &m, scratch);
+        iters++;
+    }
+
+    mason_buf_free(&out);
+    mason_arena_destroy(&arena);
+
+    bench_result r = {w->name, op->name, iters, op->output_bytes ? w->out_len : w->len,
+                      (double)m.ns / (double)iters, (double)m.allocs / (double)iters};
+    return r;
+}
+
+static void bench_report(FILE *json_out, const bench_result *r) {
+    double mb_per_s = r->ns_per_op > 0 ? (double)r->bytes / r->ns_per_op * 1e9 / (1024.0 * 1024.0) : 0;
+    printf("%-14s %-14s %12.0f %10.1f %12.2f %10zu\n", r->workload, r->op, r->ns_per_op, mb_per_s,
+           BENCH_COUNTS_ALLOCS ? r->allocs_per_op : -1.0, r->iters);
+    fflush(stdout);
+    if (json_out) {
+        fprintf(json_out,
+                "{\"workload\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"iters\":%zu,"
+                "\"ns_per_op\":%.1f,\"mb_per_s\":%.2f,\"allocs_per_op\":%.2f}\n",
+                r->workload, r->op, r->bytes, r->iters, r->ns_per_op, mb_per_s,
+                BENCH_COUNTS_ALLOCS ? r->allocs_per_op : -1.0);
+    }
+}
+
+/* Batch decode of many small independent documents, at increasing worker counts */
+static void bench_batch(FILE *json_out, size_t max_threads, const char *filter) {
+    const char *name = "batch_20k";
+    if (filter && !strstr(name, filter) && !strstr("decode_batch", filter))
+        return;
+    size_t n = 20000;
+    mason_buf text;
+    mason_buf_init(&text);
+    size_t *offsets = (size_t *)mason_malloc((n + 1) * sizeof(size_t));
+    const char **docs = (const char **)mason_malloc(n * sizeof(char *));
+    size_t *lens = (size_t *)mason_malloc(n * sizeof(size_t));
+    Person **out = (Person **)mason_calloc(n, sizeof(Person *));
+    if (!offsets || !docs || !lens || !out)
+        goto done;
+    for (size_t i = 0; i < n; i++) {
+        offsets[i] = text.len;
+        gen_person(&text, i, 8, 4);
+    }
+    offsets[n] = text.len;
+    if (text.failed)
+        goto done;
+    for (size_t i = 0; i < n; i++) {
+        docs[i] = text.data + offsets[i];
+        lens[i] = offsets[i + 1] - offsets[i];
+    }
+
+    /* 1, 2, 4, ... and finally max_threads itself */
+    for (size_t threads = 1; threads <= max_threads; threads = threads == max_threads ? threads + 1
+                                                     : threads * 2 > max_threads   ? max_threads
+                                                                                   : threads * 2) {
+        mason_pool *pool = threads > 1 ? mason_pool_create(threads) : NULL;
+        bench_meter m = {0};
+        size_t iters = 0;
+        uint64_t target = (uint64_t)(bench_min_seconds * 1e9);
+        while (iters < 3 || m.ns < target) {
+            bench_begin(&m);
+            Person_decode_batch(docs, lens, n, out, pool);
+            bench_end(&m);
+            for (size_t i = 0; i < n; i++)
+                Person_free(out[i]);
+            iters++;
+        }
+        mason_pool_destroy(pool);
+
+        char op[32];
+        snprintf(op, sizeof(op), "decode_batch_%zu", threads);
+        bench_result r = {name, op, iters, text.len, (double)m.ns / (double)iters, (double)m.allocs / (double)iters};
+        bench_report(json_out, &r);
+    }
+
+done:
+    mason_free(offsets);
+    mason_free(docs);
+    mason_free(lens);
+    mason_free(out);
+    mason_buf_free(&text);
+}
+
+static bool bench_workload_prepare(bench_workload *w) {
+    if (!w->json)
+        return false;
+    /* In place, so string_view workloads serialize their real values */
+    w->obj_src = (char *)mason_malloc(w->len);
+    if (!w->obj_src)
+        return false;
+    memcpy(w->obj_src, w->json, w->len);
+    w->obj = w->type->decode_inplace(w->obj_src, w->len);
+    w->tree = mason_parse_sized(w->json, w->len);
+    if (!w->obj || !w->tree)
+        return false;
+    mason_buf out;
+    mason_buf_init(&out);
+    w->type->write(w->obj, &out);
+    w->out_len = out.len;
+    mason_buf_reset(&out);
+    w->type->to_etf(w->obj, &out);
+    w->etf_len = out.len;
+    w->etf = mason_buf_detach(&out);
+    w->snapshot_len = w->type->snapshot_size(w->obj);
+    w->snapshot = (char *)mason_malloc(w->snapshot_len);
+    if (!w->etf || !w->snapshot)
+        return false;
+    return w->type->snapshot_write(w->obj, w->snapshot, w->snapshot_len) == w->snapshot_len;
+}
+
+static void bench_workload_release(bench_workload *w) {
+    if (w->obj)
+        w->type->free(w->obj);
+    mason_free(w->obj_src);
+    mason_free(w->etf);
+    mason_free(w->snapshot);
+    mason_delete(w->tree);
+    mason_free(w->json);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--json PATH] [--time SECONDS] [--filter SUBSTRING] [--pool] [--threads N]\n"
+            "  --json PATH       also write one JSON object per result to PATH\n"
+            "  --time SECONDS    minimum measured time per benchmark (default 0.25)\n"
+            "  --filter TEXT     only run workloads or ops whose name contains TEXT\n"
+            "  --pool            use the built-in thread-local pool allocator\n"
+            "  --threads N       largest worker count for the batch benchmark (default: online CPUs)\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    const char *filter = NULL;
+    size_t max_threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            bench_min_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--pool") == 0) {
+            mason_set_allocator(mason_pool_allocator());
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    bench_workload workloads[] = {
+        {"discord", &GatewayEventPayload_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"features", &Report_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"wide_1k", &Report_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"people_10k", &Report_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"people_100k", &Report_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"tags_1m", &Person_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"deep_500", &Person_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"tags_1m_view", &Tagged_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"strings_1k", &GatewayEventPayload_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+        {"ids_100k", &Snowflakes_bench, NULL, 0, NULL, NULL, 0, NULL, NULL, 0, NULL, 0},
+    };
+    size_t nworkloads = sizeof(workloads) / sizeof(workloads[0]);
+    workloads[0].json = bench_load_file("examples/data/discord.json", &workloads[0].len);
+    workloads[1].json = bench_load_file("examples/data/features.json", &workloads[1].len);
+    workloads[2].json = gen_report(1000, 64, &workloads[2].len);
+    workloads[3].json = gen_report(10000, 0, &workloads[3].len);
+    workloads[4].json = gen_report(100000, 0, &workloads[4].len);
+    workloads[5].json = gen_tags(1000000, &workloads[5].len);
+    workloads[6].json = gen_deep(500, &workloads[6].len);
+    workloads[7].json = gen_tags(1000000, &workloads[7].len);
+    workloads[8].json = gen_strings(1000, &workloads[8].len);
+    workloads[9].json = gen_snowflakes(100000, &workloads[9].len);
+
+    FILE *json_out = NULL;
+    if (json_path) {
+        json_out = fopen(json_path, "w");
+        if (!json_out) {
+            perror(json_path);
+            return 1;
+        }
+    }
+
+    printf("%-14s %-14s %12s %10s %12s %10s\n", "workload", "op", "ns/op", "MB/s", "allocs/op", "iters");
+    int status = 0;
+    for (size_t i = 0; i < nworkloads; i++) {
+        bench_workload *w = &workloads[i];
+        if (!bench_workload_prepare(w)) {
+            fprintf(stderr, "failed to prepare workload %s\n", w->name);
+            status = 1;
+            continue;
+        }
+        for (size_t j = 0; j < sizeof(bench_ops) / sizeof(bench_ops[0]); j++) {
+            if (filter && !strstr(w->name, filter) && !strstr(bench_ops[j].name, filter))
+                continue;
+            if (bench_ops[j].copies && w->type->borrows)
+                continue;
+            bench_result r = bench_run(w, &bench_ops[j]);
+            bench_report(json_out, &r);
+        }
+    }
+
+    if (!max_threads) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    bench_batch(json_out, max_threads, filter);
+
+    for (size_t i = 0; i < nworkloads; i++)
+        bench_workload_release(&workloads[i]);
+    if (json_out)
+        fclose(json_out);
+    return status;
+}
@@ -1,71 +1,32 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #define MASON_PRINT_IMPL
-#include "../mason.h"
-
-// https://discord.com/developers/docs/topics/opcodes-and-status-codes#gateway-gateway-opcodes
-typedef enum {
-    SEND_OPCODE_HEARTBEAT = 1,
-    SEND_OPCODE_IDENTIFY = 2,
-    SEND_OPCODE_RESUME = 6,
-} GatewayOpcodeSend;
-
-#define MASON_TYPE_ALIAS_GatewayOpcodeSend int32_t
-
-// https://discord.com/developers/docs/events/gateway-events#identify-identify-structure
-#define IDENTIFY_PROPERTIES_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, os)                                                               \
-    FIELD(string, browser)                                                          \
-    FIELD(string, device)
-
-// https://discord.com/developers/docs/topics/gateway-events#activity-object
-#define IDENTIFY_ACTIVITY_BUTTON_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, label)                                                                 \
-    FIELD(string, url)
-
-#define IDENTIFY_ACTIVITY_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, name)                                                           \
-    FIELD(int32_t, type)                                                          \
-    FIELD(int64_t, created_at)                                                    \
-    FIELD(string, url)                                                            \
-    ARRAY_OBJECT(IdentifyActivityButton, buttons)
-
-// https://discord.com/developers/docs/events/gateway-events#presence-update
-#define IDENTIFY_PRESENCE_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(int64_t, since)                                                         \
-    FIELD(string, status)                                                         \
-    FIELD(bool, afk)                                                              \
-    ARRAY_OBJECT(IdentifyActivity, activities)
-
-#define IDENTIFY_EVENT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, token)                                                       \
-    OBJECT(IdentifyProperties, properties)                                     \
-    OBJECT(IdentifyPresence, presence)                                         \
-    FIELD(int32_t, intents)
-
-// https://discord.com/developers/docs/events/gateway-events#payload-structure
-#define GATEWAY_EVENT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(GatewayOpcodeSend, op)                                              \
-    OBJECT(IdentifyEventData, d)
-
-MASON_STRUCT_DEFINE(IdentifyProperties, IDENTIFY_PROPERTIES_FIELDS)
-MASON_STRUCT_DEFINE(IdentifyActivityButton, IDENTIFY_ACTIVITY_BUTTON_FIELDS)
-MASON_STRUCT_DEFINE(IdentifyActivity, IDENTIFY_ACTIVITY_FIELDS)
-MASON_STRUCT_DEFINE(IdentifyPresence, IDENTIFY_PRESENCE_FIELDS)
-MASON_STRUCT_DEFINE(IdentifyEventData, IDENTIFY_EVENT_FIELDS)
-MASON_STRUCT_DEFINE(GatewayEventPayload, GATEWAY_EVENT_FIELDS)
+#define MASON_ZLIB_IMPL
+#include "discord.h"
 
 MASON_IMPL(IdentifyProperties, IDENTIFY_PROPERTIES_FIELDS)
 MASON_IMPL(IdentifyActivityButton, IDENTIFY_ACTIVITY_BUTTON_FIELDS)
 MASON_IMPL(IdentifyActivity, IDENTIFY_ACTIVITY_FIELDS)
 MASON_IMPL(IdentifyPresence, IDENTIFY_PRESENCE_FIELDS)
 MASON_IMPL(IdentifyEventData, IDENTIFY_EVENT_FIELDS)
+MASON_IMPL(ResumeEventData, RESUME_EVENT_FIELDS)
 MASON_IMPL(GatewayEventPayload, GATEWAY_EVENT_FIELDS)
 
 char *mason_read_file_to_string(const char *path, size_t *out_len);
 
+// Compresses one message the way the gateway does with `compress=zlib-stream`
+static size_t zlib_stream_message(z_stream *zs, const char *msg, size_t len, uint8_t *out, size_t cap) {
+    zs->next_in = (Bytef *)msg;
+    zs->avail_in = (uInt)len;
+    zs->next_out = out;
+    zs->avail_out = (uInt)cap;
+    deflate(zs, Z_SYNC_FLUSH);
+    return cap - zs->avail_out;
+}
+
 int main(void) {
     size_t json_len = 0;
     char *json_str = mason_read_file_to_string("examples/data/discord.json", &json_len);
@@ -83,11 +44,177 @@ int main(void) {
         free(json_str);
         return 1;
     }
+
+    // Same payload through the single-pass decoder, which skips the cJSON tree
+    GatewayEventPayload *decoded = GatewayEventPayload_decode(json_str, json_len);
+
+    // Lazy view: only `op` and `d.intents` get decoded, everything else is just scanned
+    GatewayEventPayload_view *view = GatewayEventPayload_view_from_string_sized(json_str, json_len);
+    if (view) {
+        IdentifyEventData_view *d = MASON_VIEW_OPEN(GatewayEventPayload, view, d, IdentifyEventData);
+        printf("Lazy view: op=%d intents=%d\n\n", (int)MASON_VIEW_GET(GatewayEventPayload, view, op),
+               d ? MASON_VIEW_GET(IdentifyEventData, d, intents) : 0);
+        GatewayEventPayload_view_free(view);
+    }
+
+    // Push decoder: the payload arrives in 64-byte pieces and is decoded as they come, without reassembly
+    GatewayEventPayload_decoder *push = GatewayEventPayload_decoder_create(0);
+    if (push) {
+        size_t chunks = 0;
+        mason_push_status status = MASON_PUSH_MORE;
+        for (size_t off = 0; off < json_len && status == MASON_PUSH_MORE; off += 64, chunks++) {
+            size_t n = json_len - off < 64 ? json_len - off : 64;
+            status = GatewayEventPayload_decoder_feed(push, json_str + off, n, NULL);
+        }
+        GatewayEventPayload *pushed = GatewayEventPayload_decoder_finish(push);
+        printf("Push decoder: %s from %zu chunks\n\n", pushed && pushed->op == 2 ? "decoded" : "failed", chunks);
+        GatewayEventPayload_free(pushed);
+        GatewayEventPayload_decoder_free(push);
+    }
+
+    // `d` is decoded as the struct its opcode selects, even when it arrives before `op`
+    const char *resume_json = "{\"d\":{\"token\":\"Bot EXAMPLE_TOKEN\",\"session_id\":\"abc\",\"seq\":1337},\"op\":6}";
+    GatewayEventPayload *resume = GatewayEventPayload_decode(resume_json, strlen(resume_json));
+    if (resume && resume->op == SEND_OPCODE_RESUME && resume->d.resume)
+        printf("Union payload: resume session %s at seq %lld\n\n", resume->d.resume->session_id,
+               (long long)resume->d.resume->seq);
+    GatewayEventPayload_free(resume);
+
+    // An `op` that is null or not a number selects no case, whichever decoder reads it
+    const char *mistyped[] = {"{\"op\":\"6\",\"d\":{\"session_id\":\"abc\"}}",
+                              "{\"d\":{\"session_id\":\"abc\"},\"op\":null}"};
+    bool untagged = true;
+    for (size_t i = 0; i < 2; i++) {
+        GatewayEventPayload *single = GatewayEventPayload_decode(mistyped[i], strlen(mistyped[i]));
+        MASON_Parsed tree = mason_parse(mistyped[i]);
+        GatewayEventPayload *from_tree = GatewayEventPayload_from_json(tree);
+        untagged = untagged && single && !single->d.ptr && from_tree && !from_tree->d.ptr;
+        GatewayEventPayload_free(single);
+        GatewayEventPayload_free(from_tree);
+        mason_delete(tree);
+    }
+    printf("Mistyped op leaves d NULL: %s\n\n", untagged ? "yes" : "no");
+
+    // A masked decode skips every field outside the mask, here all but `op`
+    mason_field_mask op_mask = MASON_MASK(GatewayEventPayload, op);
+    GatewayEventPayload *op_only = GatewayEventPayload_from_string_masked(json_str, op_mask);
+    printf("Masked decode: op=%d, d %s\n\n", op_only ? (int)op_only->op : -1,
+           op_only && !op_only->d.ptr ? "skipped" : "decoded");
+    GatewayEventPayload_free(op_only);
+
+    // zlib-stream: two messages on one deflate stream, each split across two frames
+    z_stream server = {0};
+    uint8_t compressed[4096];
+    mason_inflate_ctx *inflater = mason_inflate_create();
+    if (inflater && deflateInit(&server, Z_DEFAULT_COMPRESSION) == Z_OK) {
+        int events = 0;
+        size_t sizes[2] = {0};
+        for (int i = 0; i < 2; i++) {
+            size_t n = zlib_stream_message(&server, json_str, json_len, compressed, sizeof(compressed));
+            GatewayEventPayload *event = NULL;
+            GatewayEventPayload_inflate(inflater, compressed, n / 2, &event); // incomplete, nothing decoded yet
+            if (GatewayEventPayload_inflate(inflater, compressed + n / 2, n - n / 2, &event) == MASON_INFLATE_MESSAGE)
+                events += event && event->op == 2;
+            GatewayEventPayload_free(event);
+            sizes[i] = n;
+        }
+        // The second message reuses the stream's dictionary, so it compresses further
+        printf("zlib-stream: %d/2 messages decoded from %zu and %zu compressed bytes\n\n", events, sizes[0], sizes[1]);
+        deflateEnd(&server);
+    }
+    mason_inflate_destroy(inflater);
     free(json_str);
 
     printf("Parsed GatewayEventPayload:\n");
     GatewayEventPayload_print(payload);
 
+    string expected = GatewayEventPayload_to_string_direct(payload);
+    string actual = GatewayEventPayload_to_string_direct(decoded);
+    printf("\nSingle-pass decode matches: %s\n", expected && actual && strcmp(expected, actual) == 0 ? "yes" : "no");
+    GatewayEventPayload_string_free(expected);
+    GatewayEventPayload_string_free(actual);
+
+    // Same comparison without serializing, as a dedupe cache would do it
+    bool same = GatewayEventPayload_equal(payload, decoded) &&
+                GatewayEventPayload_hash(payload, 0) == GatewayEventPayload_hash(decoded, 0);
+    printf("Equal with the same hash: %s\n", same ? "yes" : "no");
+
+    // Interned fields share one copy per distinct value, so both decodes hold the same pointer
+    IdentifyProperties *p1 = payload->d.identify ? payload->d.identify->properties : NULL;
+    IdentifyProperties *p2 = decoded && decoded->d.identify ? decoded->d.identify->properties : NULL;
+    printf("Interned properties shared: %s\n",
+           p1 && p2 && p1->os == p2->os && p1->browser == p2->browser ? "yes" : "no");
+
+    // Same payload as an Erlang term, as sent by the gateway with `encoding=etf`
+    mason_buf etf;
+    mason_buf_init(&etf);
+    GatewayEventPayload *from_etf = NULL;
+    if (GatewayEventPayload_to_etf(decoded, &etf))
+        from_etf = GatewayEventPayload_from_etf((const uint8_t *)etf.data, etf.len);
+    expected = GatewayEventPayload_to_string_direct(decoded);
+    actual = GatewayEventPayload_to_string_direct(from_etf);
+    printf("ETF round trip (%zu bytes) matches: %s\n", etf.len,
+           expected && actual && strcmp(expected, actual) == 0 ? "yes" : "no");
+    GatewayEventPayload_string_free(expected);
+    GatewayEventPayload_string_free(actual);
+    GatewayEventPayload_free(from_etf);
+    mason_buf_free(&etf);
+
+    // Flat snapshot: one image that loads back by patching offsets, without parsing
+    size_t snapshot_size = GatewayEventPayload_snapshot_size(decoded);
+    void *image = malloc(snapshot_size);
+    GatewayEventPayload *cached = NULL;
+    if (image && GatewayEventPayload_snapshot_write(decoded, image, snapshot_size))
+        cached = GatewayEventPayload_snapshot_load(image, snapshot_size);
+    expected = GatewayEventPayload_to_string_direct(decoded);
+    actual = GatewayEventPayload_to_string_direct(cached);
+    printf("Snapshot (%zu bytes) matches: %s\n", snapshot_size,
+           expected && actual && strcmp(expected, actual) == 0 ? "yes" : "no");
+    GatewayEventPayload_string_free(expected);
+    GatewayEventPayload_string_free(actual);
+    free(image); // the loaded struct lives inside the image
+
+    // Clone: a deep copy in one block, kept after the decoded original is gone
+    GatewayEventPayload *copy = GatewayEventPayload_clone(decoded);
+    expected = GatewayEventPayload_to_string_direct(decoded);
+    actual = GatewayEventPayload_to_string_direct(copy);
+    printf("Clone matches: %s\n", expected && actual && strcmp(expected, actual) == 0 ? "yes" : "no");
+    GatewayEventPayload_string_free(expected);
+    GatewayEventPayload_string_free(actual);
+    GatewayEventPayload_clone_free(copy);
+
+    // Send path: size the buffer once, then serialize into it without allocating
+    char send_buf[4096];
+    size_t hint = GatewayEventPayload_serialized_size_hint(decoded);
+    size_t sent = 0;
+    if (hint <= sizeof(send_buf))
+        sent = GatewayEventPayload_write_to_buffer(decoded, send_buf, sizeof(send_buf));
+    printf("Send buffer: %zu bytes written (size hint %zu)\n", sent, hint);
+
+    // Field masks: a presence update sends only the fields that changed
+    IdentifyPresence *presence = decoded && decoded->d.identify ? decoded->d.identify->presence : NULL;
+    mason_field_mask changed = MASON_MASK(IdentifyPresence, status) | MASON_MASK(IdentifyPresence, afk);
+    mason_buf update;
+    mason_buf_init(&update);
+    if (presence && IdentifyPresence_write_masked(presence, &update, changed))
+        printf("Presence update: %s\n", update.data);
+
+    // Merge patch: diff against a changed copy, then bring the original up to date with it
+    string presence_json = presence ? IdentifyPresence_to_string_direct(presence) : NULL;
+    IdentifyPresence *next = presence_json ? IdentifyPresence_decode(presence_json, strlen(presence_json)) : NULL;
+    if (next) {
+        next->since = 91879201;
+        next->afk = !next->afk;
+        mason_buf_reset(&update);
+        size_t changes = IdentifyPresence_diff(presence, next, &update);
+        bool applied = changes && IdentifyPresence_apply_patch(presence, update.data, update.len);
+        printf("Presence patch: %s (%zu changes, %s)\n", update.data, changes, applied ? "applied" : "not applied");
+    }
+    IdentifyPresence_free(next);
+    IdentifyPresence_string_free(presence_json);
+    mason_buf_free(&update);
+
+    GatewayEventPayload_free(decoded);
     GatewayEventPayload_free(payload);
 
     return 0;
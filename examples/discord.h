@@ -0,0 +1,70 @@
+#ifndef MASON_EXAMPLES_DISCORD_H
+#define MASON_EXAMPLES_DISCORD_H
+
+#include "../mason.h"
+
+// https://discord.com/developers/docs/topics/opcodes-and-status-codes#gateway-gateway-opcodes
+typedef enum {
+    SEND_OPCODE_HEARTBEAT = 1,
+    SEND_OPCODE_IDENTIFY = 2,
+    SEND_OPCODE_RESUME = 6,
+} GatewayOpcodeSend;
+
+#define MASON_TYPE_ALIAS_GatewayOpcodeSend int32_t
+
+// https://discord.com/developers/docs/events/gateway-events#identify-identify-structure
+#define IDENTIFY_PROPERTIES_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(interned, os)                                                                    \
+    FIELD(interned, browser)                                                               \
+    FIELD(interned, device)
+
+// https://discord.com/developers/docs/topics/gateway-events#activity-object
+#define IDENTIFY_ACTIVITY_BUTTON_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, label)                                                                        \
+    FIELD(string, url)
+
+#define IDENTIFY_ACTIVITY_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, name)                                                                  \
+    FIELD(int32_t, type)                                                                 \
+    FIELD(int64_t, created_at)                                                           \
+    FIELD(string, url)                                                                   \
+    ARRAY_OBJECT(IdentifyActivityButton, buttons)
+
+// https://discord.com/developers/docs/events/gateway-events#presence-update
+#define IDENTIFY_PRESENCE_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(int64_t, since)                                                                \
+    FIELD(interned, status)                                                              \
+    FIELD(bool, afk)                                                                     \
+    ARRAY_OBJECT(IdentifyActivity, activities)
+
+#define IDENTIFY_EVENT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, token)                                                              \
+    OBJECT(IdentifyProperties, properties)                                            \
+    OBJECT(IdentifyPresence, presence)                                                \
+    FIELD(int32_t, intents)
+
+// https://discord.com/developers/docs/events/gateway-events#resume-resume-structure
+#define RESUME_EVENT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, token)                                                            \
+    FIELD(string, session_id)                                                       \
+    FIELD(int64_t, seq)
+
+// The payload type of `d` depends on the opcode
+#define GATEWAY_EVENT_PAYLOADS(CASE)                        \
+    CASE(SEND_OPCODE_IDENTIFY, IdentifyEventData, identify) \
+    CASE(SEND_OPCODE_RESUME, ResumeEventData, resume)
+
+// https://discord.com/developers/docs/events/gateway-events#payload-structure
+#define GATEWAY_EVENT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(GatewayOpcodeSend, op)                                                     \
+    UNION(op, d, GATEWAY_EVENT_PAYLOADS)
+
+MASON_STRUCT_DEFINE(IdentifyProperties, IDENTIFY_PROPERTIES_FIELDS)
+MASON_STRUCT_DEFINE(IdentifyActivityButton, IDENTIFY_ACTIVITY_BUTTON_FIELDS)
+MASON_STRUCT_DEFINE(IdentifyActivity, IDENTIFY_ACTIVITY_FIELDS)
+MASON_STRUCT_DEFINE(IdentifyPresence, IDENTIFY_PRESENCE_FIELDS)
+MASON_STRUCT_DEFINE(IdentifyEventData, IDENTIFY_EVENT_FIELDS)
+MASON_STRUCT_DEFINE(ResumeEventData, RESUME_EVENT_FIELDS)
+MASON_STRUCT_DEFINE(GatewayEventPayload, GATEWAY_EVENT_FIELDS)
+
+#endif // MASON_EXAMPLES_DISCORD_H
@@ -4,61 +4,21 @@
 #include <string.h>
 
 #define MASON_PRINT_IMPL
-#include "../mason.h"
-
-typedef enum {
-    STATUS_OK = 0,
-    STATUS_WARN = 1
-} Status;
-
-#define MASON_TYPE_ALIAS_Status int32_t
-
-#define ADDRESS_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, street)                                               \
-    FIELD(int32_t, zip)
-
-#define PERSON_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    FIELD(string, name)                                                \
-    FIELD(int64_t, id)                                                 \
-    FIELD(double, score)                                               \
-    FIELD(bool, active)                                                \
-    FIELD(Status, status)                                              \
-    ARRAY(string, tags)                                                \
-    OBJECT(Address, address)                                           \
-    ARRAY_OBJECT(Address, history)                                     \
-    ARRAY_MULTI(raw)
-
-#define REPORT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT) \
-    OBJECT(Person, owner)                                              \
-    ARRAY_OBJECT(Person, people)
-
-MASON_STRUCT_DEFINE(Address, ADDRESS_FIELDS)
-MASON_STRUCT_DEFINE(Person, PERSON_FIELDS)
-MASON_STRUCT_DEFINE(Report, REPORT_FIELDS)
+#include "features.h"
 
 MASON_IMPL(Address, ADDRESS_FIELDS)
 MASON_IMPL(Person, PERSON_FIELDS)
 MASON_IMPL(Report, REPORT_FIELDS)
 
-char *mason_read_file_to_string(const char *path, size_t *out_len);
-
 int main(void) {
-    size_t json_len = 0;
-    char *json_str = mason_read_file_to_string("examples/data/features.json", &json_len);
-    if (!json_str) {
-        printf("Failed to read examples/data/features.json\n");
-        return 1;
-    }
-
     printf("Parsing features example...\n\n");
 
-    Report *report = Report_from_string_sized(json_str, json_len);
+    // Decoded straight from a read-only mapping of the file, no intermediate copy
+    Report *report = Report_from_file("examples/data/features.json");
     if (!report) {
-        printf("Parse failed: %s\n", mason_parse_error());
-        free(json_str);
+        printf("Failed to load examples/data/features.json\n");
         return 1;
     }
-    free(json_str);
 
     printf("Parsed struct:\n");
     Report_print(report);
@@ -79,6 +39,10 @@ int main(void) {
     if (round_trip)
         mason_delete(round_trip);
 
+    string direct = Report_to_string_direct(report);
+    printf("Direct JSON: %s\n", direct ? direct : "<write failed>");
+    Report_string_free(direct);
+
     Report_free(report);
 
     return 0;
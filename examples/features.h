@@ -0,0 +1,36 @@
+#ifndef MASON_EXAMPLES_FEATURES_H
+#define MASON_EXAMPLES_FEATURES_H
+
+#include "../mason.h"
+
+typedef enum {
+    STATUS_OK = 0,
+    STATUS_WARN = 1
+} Status;
+
+#define MASON_TYPE_ALIAS_Status int32_t
+
+#define ADDRESS_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, street)                                                      \
+    FIELD(int32_t, zip)
+
+#define PERSON_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    FIELD(string, name)                                                       \
+    FIELD(int64_t, id)                                                        \
+    FIELD(double, score)                                                      \
+    FIELD(bool, active)                                                       \
+    FIELD(Status, status)                                                     \
+    ARRAY(string, tags)                                                       \
+    OBJECT(Address, address)                                                  \
+    ARRAY_OBJECT(Address, history)                                            \
+    ARRAY_MULTI(raw)
+
+#define REPORT_FIELDS(FIELD, ARRAY, ARRAY_MULTI, OBJECT, ARRAY_OBJECT, UNION) \
+    OBJECT(Person, owner)                                                     \
+    ARRAY_OBJECT(Person, people)
+
+MASON_STRUCT_DEFINE(Address, ADDRESS_FIELDS)
+MASON_STRUCT_DEFINE(Person, PERSON_FIELDS)
+MASON_STRUCT_DEFINE(Report, REPORT_FIELDS)
+
+#endif // MASON_EXAMPLES_FEATURES_H
@@ -3,16 +3,21 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <cjson/cJSON.h>
 
+#include "mason_alloc.h"
+#include "mason_intern.h"
+#include "mason_simd.h"
+
 static char *_mason_strdup(const char *s) {
     if (!s)
         return NULL;
     size_t len = strlen(s) + 1;
-    char *p = malloc(len);
+    char *p = MASON_MALLOC(len);
     if (p)
         memcpy(p, s, len);
     return p;
@@ -21,6 +26,18 @@ static char *_mason_strdup(const char *s) {
 /* Type Definitions */
 
 typedef char *string;
+
+/* Borrowed string: points into the decoder's input instead of owning a copy,
+ * so it is never freed by Mason. See mason_read_string_view for which decoders
+ * can fill it.
+ */
+typedef const char *string_view;
+
+/* Shared string: the canonical copy from the intern table (see mason_intern.h),
+ * so equal values are the same pointer. Never freed per struct.
+ */
+typedef const char *interned;
+
 typedef cJSON *MASON_Parsed;
 
 /* Inline Parsing Helpers */
@@ -55,23 +72,100 @@ static inline const char *mason_parse_error(void) {
 #define _MASON_ARRAY_OBJECT(type, name) \
     type *name;                         \
     size_t name##_count;
+#define _MASON_UNION(tag, name, CASES) \
+    union {                            \
+        void *ptr;                     \
+        CASES(_MASON_UNION_MEMBER)     \
+    } name;
+#define _MASON_UNION_MEMBER(value, type, member) struct type *member;
 
 /* Struct Definition */
 
-#define MASON_STRUCT_DEFINE(struct_name, FIELDS)                                                       \
-    typedef struct struct_name {                                                                       \
-        FIELDS(_MASON_FIELD, _MASON_ARRAY, _MASON_ARRAY_MULTI_RAW, _MASON_OBJECT, _MASON_ARRAY_OBJECT) \
-    } struct_name;                                                                                     \
-                                                                                                       \
-    struct_name *struct_name##_from_json(MASON_Parsed json);                                           \
-    struct_name *struct_name##_from_string(const char *json_str);                                      \
-    struct_name *struct_name##_from_string_sized(const char *json_str, size_t len);                    \
-    MASON_Parsed struct_name##_to_json(struct_name *obj);                                              \
-    void struct_name##_free(struct_name *obj);                                                         \
-    void struct_name##_free_members(struct_name *obj);                                                 \
-    void struct_name##_free_json(MASON_Parsed json);                                                   \
-    string struct_name##_to_string(MASON_Parsed json);                                                 \
-    void struct_name##_string_free(string str);                                                        \
+#define MASON_STRUCT_DEFINE(struct_name, FIELDS)                                                                   \
+    typedef struct struct_name {                                                                                   \
+        FIELDS(_MASON_FIELD, _MASON_ARRAY, _MASON_ARRAY_MULTI_RAW, _MASON_OBJECT, _MASON_ARRAY_OBJECT,             \
+               _MASON_UNION)                                                                                       \
+    } struct_name;                                                                                                 \
+    typedef bool (*struct_name##_ndjson_callback)(struct_name *obj, size_t line, const char *error, void *ctx);    \
+    typedef struct {                                                                                               \
+        FIELDS(_MASON_INDEX_FIELD, _MASON_INDEX_FIELD, _MASON_INDEX_MULTI, _MASON_INDEX_FIELD, _MASON_INDEX_FIELD, \
+               _MASON_INDEX_UNION)                                                                                 \
+    } struct_name##_FieldIndex;                                                                                    \
+    typedef struct struct_name##_view {                                                                            \
+        struct_name obj;                                                                                           \
+        const char *src;                                                                                           \
+        size_t len;                                                                                                \
+        mason_view_slot slots[sizeof(struct_name##_FieldIndex)];                                                   \
+    } struct_name##_view;                                                                                          \
+    typedef struct struct_name##_decoder {                                                                         \
+        mason_push_decoder push;                                                                                   \
+    } struct_name##_decoder;                                                                                       \
+                                                                                                                   \
+    struct_name *struct_name##_from_json(MASON_Parsed json);                                                       \
+    bool struct_name##_from_json_into(struct_name *dst, MASON_Parsed json);                                        \
+    struct_name *struct_name##_from_json_masked(MASON_Parsed json, mason_field_mask mask);                         \
+    bool struct_name##_from_json_into_masked(struct_name *dst, MASON_Parsed json, mason_field_mask mask);          \
+    struct_name *struct_name##_from_string(const char *json_str);                                                  \
+    struct_name *struct_name##_from_string_sized(const char *json_str, size_t len);                                \
+    struct_name *struct_name##_from_string_masked(const char *json_str, mason_field_mask mask);                    \
+    struct_name *struct_name##_decode(const char *json_str, size_t len);                                           \
+    struct_name *struct_name##_decode_inplace(char *json_str, size_t len);                                         \
+    struct_name *struct_name##_from_file(const char *path);                                                        \
+    struct_name##_view *struct_name##_view_from_string(const char *json_str);                                      \
+    struct_name##_view *struct_name##_view_from_string_sized(const char *json_str, size_t len);                    \
+    struct_name *struct_name##_view_load(struct_name##_view *view, size_t field);                                  \
+    bool struct_name##_view_has(struct_name##_view *view, size_t field);                                           \
+    void *struct_name##_view_open(struct_name##_view *view, size_t field);                                         \
+    void struct_name##_view_free(struct_name##_view *view);                                                        \
+    struct_name *struct_name##_from_etf(const uint8_t *data, size_t len);                                          \
+    bool struct_name##_to_etf(struct_name *obj, mason_buf *out);                                                   \
+    bool struct_name##_etf_decode_term(struct_name *obj, mason_etf_reader *r);                                     \
+    bool struct_name##_etf_write_term(struct_name *obj, mason_buf *out);                                           \
+    size_t struct_name##_snapshot_size(struct_name *obj);                                                          \
+    size_t struct_name##_snapshot_write(struct_name *obj, void *buf, size_t cap);                                  \
+    struct_name *struct_name##_snapshot_load(void *image, size_t len);                                             \
+    struct_name *struct_name##_snapshot_from_file(const char *path, mason_file *file);                             \
+    size_t struct_name##_snapshot_extent(struct_name *obj);                                                        \
+    void struct_name##_snapshot_place(struct_name *dst, char *base, size_t *cursor);                               \
+    bool struct_name##_snapshot_fixup(struct_name *obj, char *base, size_t len, size_t depth);                     \
+    uint64_t struct_name##_snapshot_layout(size_t depth);                                                          \
+    mason_inflate_status struct_name##_inflate(mason_inflate_ctx *ctx, const uint8_t *frame, size_t len,           \
+                                               struct_name **out);                                                 \
+    bool struct_name##_decode_reader(struct_name *obj, mason_reader *r);                                           \
+    const mason_push_type *struct_name##_push_type(void);                                                          \
+    struct_name##_decoder *struct_name##_decoder_create(size_t budget);                                            \
+    mason_push_status struct_name##_decoder_feed(struct_name##_decoder *dec, const char *chunk, size_t len,        \
+                                                 size_t *consumed);                                                \
+    struct_name *struct_name##_decoder_finish(struct_name##_decoder *dec);                                         \
+    void struct_name##_decoder_free(struct_name##_decoder *dec);                                                   \
+    bool struct_name##_equal(const struct_name *a, const struct_name *b);                                          \
+    uint64_t struct_name##_hash(const struct_name *obj, uint64_t seed);                                            \
+    size_t struct_name##_diff(const struct_name *old, const struct_name *cur, mason_buf *out);                     \
+    bool struct_name##_apply_patch(struct_name *obj, const char *patch, size_t len);                               \
+    bool struct_name##_apply_reader(struct_name *obj, mason_reader *r);                                            \
+    struct_name *struct_name##_clone(const struct_name *obj);                                                      \
+    void struct_name##_clone_place(struct_name *dst, char *base, size_t *cursor);                                  \
+    void struct_name##_clone_free(struct_name *clone);                                                             \
+    struct_name *struct_name##_from_string_arena(mason_arena *arena, const char *json_str);                        \
+    struct_name *struct_name##_from_string_sized_arena(mason_arena *arena, const char *json_str, size_t len);      \
+    MASON_Parsed struct_name##_to_json(struct_name *obj);                                                          \
+    MASON_Parsed struct_name##_to_json_masked(struct_name *obj, mason_field_mask mask);                            \
+    void struct_name##_free(struct_name *obj);                                                                     \
+    void struct_name##_free_members(struct_name *obj);                                                             \
+    void struct_name##_free_json(MASON_Parsed json);                                                               \
+    string struct_name##_to_string(MASON_Parsed json);                                                             \
+    string struct_name##_to_string_compact(MASON_Parsed json);                                                     \
+    bool struct_name##_to_buffer(MASON_Parsed json, char *buf, size_t cap);                                        \
+    bool struct_name##_write(struct_name *obj, mason_buf *out);                                                    \
+    bool struct_name##_write_masked(struct_name *obj, mason_buf *out, mason_field_mask mask);                      \
+    string struct_name##_to_string_direct(struct_name *obj);                                                       \
+    size_t struct_name##_write_to_buffer(struct_name *obj, char *buf, size_t cap);                                 \
+    size_t struct_name##_serialized_size_hint(struct_name *obj);                                                   \
+    bool struct_name##_read_ndjson(FILE *fp, struct_name##_ndjson_callback cb, void *ctx);                         \
+    bool struct_name##_write_ndjson(FILE *fp, struct_name *obj, mason_buf *scratch);                               \
+    size_t struct_name##_decode_batch(const char **docs, const size_t *lens, size_t n, struct_name **out,          \
+                                      mason_pool *pool);                                                           \
+    void struct_name##_string_free(string str);                                                                    \
     void struct_name##_print(struct_name *obj);
 
 /* Type Resolution
@@ -87,43 +181,117 @@ static inline const char *mason_parse_error(void) {
 #define _MASON_TYPE_ALIAS(type)   _MASON_CONCAT(MASON_TYPE_ALIAS_, type)
 #define MASON_TYPE_HINT(type)     ((_MASON_TYPE_ALIAS(type))0)
 
-#define MASON_TYPE_ALIAS_int32_t  int32_t
-#define MASON_TYPE_ALIAS_int64_t  int64_t
-#define MASON_TYPE_ALIAS_double   double
-#define MASON_TYPE_ALIAS_string   string
-#define MASON_TYPE_ALIAS_bool     bool
-#define MASON_TYPE_ALIAS__Bool    bool
+/* interned has the same C type as string_view, so it dispatches through its own tag type */
+typedef const struct mason_interned_tag *mason_interned_t;
+
+#define MASON_TYPE_ALIAS_int32_t     int32_t
+#define MASON_TYPE_ALIAS_int64_t     int64_t
+#define MASON_TYPE_ALIAS_double      double
+#define MASON_TYPE_ALIAS_string      string
+#define MASON_TYPE_ALIAS_string_view string_view
+#define MASON_TYPE_ALIAS_interned    mason_interned_t
+#define MASON_TYPE_ALIAS_bool        bool
+#define MASON_TYPE_ALIAS__Bool       bool
 
 /* Inline Type Helpers */
 
+/* Integers
+ *
+ * A double only holds integers up to 2^53 exactly, which 64-bit IDs such as
+ * Discord snowflakes exceed, so integers are parsed straight from their digits.
+ * Returns the length of the integer at the start of [p, end), or 0 if there is
+ * none or it overflows int64_t or continues with a fraction or exponent; those
+ * are left to the double path.
+ */
+static inline size_t mason_parse_int64(const char *p, const char *end, int64_t *out) {
+    const char *s = p;
+    bool negative = s < end && *s == '-';
+    s += negative;
+    const char *digits = s;
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    uint64_t v = 0;
+    for (; s < end && *s >= '0' && *s <= '9'; s++) {
+        unsigned d = (unsigned)(*s - '0');
+        if (v > (limit - d) / 10)
+            return 0;
+        v = v * 10 + d;
+    }
+    if (s == digits || (s < end && (*s == '.' || *s == 'e' || *s == 'E')))
+        return 0;
+    *out = negative ? (int64_t)(0 - v) : (int64_t)v;
+    return (size_t)(s - p);
+}
+
+/* IDs are often sent as strings ("1234"), which count when they hold nothing but an integer */
+static inline bool _mason_text_int64(const char *s, int64_t *out) {
+    size_t len = s ? strlen(s) : 0;
+    return len && mason_parse_int64(s, s + len, out) == len;
+}
+
+/* Saturates instead of the undefined out-of-range conversion */
+static inline int64_t _mason_double_int64(double d) {
+    return d >= 0x1p63 ? INT64_MAX : d <= -0x1p63 ? INT64_MIN : (int64_t)d;
+}
+
 /* Type checkers */
 static inline bool mason_is_int32(MASON_Parsed item) { return cJSON_IsNumber(item); }
-static inline bool mason_is_int64(MASON_Parsed item) { return cJSON_IsNumber(item); }
+static inline bool mason_is_int64(MASON_Parsed item) {
+    int64_t v;
+    /* Raw nodes come from mason_create_int64 */
+    if (cJSON_IsNumber(item))
+        return true;
+    return (cJSON_IsString(item) || cJSON_IsRaw(item)) && _mason_text_int64(item->valuestring, &v);
+}
 static inline bool mason_is_double(MASON_Parsed item) { return cJSON_IsNumber(item); }
 static inline bool mason_is_string(MASON_Parsed item) { return cJSON_IsString(item) && item->valuestring; }
+static inline bool mason_is_string_view(MASON_Parsed item) { return mason_is_string(item); }
+static inline bool mason_is_interned(MASON_Parsed item) { return mason_is_string(item); }
 static inline bool mason_is_bool(MASON_Parsed item) { return cJSON_IsBool(item); }
 
 /* Non-owning value getters */
 static inline int32_t mason_get_int32(MASON_Parsed item) { return (int32_t)item->valueint; }
-static inline int64_t mason_get_int64(MASON_Parsed item) { return (int64_t)item->valuedouble; }
+static inline int64_t mason_get_int64(MASON_Parsed item) {
+    int64_t v;
+    if (!cJSON_IsNumber(item) && _mason_text_int64(item->valuestring, &v))
+        return v;
+    return _mason_double_int64(item->valuedouble);
+}
 static inline double mason_get_double(MASON_Parsed item) { return item->valuedouble; }
 static inline const char *mason_get_string(MASON_Parsed item) { return item->valuestring; }
+static inline const char *mason_get_interned(MASON_Parsed item) { return item->valuestring; }
 static inline bool mason_get_bool(MASON_Parsed item) { return cJSON_IsTrue(item); }
 
 /* Owning getters
  * NOTE: strdup for strings, passthrough for primitives
  */
 static inline int32_t mason_get_owned_int32(MASON_Parsed item) { return (int32_t)item->valueint; }
-static inline int64_t mason_get_owned_int64(MASON_Parsed item) { return (int64_t)item->valuedouble; }
+static inline int64_t mason_get_owned_int64(MASON_Parsed item) { return mason_get_int64(item); }
 static inline double mason_get_owned_double(MASON_Parsed item) { return item->valuedouble; }
 static inline char *mason_get_owned_string(MASON_Parsed item) { return _mason_strdup(item->valuestring); }
+/* The tree is usually deleted right after _from_json, so there is nothing to borrow; the parser fails on
+ * string_view values before getting here */
+static inline const char *mason_get_owned_string_view(MASON_Parsed item) {
+    (void)item;
+    return NULL;
+}
+static inline const char *mason_get_owned_interned(MASON_Parsed item) {
+    return mason_intern(item->valuestring, strlen(item->valuestring));
+}
 static inline bool mason_get_owned_bool(MASON_Parsed item) { return cJSON_IsTrue(item); }
 
 /* JSON node creators */
 static inline MASON_Parsed mason_create_int32(int32_t v) { return cJSON_CreateNumber(v); }
-static inline MASON_Parsed mason_create_int64(int64_t v) { return cJSON_CreateNumber((double)v); }
+/* Past 2^53 a number node would round, so those values keep their digits as a raw node */
+static inline MASON_Parsed mason_create_int64(int64_t v) {
+    if (v >= -(INT64_C(1) << 53) && v <= INT64_C(1) << 53)
+        return cJSON_CreateNumber((double)v);
+    char digits[24];
+    snprintf(digits, sizeof(digits), "%lld", (long long)v);
+    return cJSON_CreateRaw(digits);
+}
 static inline MASON_Parsed mason_create_double(double v) { return cJSON_CreateNumber(v); }
 static inline MASON_Parsed mason_create_string(const char *v) { return v ? cJSON_CreateString(v) : cJSON_CreateNull(); }
+static inline MASON_Parsed mason_create_interned(mason_interned_t v) { return mason_create_string((const char *)v); }
 static inline MASON_Parsed mason_create_bool(bool v) { return cJSON_CreateBool(v); }
 
 /* Field memory free
@@ -132,33 +300,43 @@ static inline MASON_Parsed mason_create_bool(bool v) { return cJSON_CreateBool(v
 static inline void mason_free_int32(int32_t v) { (void)v; }
 static inline void mason_free_int64(int64_t v) { (void)v; }
 static inline void mason_free_double(double v) { (void)v; }
-static inline void mason_free_string(char *s) { free(s); }
+static inline void mason_free_string(char *s) { MASON_FREE(s); }
+static inline void mason_free_string_view(const char *s) { (void)s; }
+static inline void mason_free_interned(mason_interned_t s) { (void)s; }
 static inline void mason_free_bool(bool v) { (void)v; }
 
 /* Array memory free */
 static inline void mason_free_array_int32(int32_t *arr, size_t count) {
     (void)count;
-    free(arr);
+    MASON_FREE(arr);
 }
 static inline void mason_free_array_int64(int64_t *arr, size_t count) {
     (void)count;
-    free(arr);
+    MASON_FREE(arr);
 }
 static inline void mason_free_array_double(double *arr, size_t count) {
     (void)count;
-    free(arr);
+    MASON_FREE(arr);
 }
 static inline void mason_free_array_bool(bool *arr, size_t count) {
     (void)count;
-    free(arr);
+    MASON_FREE(arr);
 }
 static inline void mason_free_array_string(char **arr, size_t count) {
     if (arr) {
         for (size_t i = 0; i < count; i++)
-            free(arr[i]);
-        free(arr);
+            MASON_FREE(arr[i]);
+        MASON_FREE(arr);
     }
 }
+static inline void mason_free_array_string_view(const char **arr, size_t count) {
+    (void)count;
+    MASON_FREE((void *)arr);
+}
+static inline void mason_free_array_interned(mason_interned_t *arr, size_t count) {
+    (void)count;
+    MASON_FREE((void *)arr);
+}
 
 /* _Generic Dispatch Macros */
 
@@ -167,6 +345,8 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     int64_t: mason_is_int64,                            \
     double: mason_is_double,                            \
     char *: mason_is_string,                            \
+    const char *: mason_is_string_view,                 \
+    mason_interned_t: mason_is_interned,                \
     _Bool: mason_is_bool)(item)
 
 #define mason_get(item, type_hint) _Generic((type_hint), \
@@ -174,6 +354,8 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     int64_t: mason_get_int64,                            \
     double: mason_get_double,                            \
     char *: mason_get_string,                            \
+    const char *: mason_get_string,                      \
+    mason_interned_t: mason_get_interned,                \
     _Bool: mason_get_bool)(item)
 
 #define mason_get_owned(item, type_hint) _Generic((type_hint), \
@@ -181,6 +363,8 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     int64_t: mason_get_owned_int64,                            \
     double: mason_get_owned_double,                            \
     char *: mason_get_owned_string,                            \
+    const char *: mason_get_owned_string_view,                 \
+    mason_interned_t: mason_get_owned_interned,                \
     _Bool: mason_get_owned_bool)(item)
 
 #define mason_create(value) _Generic((value), \
@@ -189,6 +373,7 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     double: mason_create_double,              \
     char *: mason_create_string,              \
     const char *: mason_create_string,        \
+    mason_interned_t: mason_create_interned,  \
     _Bool: mason_create_bool)(value)
 
 #define mason_free_field(value) _Generic((value), \
@@ -196,6 +381,8 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     int64_t: mason_free_int64,                    \
     double: mason_free_double,                    \
     char *: mason_free_string,                    \
+    const char *: mason_free_string_view,         \
+    mason_interned_t: mason_free_interned,        \
     _Bool: mason_free_bool)(value)
 
 #define mason_free_array(arr, count) _Generic((arr), \
@@ -203,58 +390,224 @@ static inline void mason_free_array_string(char **arr, size_t count) {
     int64_t *: mason_free_array_int64,               \
     double *: mason_free_array_double,               \
     char **: mason_free_array_string,                \
+    const char **: mason_free_array_string_view,     \
+    mason_interned_t *: mason_free_array_interned,   \
     _Bool *: mason_free_array_bool)(arr, count)
 
-/* Parsing Implementation */
+/* Field Masks
+ *
+ * A mask selects fields by their index in Foo_FieldIndex, one bit per field:
+ *
+ *   mason_field_mask m = MASON_MASK(Presence, status) | MASON_MASK(Presence, activities);
+ *   Presence *p = Presence_from_string_masked(json, m); // other keys are skipped unread
+ *   MASON_Parsed update = Presence_to_json_masked(p, m); // and other members aren't emitted
+ *
+ * Masks apply to the outermost struct; a selected OBJECT or ARRAY_OBJECT is
+ * handled whole. A UNION is only decoded when its tag is selected too. Fields
+ * past the 64th have no bit and are always included.
+ *
+ * Mask checks expect `_mason_mask` and a `_mason_fields` typedef of Foo_FieldIndex in scope.
+ */
 
-#define _MASON_PARSE_FIELD(type, name)                            \
-    item = cJSON_GetObjectItemCaseSensitive(json, #name);         \
-    if (mason_is(item, MASON_TYPE_HINT(type))) {                  \
-        obj->name = mason_get_owned(item, MASON_TYPE_HINT(type)); \
-    }
+typedef uint64_t mason_field_mask;
 
-#define _MASON_PARSE_ARRAY_PRIM(type, name)                                      \
-    item = cJSON_GetObjectItemCaseSensitive(json, #name);                        \
-    if (cJSON_IsArray(item)) {                                                   \
-        obj->name##_count = (size_t)cJSON_GetArraySize(item);                    \
-        obj->name = (type *)calloc(obj->name##_count, sizeof(type));             \
-        if (obj->name) {                                                         \
-            for (size_t i = 0; i < obj->name##_count; i++) {                     \
-                MASON_Parsed elem = cJSON_GetArrayItem(item, (int)i);            \
-                if (mason_is(elem, MASON_TYPE_HINT(type))) {                     \
-                    obj->name[i] = mason_get_owned(elem, MASON_TYPE_HINT(type)); \
-                }                                                                \
-            }                                                                    \
-        } else {                                                                 \
-            obj->name##_count = 0;                                               \
-        }                                                                        \
+#define MASON_FIELDS_ALL               (~(mason_field_mask)0)
+#define _MASON_MASK_BIT(index)         ((index) < 64 ? (mason_field_mask)1 << ((index) & 63) : 0)
+#define MASON_MASK(struct_name, field) _MASON_MASK_BIT(offsetof(struct_name##_FieldIndex, field))
+
+#define _MASON_MASK_HAS(name) \
+    (offsetof(_mason_fields, name) >= 64 || (_mason_mask & _MASON_MASK_BIT(offsetof(_mason_fields, name))))
+#define _MASON_MASKED(name, code) \
+    if (_MASON_MASK_HAS(name)) {  \
+        code                      \
     }
 
-#define _MASON_PARSE_OBJECT(type, name)                   \
-    item = cJSON_GetObjectItemCaseSensitive(json, #name); \
-    if (cJSON_IsObject(item)) {                           \
-        obj->name = type##_from_json(item);               \
+/* Key Dispatch
+ *
+ * Objects are walked once and each key is routed to its field by a chain of
+ * `else if`s generated from FIELDS. Every link first compares a (length, first
+ * byte) tag against a compile-time constant, so keys that aren't declared cost
+ * one integer compare per field and memcmp only runs on a probable hit.
+ * Like cJSON_GetObjectItemCaseSensitive, the first occurrence of a duplicate
+ * key wins and later ones are ignored.
+ *
+ * Expects `_mason_key`, `_mason_key_len` and `_mason_tag` in scope.
+ */
+
+#define _MASON_KEY_TAG(len, first) (((size_t)(len) << 8) | (unsigned char)(first))
+
+static inline size_t _mason_key_tag(const char *key, size_t len) {
+    return _MASON_KEY_TAG(len, len ? key[0] : 0);
+}
+
+#define _MASON_KEY_MATCH(name)                                    \
+    (_mason_tag == _MASON_KEY_TAG(sizeof(#name) - 1, #name[0]) && \
+     memcmp(_mason_key, #name, sizeof(#name) - 1) == 0)
+
+static inline bool _mason_first_seen(bool *seen) {
+    if (*seen)
+        return false;
+    *seen = true;
+    return true;
+}
+
+#define _MASON_KEY_SEEN(type, name) bool _mason_seen_##name = false;
+#define _MASON_KEY_SEEN_MULTI(name) bool _mason_seen_##name = false;
+#define _MASON_KEY_SEEN_UNION(tag, name, CASES) bool _mason_seen_##name = false;
+
+/* A field outside the mask starts out seen, so its key falls through to the skip */
+#define _MASON_KEY_SEEN_MASKED(type, name) bool _mason_seen_##name = !_MASON_MASK_HAS(name);
+#define _MASON_KEY_SEEN_MASKED_MULTI(name) bool _mason_seen_##name = !_MASON_MASK_HAS(name);
+#define _MASON_KEY_SEEN_MASKED_UNION(tag, name, CASES) \
+    bool _mason_seen_##name = !(_MASON_MASK_HAS(name) && _MASON_MASK_HAS(tag));
+
+/* A FIELD also records whether its value decoded; a UNION only follows a tag that did */
+#define _MASON_KEY_SEEN_FIELD(type, name)                       \
+    bool _mason_seen_##name = false, _mason_set_##name = false; \
+    (void)_mason_set_##name;
+#define _MASON_KEY_SEEN_MASKED_FIELD(type, name)                                 \
+    bool _mason_seen_##name = !_MASON_MASK_HAS(name), _mason_set_##name = false; \
+    (void)_mason_set_##name;
+
+#define _MASON_KEY_CASE(name) \
+    else if (_MASON_KEY_MATCH(name) && _mason_first_seen(&_mason_seen_##name))
+
+/* Discriminated Unions
+ *
+ * UNION(tag, name, CASES) holds one of several structs, picked by the value of
+ * the FIELD `tag` in the same struct. CASES is an X-macro of (value, type,
+ * member) entries:
+ *
+ *   #define GATEWAY_PAYLOADS(CASE) CASE(2, IdentifyEventData, identify) CASE(10, HelloEventData, hello)
+ *   ... FIELD(int32_t, op) UNION(op, d, GATEWAY_PAYLOADS)
+ *
+ * The field is a union of pointers, one member per case (`payload->d.hello`),
+ * plus `ptr` for untyped access; it is NULL when the tag matches no case or is
+ * missing, null or of the wrong type. Parsing, serializing and freeing all select the case from the tag's
+ * current value, so set the tag and the member together. Number tags compare
+ * with ==, string tags with strcmp, and the tag may come before or after the
+ * union in the input.
+ *
+ * Dispatch expects `obj` in scope and brings the member as `_mason_union_ptr`
+ * (a void **) and its key as `_mason_union_name` into scope for the cases.
+ */
+
+typedef struct {
+    const char *str;
+    int64_t num;
+    bool is_str;
+} _mason_union_key;
+
+static inline _mason_union_key _mason_union_key_num(int64_t num) {
+    return (_mason_union_key){NULL, num, false};
+}
+
+static inline _mason_union_key _mason_union_key_str(const char *str) {
+    return (_mason_union_key){str, 0, true};
+}
+
+static inline bool _mason_union_match(_mason_union_key tag, _mason_union_key value) {
+    if (tag.is_str != value.is_str)
+        return false;
+    return tag.is_str ? tag.str && strcmp(tag.str, value.str) == 0 : tag.num == value.num;
+}
+
+#define _MASON_UNION_KEY(v) \
+    _Generic((v), char *: _mason_union_key_str, const char *: _mason_union_key_str, default: _mason_union_key_num)(v)
+
+#define _MASON_UNION_SWITCH(tag, name)                              \
+    _mason_union_key _mason_union_tag = _MASON_UNION_KEY(obj->tag); \
+    void **_mason_union_ptr = &obj->name.ptr;                       \
+    const char *_mason_union_name = #name;                          \
+    (void)_mason_union_ptr;                                         \
+    (void)_mason_union_name;                                        \
+    if (0) {                                                        \
     }
 
-#define _MASON_PARSE_ARRAY_OBJECT(type, name)                         \
-    item = cJSON_GetObjectItemCaseSensitive(json, #name);             \
-    if (cJSON_IsArray(item)) {                                        \
-        obj->name##_count = (size_t)cJSON_GetArraySize(item);         \
-        obj->name = (type *)calloc(obj->name##_count, sizeof(type));  \
-        if (obj->name) {                                              \
-            for (size_t i = 0; i < obj->name##_count; i++) {          \
-                MASON_Parsed elem = cJSON_GetArrayItem(item, (int)i); \
-                type *parsed = type##_from_json(elem);                \
-                if (parsed) {                                         \
-                    obj->name[i] = *parsed;                           \
-                    free(parsed);                                     \
-                }                                                     \
-            }                                                         \
-        } else {                                                      \
-            obj->name##_count = 0;                                    \
+#define _MASON_UNION_CASE(value) else if (_mason_union_match(_mason_union_tag, _MASON_UNION_KEY(value)))
+
+/* Parsing Implementation
+ * NOTE: `item` is the member whose key matched
+ */
+
+/* Whether a value of this type can be kept without borrowing; a string_view fails the parse */
+#define _MASON_OWNABLE(type) _Generic(MASON_TYPE_HINT(type), const char *: false, default: true)
+
+#define _MASON_PARSE_FIELD(type, name)                                \
+    _MASON_KEY_CASE(name) {                                           \
+        if (mason_is(item, MASON_TYPE_HINT(type))) {                  \
+            if (!_MASON_OWNABLE(type))                                \
+                return false;                                         \
+            obj->name = mason_get_owned(item, MASON_TYPE_HINT(type)); \
+            _mason_set_##name = true;                                 \
         }                                                             \
     }
 
+/* Arrays walk the element list once, cJSON_GetArrayItem would restart from the head every time */
+
+#define _MASON_PARSE_ARRAY_PRIM(type, name)                                          \
+    _MASON_KEY_CASE(name) {                                                          \
+        if (cJSON_IsArray(item)) {                                                   \
+            obj->name##_count = (size_t)cJSON_GetArraySize(item);                    \
+            obj->name = (type *)MASON_CALLOC(obj->name##_count, sizeof(type));       \
+            if (obj->name) {                                                         \
+                size_t i = 0;                                                        \
+                MASON_Parsed elem = NULL;                                            \
+                cJSON_ArrayForEach(elem, item) {                                     \
+                    if (mason_is(elem, MASON_TYPE_HINT(type))) {                     \
+                        if (!_MASON_OWNABLE(type))                                   \
+                            return false;                                            \
+                        obj->name[i] = mason_get_owned(elem, MASON_TYPE_HINT(type)); \
+                    }                                                                \
+                    i++;                                                             \
+                }                                                                    \
+            } else {                                                                 \
+                obj->name##_count = 0;                                               \
+            }                                                                        \
+        }                                                                            \
+    }
+
+#define _MASON_PARSE_OBJECT(type, name)                                      \
+    _MASON_KEY_CASE(name) {                                                  \
+        if (cJSON_IsObject(item) && !(obj->name = type##_from_json(item))) { \
+            return false;                                                    \
+        }                                                                    \
+    }
+
+#define _MASON_PARSE_ARRAY_OBJECT(type, name)                                  \
+    _MASON_KEY_CASE(name) {                                                    \
+        if (cJSON_IsArray(item)) {                                             \
+            obj->name##_count = (size_t)cJSON_GetArraySize(item);              \
+            obj->name = (type *)MASON_CALLOC(obj->name##_count, sizeof(type)); \
+            if (obj->name) {                                                   \
+                size_t i = 0;                                                  \
+                MASON_Parsed elem = NULL;                                      \
+                cJSON_ArrayForEach(elem, item) {                               \
+                    if (!type##_from_json_into(&obj->name[i++], elem))         \
+                        return false;                                          \
+                }                                                              \
+            } else {                                                           \
+                obj->name##_count = 0;                                         \
+            }                                                                  \
+        }                                                                      \
+    }
+
+/* Unions are resolved after the member loop, once the tag has been parsed */
+#define _MASON_PARSE_UNION_CASE(value, type, member)       \
+    _MASON_UNION_CASE(value) {                             \
+        if (!(*_mason_union_ptr = type##_from_json(item))) \
+            return false;                                  \
+    }
+
+#define _MASON_PARSE_UNION(tag, name, CASES)                               \
+    if (_MASON_MASK_HAS(name) && _MASON_MASK_HAS(tag)) {                   \
+        MASON_Parsed item = cJSON_GetObjectItemCaseSensitive(json, #name); \
+        if (cJSON_IsObject(item) && _mason_set_##tag) {                    \
+            _MASON_UNION_SWITCH(tag, name)                                 \
+            CASES(_MASON_PARSE_UNION_CASE)                                 \
+        }                                                                  \
+    }
+
 /* Serialization Implementation */
 
 #define _MASON_SERIALIZE_FIELD(type, name) \
@@ -290,6 +643,20 @@ static inline void mason_free_array_string(char **arr, size_t count) {
         cJSON_AddItemToObject(json, #name, arr);                 \
     }
 
+#define _MASON_SERIALIZE_UNION_CASE(value, type, member)                 \
+    _MASON_UNION_CASE(value) {                                           \
+        MASON_Parsed nested = type##_to_json((type *)*_mason_union_ptr); \
+        if (nested) {                                                    \
+            cJSON_AddItemToObject(json, _mason_union_name, nested);      \
+        }                                                                \
+    }
+
+#define _MASON_SERIALIZE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                         \
+        _MASON_UNION_SWITCH(tag, name)           \
+        CASES(_MASON_SERIALIZE_UNION_CASE)       \
+    }
+
 /* Memory Management */
 
 #define _MASON_FREE_FIELD_DISPATCH(type, name) mason_free_field((_MASON_TYPE_ALIAS(type))obj->name);
@@ -305,7 +672,19 @@ static inline void mason_free_array_string(char **arr, size_t count) {
         for (size_t i = 0; i < obj->name##_count; i++) { \
             type##_free_members(&obj->name[i]);          \
         }                                                \
-        free(obj->name);                                 \
+        MASON_FREE(obj->name);                           \
+    }
+
+/* Unions are freed before the other fields, which may include a string tag */
+#define _MASON_FREE_UNION_CASE(value, type, member) \
+    _MASON_UNION_CASE(value) {                      \
+        type##_free((type *)*_mason_union_ptr);     \
+    }
+
+#define _MASON_FREE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                    \
+        _MASON_UNION_SWITCH(tag, name)      \
+        CASES(_MASON_FREE_UNION_CASE)       \
     }
 
 /* X-Macro Expansion Helpers */
@@ -315,87 +694,181 @@ static inline void mason_free_array_string(char **arr, size_t count) {
 #define _MASON_EXPAND_STRUCT_ARRAY_MULTI(name)           _MASON_ARRAY_MULTI_RAW(name)
 #define _MASON_EXPAND_STRUCT_OBJECT(type, name)          _MASON_OBJECT(type, name)
 #define _MASON_EXPAND_STRUCT_ARRAY_OBJECT(type, name)    _MASON_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_STRUCT_UNION(tag, name, CASES)     _MASON_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_KEY_SEEN(type, name)               _MASON_KEY_SEEN(type, name)
+#define _MASON_EXPAND_KEY_SEEN_FIELD(type, name)         _MASON_KEY_SEEN_FIELD(type, name)
+#define _MASON_EXPAND_KEY_SEEN_MULTI(name)               _MASON_KEY_SEEN_MULTI(name)
+#define _MASON_EXPAND_KEY_SEEN_UNION(tag, name, CASES)   _MASON_KEY_SEEN_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_NONE(type, name)
+#define _MASON_EXPAND_NONE_MULTI(name)
+#define _MASON_EXPAND_NONE_UNION(tag, name, CASES)
 
 #define _MASON_EXPAND_PARSE_FIELD(type, name)            _MASON_PARSE_FIELD(type, name)
 #define _MASON_EXPAND_PARSE_ARRAY(type, name)            _MASON_PARSE_ARRAY_PRIM(type, name)
 #define _MASON_EXPAND_PARSE_ARRAY_MULTI(name)            _MASON_PARSE_ARRAY_MULTI(name)
 #define _MASON_EXPAND_PARSE_OBJECT(type, name)           _MASON_PARSE_OBJECT(type, name)
 #define _MASON_EXPAND_PARSE_ARRAY_OBJECT(type, name)     _MASON_PARSE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_PARSE_UNION(tag, name, CASES)      _MASON_PARSE_UNION(tag, name, CASES)
 
-#define _MASON_EXPAND_SERIALIZE_FIELD(type, name)        _MASON_SERIALIZE_FIELD(type, name)
-#define _MASON_EXPAND_SERIALIZE_ARRAY(type, name)        _MASON_SERIALIZE_ARRAY_PRIM(type, name)
-#define _MASON_EXPAND_SERIALIZE_ARRAY_MULTI(name)        _MASON_SERIALIZE_ARRAY_MULTI(name)
-#define _MASON_EXPAND_SERIALIZE_OBJECT(type, name)       _MASON_SERIALIZE_OBJECT(type, name)
-#define _MASON_EXPAND_SERIALIZE_ARRAY_OBJECT(type, name) _MASON_SERIALIZE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_SERIALIZE_FIELD(type, name)        _MASON_MASKED(name, _MASON_SERIALIZE_FIELD(type, name))
+#define _MASON_EXPAND_SERIALIZE_ARRAY(type, name)        _MASON_MASKED(name, _MASON_SERIALIZE_ARRAY_PRIM(type, name))
+#define _MASON_EXPAND_SERIALIZE_ARRAY_MULTI(name)        _MASON_MASKED(name, _MASON_SERIALIZE_ARRAY_MULTI(name))
+#define _MASON_EXPAND_SERIALIZE_OBJECT(type, name)       _MASON_MASKED(name, _MASON_SERIALIZE_OBJECT(type, name))
+#define _MASON_EXPAND_SERIALIZE_ARRAY_OBJECT(type, name) _MASON_MASKED(name, _MASON_SERIALIZE_ARRAY_OBJECT(type, name))
+#define _MASON_EXPAND_SERIALIZE_UNION(tag, name, CASES)  _MASON_MASKED(name, _MASON_SERIALIZE_UNION(tag, name, CASES))
 
 #define _MASON_EXPAND_FREE_FIELD(type, name)             _MASON_FREE_FIELD_DISPATCH(type, name)
 #define _MASON_EXPAND_FREE_ARRAY(type, name)             _MASON_FREE_ARRAY_DISPATCH(type, name)
 #define _MASON_EXPAND_FREE_ARRAY_MULTI(name)             _MASON_FREE_ARRAY_MULTI(name)
 #define _MASON_EXPAND_FREE_OBJECT(type, name)            _MASON_FREE_OBJECT(type, name)
 #define _MASON_EXPAND_FREE_ARRAY_OBJECT(type, name)      _MASON_FREE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_FREE_UNION(tag, name, CASES)       _MASON_FREE_UNION(tag, name, CASES)
+
+/* Direct writer support */
+#include "mason_write.h"
+
+/* Arena support */
+#include "mason_arena.h"
+
+/* Single-pass decode support */
+#include "mason_decode.h"
+
+/* NDJSON streaming support */
+#include "mason_ndjson.h"
+
+/* Thread pool and batch decode support */
+#include "mason_pool.h"
+
+/* Memory-mapped file support */
+#include "mason_file.h"
+
+/* Lazy view support */
+#include "mason_view.h"
 
 /* Multi array support */
 #include "mason_multi.h"
 
+/* Erlang External Term Format support */
+#include "mason_etf.h"
+
+/* Flat snapshot support */
+#include "mason_snapshot.h"
+
+/* zlib-stream transport support */
+#include "mason_zlib.h"
+
+/* Push decoder support */
+#include "mason_push.h"
+
+/* Equality and hashing support */
+#include "mason_hash.h"
+
+/* Struct diff and merge patch support */
+#include "mason_diff.h"
+
+/* Single-block clone support */
+#include "mason_clone.h"
+
 /* Print support */
 #include "mason_print.h"
 
 /* Main Implementation Macros */
 
 #define _MASON_IMPL_BASE(struct_name, FIELDS)                                                                     \
-    struct_name *struct_name##_from_json(MASON_Parsed json) {                                                     \
+    bool struct_name##_from_json_into_masked(struct_name *obj, MASON_Parsed json, mason_field_mask mask) {        \
+        typedef struct_name##_FieldIndex _mason_fields;                                                           \
+        const mason_field_mask _mason_mask = mask;                                                                \
+        if (!obj || !json)                                                                                        \
+            return false;                                                                                         \
+        memset(obj, 0, sizeof(struct_name));                                                                      \
+        FIELDS(_MASON_KEY_SEEN_MASKED_FIELD, _MASON_KEY_SEEN_MASKED, _MASON_KEY_SEEN_MASKED_MULTI,                \
+               _MASON_KEY_SEEN_MASKED, _MASON_KEY_SEEN_MASKED, _MASON_EXPAND_NONE_UNION)                          \
+        MASON_Parsed item = NULL;                                                                                 \
+        cJSON_ArrayForEach(item, json) {                                                                          \
+            const char *_mason_key = item->string;                                                                \
+            if (!_mason_key)                                                                                      \
+                continue;                                                                                         \
+            size_t _mason_key_len = strlen(_mason_key);                                                           \
+            size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                       \
+            if (0) {                                                                                              \
+            }                                                                                                     \
+            FIELDS(_MASON_EXPAND_PARSE_FIELD, _MASON_EXPAND_PARSE_ARRAY, _MASON_EXPAND_PARSE_ARRAY_MULTI,         \
+                   _MASON_EXPAND_PARSE_OBJECT, _MASON_EXPAND_PARSE_ARRAY_OBJECT, _MASON_EXPAND_NONE_UNION)        \
+        }                                                                                                         \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,              \
+               _MASON_EXPAND_NONE, _MASON_EXPAND_PARSE_UNION)                                                     \
+        return true;                                                                                              \
+    }                                                                                                             \
+                                                                                                                  \
+    bool struct_name##_from_json_into(struct_name *obj, MASON_Parsed json) {                                      \
+        return struct_name##_from_json_into_masked(obj, json, MASON_FIELDS_ALL);                                  \
+    }                                                                                                             \
+                                                                                                                  \
+    struct_name *struct_name##_from_json_masked(MASON_Parsed json, mason_field_mask mask) {                       \
         if (!json)                                                                                                \
             return NULL;                                                                                          \
-        struct_name *obj = (struct_name *)calloc(1, sizeof(struct_name));                                         \
+        struct_name *obj = (struct_name *)MASON_MALLOC(sizeof(struct_name));                                      \
         if (!obj)                                                                                                 \
             return NULL;                                                                                          \
-        MASON_Parsed item = NULL;                                                                                 \
-        FIELDS(_MASON_EXPAND_PARSE_FIELD, _MASON_EXPAND_PARSE_ARRAY, _MASON_EXPAND_PARSE_ARRAY_MULTI,             \
-               _MASON_EXPAND_PARSE_OBJECT, _MASON_EXPAND_PARSE_ARRAY_OBJECT)                                      \
+        if (!struct_name##_from_json_into_masked(obj, json, mask)) {                                              \
+            struct_name##_free(obj);                                                                              \
+            return NULL;                                                                                          \
+        }                                                                                                         \
         return obj;                                                                                               \
     }                                                                                                             \
                                                                                                                   \
+    struct_name *struct_name##_from_json(MASON_Parsed json) {                                                     \
+        return struct_name##_from_json_masked(json, MASON_FIELDS_ALL);                                            \
+    }                                                                                                             \
+                                                                                                                  \
     struct_name *struct_name##_from_string(const char *json_str) {                                                \
-        MASON_Parsed parsed = mason_parse(json_str);                                                              \
-        if (!parsed)                                                                                              \
+        if (!json_str)                                                                                            \
             return NULL;                                                                                          \
-        struct_name *obj = struct_name##_from_json(parsed);                                                       \
-        mason_delete(parsed);                                                                                     \
-        return obj;                                                                                               \
+        return struct_name##_from_string_sized(json_str, strlen(json_str));                                       \
     }                                                                                                             \
                                                                                                                   \
+    /* Single pass, so int64_t values keep the digits a cJSON tree rounds to a double */                          \
     struct_name *struct_name##_from_string_sized(const char *json_str, size_t len) {                              \
-        MASON_Parsed parsed = mason_parse_sized(json_str, len);                                                   \
-        if (!parsed)                                                                                              \
-            return NULL;                                                                                          \
-        struct_name *obj = struct_name##_from_json(parsed);                                                       \
-        mason_delete(parsed);                                                                                     \
+        struct_name *obj = struct_name##_decode(json_str, len);                                                   \
+        if (!obj && json_str)                                                                                     \
+            mason_delete(mason_parse_sized(json_str, len)); /* leaves mason_parse_error() at the bad byte */      \
         return obj;                                                                                               \
     }                                                                                                             \
                                                                                                                   \
-    MASON_Parsed struct_name##_to_json(struct_name *obj) {                                                        \
+    MASON_Parsed struct_name##_to_json_masked(struct_name *obj, mason_field_mask mask) {                          \
+        typedef struct_name##_FieldIndex _mason_fields;                                                           \
+        const mason_field_mask _mason_mask = mask;                                                                \
         if (!obj)                                                                                                 \
             return NULL;                                                                                          \
         MASON_Parsed json = cJSON_CreateObject();                                                                 \
         if (!json)                                                                                                \
             return NULL;                                                                                          \
         FIELDS(_MASON_EXPAND_SERIALIZE_FIELD, _MASON_EXPAND_SERIALIZE_ARRAY, _MASON_EXPAND_SERIALIZE_ARRAY_MULTI, \
-               _MASON_EXPAND_SERIALIZE_OBJECT, _MASON_EXPAND_SERIALIZE_ARRAY_OBJECT)                              \
+               _MASON_EXPAND_SERIALIZE_OBJECT, _MASON_EXPAND_SERIALIZE_ARRAY_OBJECT,                              \
+               _MASON_EXPAND_SERIALIZE_UNION)                                                                     \
         return json;                                                                                              \
     }                                                                                                             \
                                                                                                                   \
+    MASON_Parsed struct_name##_to_json(struct_name *obj) {                                                        \
+        return struct_name##_to_json_masked(obj, MASON_FIELDS_ALL);                                               \
+    }                                                                                                             \
+                                                                                                                  \
     void struct_name##_free_members(struct_name *obj) {                                                           \
         if (!obj)                                                                                                 \
             return;                                                                                               \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,              \
+               _MASON_EXPAND_NONE, _MASON_EXPAND_FREE_UNION)                                                      \
         FIELDS(_MASON_EXPAND_FREE_FIELD, _MASON_EXPAND_FREE_ARRAY, _MASON_EXPAND_FREE_ARRAY_MULTI,                \
-               _MASON_EXPAND_FREE_OBJECT, _MASON_EXPAND_FREE_ARRAY_OBJECT)                                        \
+               _MASON_EXPAND_FREE_OBJECT, _MASON_EXPAND_FREE_ARRAY_OBJECT, _MASON_EXPAND_NONE_UNION)              \
     }                                                                                                             \
                                                                                                                   \
     void struct_name##_free(struct_name *obj) {                                                                   \
         if (!obj)                                                                                                 \
             return;                                                                                               \
         struct_name##_free_members(obj);                                                                          \
-        free(obj);                                                                                                \
+        MASON_FREE(obj);                                                                                          \
     }                                                                                                             \
                                                                                                                   \
     string struct_name##_to_string(MASON_Parsed json) {                                                           \
@@ -404,13 +877,38 @@ static inline void mason_free_array_string(char **arr, size_t count) {
         return cJSON_Print(json);                                                                                 \
     }                                                                                                             \
                                                                                                                   \
+    string struct_name##_to_string_compact(MASON_Parsed json) {                                                   \
+        if (!json)                                                                                                \
+            return NULL;                                                                                          \
+        return cJSON_PrintUnformatted(json);                                                                      \
+    }                                                                                                             \
+                                                                                                                  \
+    bool struct_name##_to_buffer(MASON_Parsed json, char *buf, size_t cap) {                                      \
+        if (!json || !buf)                                                                                        \
+            return false;                                                                                         \
+        return cJSON_PrintPreallocated(json, buf, cap > INT32_MAX ? INT32_MAX : (int)cap, false);                 \
+    }                                                                                                             \
+                                                                                                                  \
     void struct_name##_string_free(string str) {                                                                  \
         if (str)                                                                                                  \
-            free(str);                                                                                            \
+            MASON_FREE(str);                                                                                      \
     }
 
-#define MASON_IMPL(struct_name, FIELDS)   \
-    _MASON_IMPL_BASE(struct_name, FIELDS) \
+#define MASON_IMPL(struct_name, FIELDS)       \
+    _MASON_IMPL_BASE(struct_name, FIELDS)     \
+    _MASON_IMPL_WRITE(struct_name, FIELDS)    \
+    _MASON_IMPL_DECODE(struct_name, FIELDS)   \
+    _MASON_IMPL_NDJSON(struct_name, FIELDS)   \
+    _MASON_IMPL_BATCH(struct_name, FIELDS)    \
+    _MASON_IMPL_FILE(struct_name, FIELDS)     \
+    _MASON_IMPL_VIEW(struct_name, FIELDS)     \
+    _MASON_IMPL_ETF(struct_name, FIELDS)      \
+    _MASON_IMPL_SNAPSHOT(struct_name, FIELDS) \
+    _MASON_IMPL_INFLATE(struct_name, FIELDS)  \
+    _MASON_IMPL_PUSH(struct_name, FIELDS)     \
+    _MASON_IMPL_HASH(struct_name, FIELDS)     \
+    _MASON_IMPL_DIFF(struct_name, FIELDS)     \
+    _MASON_IMPL_CLONE(struct_name, FIELDS)    \
     _MASON_IMPL_PRINT(struct_name, FIELDS)
 
 #endif // MASON_H
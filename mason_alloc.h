@@ -0,0 +1,247 @@
+#ifndef MASON_ALLOC_H
+#define MASON_ALLOC_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cjson/cJSON.h>
+
+/* Allocator Hooks
+ *
+ * Every allocation made by Mason goes through MASON_MALLOC/MASON_CALLOC/
+ * MASON_REALLOC/MASON_FREE. By default these dispatch to the allocator set
+ * with mason_set_allocator(), which also installs the same functions as cJSON's
+ * hooks so strings returned by Foo_to_string and Foo_to_string_direct can both
+ * be released with Foo_string_free. The macros can also be defined before
+ * including mason.h to bind an allocator at compile time.
+ *
+ * NOTE: set the allocator once at startup, before anything is allocated;
+ * memory must be freed by the allocator that returned it.
+ */
+
+typedef struct {
+    void *(*malloc_fn)(size_t size);
+    void *(*realloc_fn)(void *ptr, size_t size);
+    void (*free_fn)(void *ptr);
+} mason_allocator;
+
+/* Process-wide state (the allocator, the pool and the intern table) needs one
+ * definition shared by every translation unit. GNU C compilers merge weak
+ * definitions from each one; elsewhere the state is only declared, and exactly
+ * one source file must define MASON_SHARED_IMPL before including mason.h.
+ */
+#if defined(__GNUC__)
+#define _MASON_SHARED(decl, ...) __attribute__((weak)) decl = __VA_ARGS__
+#elif defined(MASON_SHARED_IMPL)
+#define _MASON_SHARED(decl, ...) decl = __VA_ARGS__
+#else
+#define _MASON_SHARED(decl, ...) extern decl
+#endif
+
+_MASON_SHARED(mason_allocator _mason_allocator, {malloc, realloc, free});
+
+static inline const mason_allocator *mason_get_allocator(void) { return &_mason_allocator; }
+
+/* Passing NULL restores the C library allocator */
+static inline void mason_set_allocator(const mason_allocator *allocator) {
+    if (!allocator || (allocator->malloc_fn == malloc && allocator->free_fn == free)) {
+        _mason_allocator = (mason_allocator){malloc, realloc, free};
+        cJSON_InitHooks(NULL);
+        return;
+    }
+    _mason_allocator = *allocator;
+    cJSON_Hooks hooks = {allocator->malloc_fn, allocator->free_fn};
+    cJSON_InitHooks(&hooks);
+}
+
+static inline void *mason_malloc(size_t size) { return _mason_allocator.malloc_fn(size); }
+static inline void *mason_realloc(void *ptr, size_t size) { return _mason_allocator.realloc_fn(ptr, size); }
+static inline void mason_free(void *ptr) {
+    if (ptr)
+        _mason_allocator.free_fn(ptr);
+}
+
+static inline void *mason_calloc(size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size)
+        return NULL;
+    void *p = _mason_allocator.malloc_fn(count * size);
+    if (p)
+        memset(p, 0, count * size);
+    return p;
+}
+
+#ifndef MASON_MALLOC
+#define MASON_MALLOC(size)        mason_malloc(size)
+#define MASON_CALLOC(count, size) mason_calloc(count, size)
+#define MASON_REALLOC(ptr, size)  mason_realloc(ptr, size)
+#define MASON_FREE(ptr)           mason_free(ptr)
+#endif
+
+/* Thread-Local Pool Allocator
+ *
+ * Mason mostly allocates small blocks of a few sizes (strings, array slots,
+ * nested structs). The pool keeps one free list per power-of-two size class
+ * per thread and carves new blocks from slabs, so steady-state decode/free
+ * cycles do not touch malloc at all. Each block carries a header with its size
+ * class; larger requests fall through to malloc.
+ *
+ * Blocks may be freed on any thread, they join that thread's free list. Slabs
+ * are never returned to the system; a worker thread should call
+ * mason_pool_thread_exit() before it ends so the next new thread adopts its
+ * slabs and free lists instead of leaking them.
+ */
+
+#define MASON_POOL_MIN_SHIFT 4  // 16 bytes
+#define MASON_POOL_CLASSES   7  // up to 1024 bytes
+#define MASON_POOL_MAX_SIZE  ((size_t)1 << (MASON_POOL_MIN_SHIFT + MASON_POOL_CLASSES - 1))
+#define MASON_POOL_SLAB_SIZE (64 * 1024)
+#define MASON_POOL_LARGE     MASON_POOL_CLASSES
+
+typedef union mason_pool_header {
+    size_t size_class;
+    max_align_t align;
+} mason_pool_header;
+
+typedef struct mason_pool_block {
+    struct mason_pool_block *next;
+} mason_pool_block;
+
+typedef struct mason_pool_cache {
+    mason_pool_block *free_lists[MASON_POOL_CLASSES];
+    void *slabs; // chained through their first word
+    char *bump;
+    size_t bump_left;
+    struct mason_pool_cache *next_orphan;
+} mason_pool_cache;
+
+_MASON_SHARED(_Thread_local mason_pool_cache _mason_pool_cache, {0});
+_MASON_SHARED(mason_pool_cache *_mason_pool_orphans, NULL);
+_MASON_SHARED(atomic_flag _mason_pool_orphans_lock, ATOMIC_FLAG_INIT);
+
+static inline void _mason_pool_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&_mason_pool_orphans_lock, memory_order_acquire))
+        ;
+}
+
+static inline void _mason_pool_unlock(void) {
+    atomic_flag_clear_explicit(&_mason_pool_orphans_lock, memory_order_release);
+}
+
+/* Hands the calling thread's pool to the next thread that starts allocating */
+static inline void mason_pool_thread_exit(void) {
+    mason_pool_cache *cache = &_mason_pool_cache;
+    if (!cache->slabs)
+        return;
+    mason_pool_cache *orphan = (mason_pool_cache *)malloc(sizeof(mason_pool_cache));
+    if (!orphan)
+        return;
+    *orphan = *cache;
+    memset(cache, 0, sizeof(*cache));
+    _mason_pool_lock();
+    orphan->next_orphan = _mason_pool_orphans;
+    _mason_pool_orphans = orphan;
+    _mason_pool_unlock();
+}
+
+/* A thread with no slabs of its own first tries to take over an orphaned pool */
+static inline bool _mason_pool_adopt(mason_pool_cache *cache) {
+    if (cache->slabs)
+        return false;
+    _mason_pool_lock();
+    mason_pool_cache *orphan = _mason_pool_orphans;
+    if (orphan)
+        _mason_pool_orphans = orphan->next_orphan;
+    _mason_pool_unlock();
+    if (!orphan)
+        return false;
+    *cache = *orphan;
+    cache->next_orphan = NULL;
+    free(orphan);
+    return true;
+}
+
+static inline size_t _mason_pool_class(size_t size) {
+    size_t cls = 0;
+    while (((size_t)1 << (MASON_POOL_MIN_SHIFT + cls)) < size)
+        cls++;
+    return cls;
+}
+
+static inline void *mason_pool_malloc(size_t size) {
+    if (size > MASON_POOL_MAX_SIZE) {
+        mason_pool_header *h = (mason_pool_header *)malloc(sizeof(mason_pool_header) + size);
+        if (!h)
+            return NULL;
+        h->size_class = MASON_POOL_LARGE;
+        return h + 1;
+    }
+    mason_pool_cache *cache = &_mason_pool_cache;
+    size_t cls = _mason_pool_class(size);
+    if (!cache->slabs)
+        _mason_pool_adopt(cache);
+    mason_pool_header *h = (mason_pool_header *)cache->free_lists[cls];
+    if (h) {
+        cache->free_lists[cls] = ((mason_pool_block *)h)->next;
+    } else {
+        size_t block = sizeof(mason_pool_header) + ((size_t)1 << (MASON_POOL_MIN_SHIFT + cls));
+        if (cache->bump_left < block) {
+            char *slab = (char *)malloc(MASON_POOL_SLAB_SIZE);
+            if (!slab)
+                return NULL;
+            *(void **)slab = cache->slabs;
+            cache->slabs = slab;
+            cache->bump = slab + sizeof(mason_pool_header);
+            cache->bump_left = MASON_POOL_SLAB_SIZE - sizeof(mason_pool_header);
+        }
+        h = (mason_pool_header *)cache->bump;
+        cache->bump += block;
+        cache->bump_left -= block;
+    }
+    h->size_class = cls;
+    return h + 1;
+}
+
+static inline void mason_pool_free(void *ptr) {
+    if (!ptr)
+        return;
+    mason_pool_header *h = (mason_pool_header *)ptr - 1;
+    size_t cls = h->size_class;
+    if (cls == MASON_POOL_LARGE) {
+        free(h);
+        return;
+    }
+    mason_pool_block *b = (mason_pool_block *)h;
+    b->next = _mason_pool_cache.free_lists[cls];
+    _mason_pool_cache.free_lists[cls] = b;
+}
+
+static inline void *mason_pool_realloc(void *ptr, size_t size) {
+    if (!ptr)
+        return mason_pool_malloc(size);
+    mason_pool_header *h = (mason_pool_header *)ptr - 1;
+    if (h->size_class == MASON_POOL_LARGE && size > MASON_POOL_MAX_SIZE) {
+        h = (mason_pool_header *)realloc(h, sizeof(mason_pool_header) + size);
+        return h ? h + 1 : NULL;
+    }
+    size_t old_size = h->size_class == MASON_POOL_LARGE ? MASON_POOL_MAX_SIZE + 1
+                                                        : (size_t)1 << (MASON_POOL_MIN_SHIFT + h->size_class);
+    if (size <= old_size && h->size_class != MASON_POOL_LARGE)
+        return ptr;
+    void *p = mason_pool_malloc(size);
+    if (!p)
+        return NULL;
+    /* A large block shrinking into a class only keeps what fits */
+    memcpy(p, ptr, old_size < size ? old_size : size);
+    mason_pool_free(ptr);
+    return p;
+}
+
+static inline const mason_allocator *mason_pool_allocator(void) {
+    static const mason_allocator pool = {mason_pool_malloc, mason_pool_realloc, mason_pool_free};
+    return &pool;
+}
+
+#endif // MASON_ALLOC_H
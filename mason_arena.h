@@ -0,0 +1,138 @@
+#ifndef MASON_ARENA_H
+#define MASON_ARENA_H
+
+#include <stddef.h>
+
+/* Bump Arena
+ *
+ * Memory for structs decoded with the _arena variants comes from here and is
+ * released all at once by mason_arena_reset/mason_arena_destroy. Such structs
+ * must never be passed to Foo_free/Foo_free_members.
+ */
+
+#define MASON_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define MASON_ARENA_ALIGN              _Alignof(max_align_t)
+
+typedef struct mason_arena_block {
+    struct mason_arena_block *next;
+    size_t cap;
+    size_t used;
+    max_align_t data[];
+} mason_arena_block;
+
+/* Non-arena resources (e.g. ARRAY_MULTI JSON handles) released on reset */
+typedef struct mason_arena_cleanup {
+    struct mason_arena_cleanup *next;
+    void (*fn)(void *);
+    void *ptr;
+} mason_arena_cleanup;
+
+typedef struct {
+    mason_arena_block *head;
+    mason_arena_cleanup *cleanups;
+    size_t block_size;
+} mason_arena;
+
+static inline void mason_arena_init(mason_arena *arena, size_t block_size) {
+    arena->head = NULL;
+    arena->cleanups = NULL;
+    arena->block_size = block_size ? block_size : MASON_ARENA_DEFAULT_BLOCK_SIZE;
+}
+
+static inline size_t _mason_arena_round(size_t size) {
+    return (size + MASON_ARENA_ALIGN - 1) & ~(MASON_ARENA_ALIGN - 1);
+}
+
+static inline void *mason_arena_alloc(mason_arena *arena, size_t size) {
+    size = _mason_arena_round(size ? size : 1);
+    mason_arena_block *block = arena->head;
+    if (!block || block->cap - block->used < size) {
+        /* Blocks double in size so a large document settles into few blocks */
+        size_t cap = block ? block->cap * 2 : arena->block_size;
+        if (cap < size)
+            cap = _mason_arena_round(size);
+        block = (mason_arena_block *)MASON_MALLOC(sizeof(mason_arena_block) + cap);
+        if (!block)
+            return NULL;
+        block->next = arena->head;
+        block->cap = cap;
+        block->used = 0;
+        arena->head = block;
+    }
+    void *p = (char *)block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+static inline void *mason_arena_calloc(mason_arena *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size)
+        return NULL;
+    void *p = mason_arena_alloc(arena, count * size);
+    if (p)
+        memset(p, 0, count * size);
+    return p;
+}
+
+/* Grows the most recent allocation in place when possible */
+static inline void *mason_arena_realloc(mason_arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    mason_arena_block *block = arena->head;
+    if (ptr && block) {
+        size_t offset = (size_t)((char *)ptr - (char *)block->data);
+        size_t old_rounded = _mason_arena_round(old_size ? old_size : 1);
+        size_t new_rounded = _mason_arena_round(new_size ? new_size : 1);
+        if (offset + old_rounded == block->used && offset + new_rounded <= block->cap) {
+            block->used = offset + new_rounded;
+            return ptr;
+        }
+    }
+    void *p = mason_arena_alloc(arena, new_size);
+    if (p && ptr)
+        memcpy(p, ptr, old_size < new_size ? old_size : new_size);
+    return p;
+}
+
+static inline bool mason_arena_defer(mason_arena *arena, void (*fn)(void *), void *ptr) {
+    mason_arena_cleanup *c = (mason_arena_cleanup *)mason_arena_alloc(arena, sizeof(mason_arena_cleanup));
+    if (!c)
+        return false;
+    c->next = arena->cleanups;
+    c->fn = fn;
+    c->ptr = ptr;
+    arena->cleanups = c;
+    return true;
+}
+
+static inline void _mason_arena_run_cleanups(mason_arena *arena) {
+    for (mason_arena_cleanup *c = arena->cleanups; c; c = c->next)
+        c->fn(c->ptr);
+    arena->cleanups = NULL;
+}
+
+/* Frees everything but the largest block, which is kept for reuse */
+static inline void mason_arena_reset(mason_arena *arena) {
+    _mason_arena_run_cleanups(arena);
+    mason_arena_block *keep = arena->head;
+    if (!keep)
+        return;
+    mason_arena_block *block = keep->next;
+    while (block) {
+        mason_arena_block *next = block->next;
+        MASON_FREE(block);
+        block = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+}
+
+static inline void mason_arena_destroy(mason_arena *arena) {
+    _mason_arena_run_cleanups(arena);
+    mason_arena_block *block = arena->head;
+    while (block) {
+        mason_arena_block *next = block->next;
+        MASON_FREE(block);
+        block = next;
+    }
+    arena->head = NULL;
+}
+
+#endif // MASON_ARENA_H
@@ -0,0 +1,178 @@
+#ifndef MASON_CLONE_H
+#define MASON_CLONE_H
+
+/* Single-Block Clones
+ *
+ * Foo_clone deep-copies a struct and everything it owns (strings, arrays,
+ * nested objects and unions, ARRAY_MULTI values and their JSON trees) into one
+ * allocation, laid out depth-first the same way as a snapshot image but with
+ * real pointers, so nothing needs loading. It is sized with the snapshot
+ * extent, then filled in a single pass.
+ *
+ *   Foo *cached = Foo_clone(decoded); // outlives the arena or buffer it came from
+ *   Foo_free(decoded);
+ *   ...
+ *   Foo_clone_free(cached);
+ *
+ * string_view fields are copied too, so a clone never borrows its source.
+ * Interned strings keep pointing at the shared copy, which leaves their bytes
+ * of the block unused. Never pass a clone to Foo_free: it frees as one block.
+ */
+
+/* Copies n bytes to the cursor and returns the copy */
+static inline void *_mason_clone_copy(char *base, size_t *cursor, const void *src, size_t n) {
+    return base + _mason_snapshot_copy(base, cursor, src, n);
+}
+
+static inline void _mason_clone_str(const char **s, char *base, size_t *cursor) {
+    _mason_snapshot_copy_str(s, base, cursor, false);
+}
+
+/* Value Handlers (dispatched on a pointer to the field's alias type) */
+
+static inline void mason_clone_place_scalar(const void *v, char *base, size_t *cursor) {
+    (void)v;
+    (void)base;
+    (void)cursor;
+}
+
+static inline void mason_clone_place_string(char **v, char *base, size_t *cursor) {
+    _mason_clone_str((const char **)v, base, cursor);
+}
+
+static inline void mason_clone_place_string_view(const char **v, char *base, size_t *cursor) {
+    _mason_clone_str(v, base, cursor);
+}
+
+#define mason_clone_place(v, base, cursor) _Generic((v), \
+    int32_t *: mason_clone_place_scalar,                 \
+    int64_t *: mason_clone_place_scalar,                 \
+    double *: mason_clone_place_scalar,                  \
+    char **: mason_clone_place_string,                   \
+    const char **: mason_clone_place_string_view,        \
+    mason_interned_t *: mason_clone_place_scalar,        \
+    _Bool *: mason_clone_place_scalar)(v, base, cursor)
+
+/* ARRAY_MULTI values */
+
+static inline void _mason_clone_rawvalue(MASON_RawValue *v, char *base, size_t *cursor) {
+    switch (v->type) {
+    case MASON_VALUE_STRING:
+        _mason_clone_str((const char **)&v->value.s, base, cursor);
+        break;
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        v->value.ast = _mason_snapshot_ast_copy(v->value.ast, base, cursor, false);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Field Placement (dst is the clone, still holding the source pointers) */
+
+#define _MASON_CLONE_FIELD(type, name)                                             \
+    {                                                                              \
+        _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))dst->name; \
+        mason_clone_place(&_mason_value, base, cursor);                            \
+        dst->name = (type)_mason_value;                                            \
+    }
+
+#define _MASON_CLONE_ARRAY_PRIM(type, name)                                                \
+    if (dst->name && dst->name##_count) {                                                  \
+        size_t _mason_n = dst->name##_count * sizeof(type);                                \
+        type *_mason_arr = (type *)_mason_clone_copy(base, cursor, dst->name, _mason_n);   \
+        for (size_t i = 0; i < dst->name##_count; i++) {                                   \
+            _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))_mason_arr[i]; \
+            mason_clone_place(&_mason_value, base, cursor);                                \
+            _mason_arr[i] = (type)_mason_value;                                            \
+        }                                                                                  \
+        dst->name = _mason_arr;                                                            \
+    } else {                                                                               \
+        dst->name = NULL;                                                                  \
+        dst->name##_count = 0;                                                             \
+    }
+
+#define _MASON_CLONE_ARRAY_MULTI(name)                                                                       \
+    if (dst->name && dst->name##_count) {                                                                    \
+        size_t _mason_n = dst->name##_count * sizeof(MASON_RawValue);                                        \
+        MASON_RawValue *_mason_arr = (MASON_RawValue *)_mason_clone_copy(base, cursor, dst->name, _mason_n); \
+        for (size_t i = 0; i < dst->name##_count; i++)                                                       \
+            _mason_clone_rawvalue(&_mason_arr[i], base, cursor);                                             \
+        dst->name = _mason_arr;                                                                              \
+    } else {                                                                                                 \
+        dst->name = NULL;                                                                                    \
+        dst->name##_count = 0;                                                                               \
+    }
+
+#define _MASON_CLONE_OBJECT(type, name)                                                             \
+    if (dst->name) {                                                                                \
+        dst->name = (struct type *)_mason_clone_copy(base, cursor, dst->name, sizeof(struct type)); \
+        type##_clone_place(dst->name, base, cursor);                                                \
+    }
+
+#define _MASON_CLONE_ARRAY_OBJECT(type, name)                                     \
+    if (dst->name && dst->name##_count) {                                         \
+        size_t _mason_n = dst->name##_count * sizeof(type);                       \
+        dst->name = (type *)_mason_clone_copy(base, cursor, dst->name, _mason_n); \
+        for (size_t i = 0; i < dst->name##_count; i++)                            \
+            type##_clone_place(&dst->name[i], base, cursor);                      \
+    } else {                                                                      \
+        dst->name = NULL;                                                         \
+        dst->name##_count = 0;                                                    \
+    }
+
+#define _MASON_CLONE_UNION_CASE(value, type, member)                                                 \
+    _MASON_UNION_CASE(value) {                                                                       \
+        *_mason_union_ptr = _mason_clone_copy(base, cursor, *_mason_union_ptr, sizeof(struct type)); \
+        type##_clone_place((type *)*_mason_union_ptr, base, cursor);                                 \
+    }
+
+#define _MASON_CLONE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                     \
+        _MASON_UNION_SWITCH(tag, name)       \
+        CASES(_MASON_CLONE_UNION_CASE)       \
+        else {                               \
+            *_mason_union_ptr = NULL;        \
+        }                                    \
+    }
+
+/* X-Macro Expansion Helpers for Clones */
+
+#define _MASON_EXPAND_CLONE_FIELD(type, name)        _MASON_CLONE_FIELD(type, name)
+#define _MASON_EXPAND_CLONE_ARRAY(type, name)        _MASON_CLONE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_CLONE_ARRAY_MULTI(name)        _MASON_CLONE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_CLONE_OBJECT(type, name)       _MASON_CLONE_OBJECT(type, name)
+#define _MASON_EXPAND_CLONE_ARRAY_OBJECT(type, name) _MASON_CLONE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_CLONE_UNION(tag, name, CASES)  _MASON_CLONE_UNION(tag, name, CASES)
+
+/* Partial clone impl */
+#define _MASON_IMPL_CLONE(struct_name, FIELDS)                                                        \
+    void struct_name##_clone_place(struct_name *dst, char *base, size_t *cursor) {                    \
+        struct_name *obj = dst;                                                                       \
+        FIELDS(_MASON_EXPAND_CLONE_FIELD, _MASON_EXPAND_CLONE_ARRAY, _MASON_EXPAND_CLONE_ARRAY_MULTI, \
+               _MASON_EXPAND_CLONE_OBJECT, _MASON_EXPAND_CLONE_ARRAY_OBJECT,                          \
+               _MASON_EXPAND_CLONE_UNION)                                                             \
+        (void)obj;                                                                                    \
+    }                                                                                                 \
+                                                                                                      \
+    struct_name *struct_name##_clone(const struct_name *obj) {                                        \
+        if (!obj)                                                                                     \
+            return NULL;                                                                              \
+        size_t size = _mason_snapshot_align(sizeof(struct_name)) +                                    \
+                      struct_name##_snapshot_extent((struct_name *)obj);                              \
+        char *base = (char *)MASON_MALLOC(size);                                                      \
+        if (!base)                                                                                    \
+            return NULL;                                                                              \
+        size_t cursor = 0;                                                                            \
+        struct_name *dst = (struct_name *)_mason_clone_copy(base, &cursor, obj, sizeof(struct_name)); \
+        struct_name##_clone_place(dst, base, &cursor);                                                \
+        return dst;                                                                                   \
+    }                                                                                                 \
+                                                                                                      \
+    void struct_name##_clone_free(struct_name *clone) {                                               \
+        if (clone)                                                                                    \
+            MASON_FREE(clone);                                                                        \
+    }
+
+#endif // MASON_CLONE_H
@@ -0,0 +1,785 @@
+#ifndef MASON_DECODE_H
+#define MASON_DECODE_H
+
+/* Single-Pass Reader
+ *
+ * Tokenizes JSON text directly into Mason structs without building a cJSON
+ * tree. Accepts the same inputs as cJSON_ParseWithLength (including trailing
+ * bytes after the root value) and converts numbers the same way cJSON does, so
+ * decoded structs match the _from_json path.
+ */
+
+#define MASON_READER_NESTING_LIMIT 1000
+
+typedef struct {
+    const char *cur;
+    const char *end;
+    size_t depth;
+    bool failed;
+    mason_arena *arena;    // NULL allocates owned memory from the heap
+    bool inplace;          // the input is writable, string_view values are unescaped where they lie
+    bool skip_views;       // patches: string_view values are skipped instead of failing the decode
+    mason_field_mask mask; // fields of the next object decoded; nested objects are always decoded whole
+    char key_buf[128];     // unescaped keys only, plain keys point into the input
+} mason_reader;
+
+static inline void mason_reader_init(mason_reader *r, const char *json_str, size_t len) {
+    r->cur = json_str;
+    r->end = json_str + len;
+    r->depth = 0;
+    r->failed = false;
+    r->arena = NULL;
+    r->inplace = false;
+    r->skip_views = false;
+    r->mask = MASON_FIELDS_ALL;
+}
+
+static inline bool mason_reader_fail(mason_reader *r) {
+    r->failed = true;
+    r->cur = r->end;
+    return false;
+}
+
+/* Allocation for decoded members, from the reader's arena if it has one */
+
+static inline void *_mason_reader_calloc(mason_reader *r, size_t size) {
+    void *p = r->arena ? mason_arena_calloc(r->arena, 1, size) : MASON_CALLOC(1, size);
+    if (!p)
+        mason_reader_fail(r);
+    return p;
+}
+
+static inline void *_mason_reader_realloc(mason_reader *r, void *ptr, size_t old_size, size_t new_size) {
+    void *p = r->arena ? mason_arena_realloc(r->arena, ptr, old_size, new_size) : MASON_REALLOC(ptr, new_size);
+    if (!p)
+        mason_reader_fail(r);
+    return p;
+}
+
+static inline void _mason_reader_release(mason_reader *r, void *ptr) {
+    if (!r->arena)
+        MASON_FREE(ptr);
+}
+
+/* Same whitespace rule as cJSON: every byte <= 0x20, NUL included */
+static inline char mason_reader_peek(mason_reader *r) {
+    while (r->cur < r->end && (unsigned char)*r->cur <= 32)
+        r->cur++;
+    return r->cur < r->end ? *r->cur : '\0';
+}
+
+/* Strings */
+
+static inline int _mason_hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static inline bool _mason_hex4(const char *p, uint32_t *out) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        int d = _mason_hex_digit(p[i]);
+        if (d < 0)
+            return false;
+        v = (v << 4) | (uint32_t)d;
+    }
+    *out = v;
+    return true;
+}
+
+/* Unescapes the raw contents of a string literal into `dst`, which may be NULL
+ * to only validate or equal to `src` to unescape in place (the output is never
+ * longer than the input). Returns the unescaped length or SIZE_MAX on a bad escape.
+ */
+static inline size_t _mason_unescape(const char *src, size_t len, char *dst) {
+    const char *p = src, *end = src + len;
+    size_t n = 0;
+    while (p < end) {
+        const char *run = p;
+        p = memchr(p, '\\', (size_t)(end - p));
+        if (!p)
+            p = end;
+        if (dst)
+            memmove(dst + n, run, (size_t)(p - run));
+        n += (size_t)(p - run);
+        if (p == end)
+            break;
+        if (++p == end)
+            return SIZE_MAX;
+        char c = *p++;
+        char simple = 0;
+        switch (c) {
+        case 'b':
+            simple = '\b';
+            break;
+        case 'f':
+            simple = '\f';
+            break;
+        case 'n':
+            simple = '\n';
+            break;
+        case 'r':
+            simple = '\r';
+            break;
+        case 't':
+            simple = '\t';
+            break;
+        case '"':
+        case '\\':
+        case '/':
+            simple = c;
+            break;
+        case 'u': {
+            uint32_t cp = 0, lo = 0;
+            if (end - p < 4 || !_mason_hex4(p, &cp))
+                return SIZE_MAX;
+            p += 4;
+            if (cp >= 0xDC00 && cp <= 0xDFFF)
+                return SIZE_MAX;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !_mason_hex4(p + 2, &lo) || lo < 0xDC00 || lo > 0xDFFF)
+                    return SIZE_MAX;
+                p += 6;
+                cp = 0x10000 + (((cp & 0x3FF) << 10) | (lo & 0x3FF));
+            }
+            unsigned char utf8[4];
+            size_t ulen;
+            if (cp < 0x80) {
+                utf8[0] = (unsigned char)cp;
+                ulen = 1;
+            } else if (cp < 0x800) {
+                utf8[0] = (unsigned char)(0xC0 | (cp >> 6));
+                utf8[1] = (unsigned char)(0x80 | (cp & 0x3F));
+                ulen = 2;
+            } else if (cp < 0x10000) {
+                utf8[0] = (unsigned char)(0xE0 | (cp >> 12));
+                utf8[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+                utf8[2] = (unsigned char)(0x80 | (cp & 0x3F));
+                ulen = 3;
+            } else {
+                utf8[0] = (unsigned char)(0xF0 | (cp >> 18));
+                utf8[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+                utf8[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+                utf8[3] = (unsigned char)(0x80 | (cp & 0x3F));
+                ulen = 4;
+            }
+            if (dst)
+                memcpy(dst + n, utf8, ulen);
+            n += ulen;
+            continue;
+        }
+        default:
+            return SIZE_MAX;
+        }
+        if (dst)
+            dst[n] = simple;
+        n++;
+    }
+    return n;
+}
+
+/* Consumes a string literal and returns its raw (still escaped) contents */
+static inline bool _mason_reader_string_span(mason_reader *r, const char **start, size_t *len, bool *escaped) {
+    if (mason_reader_peek(r) != '"')
+        return mason_reader_fail(r);
+    const char *p = ++r->cur;
+    bool esc = false;
+    for (;;) {
+        p = mason_scan_string(p, r->end);
+        if (p >= r->end || *p == '"')
+            break;
+        esc = true;
+        p += 2; // the backslash and the escaped byte
+    }
+    if (p >= r->end)
+        return mason_reader_fail(r);
+    *start = r->cur;
+    *len = (size_t)(p - r->cur);
+    *escaped = esc;
+    r->cur = p + 1;
+    return true;
+}
+
+/* Returns a heap copy of the next string literal */
+static inline char *_mason_reader_string(mason_reader *r) {
+    const char *start;
+    size_t len;
+    bool escaped;
+    if (!_mason_reader_string_span(r, &start, &len, &escaped))
+        return NULL;
+    char *s = (char *)_mason_reader_realloc(r, NULL, 0, len + 1);
+    if (!s)
+        return NULL;
+    size_t n = len;
+    if (escaped)
+        n = _mason_unescape(start, len, s);
+    else
+        memcpy(s, start, len);
+    if (n == SIZE_MAX) {
+        _mason_reader_release(r, s);
+        mason_reader_fail(r);
+        return NULL;
+    }
+    s[n] = '\0';
+    return s;
+}
+
+/* Numbers: same character set, length limit and strtod conversion as cJSON */
+static inline bool _mason_reader_number(mason_reader *r, double *out) {
+    char tmp[64];
+    size_t n = 0;
+    mason_reader_peek(r);
+    while (n < sizeof(tmp) - 1 && r->cur + n < r->end) {
+        char c = r->cur[n];
+        if ((c < '0' || c > '9') && c != '+' && c != '-' && c != 'e' && c != 'E' && c != '.')
+            break;
+        tmp[n++] = c;
+    }
+    tmp[n] = '\0';
+    char *after = NULL;
+    double d = strtod(tmp, &after);
+    if (after == tmp)
+        return mason_reader_fail(r);
+    r->cur += after - tmp;
+    *out = d;
+    return true;
+}
+
+static inline bool _mason_reader_literal(mason_reader *r, const char *lit, size_t len) {
+    if ((size_t)(r->end - r->cur) < len || memcmp(r->cur, lit, len) != 0)
+        return mason_reader_fail(r);
+    r->cur += len;
+    return true;
+}
+
+/* Containers
+ *
+ * Usage:
+ *   bool first = true;
+ *   if (mason_reader_object_begin(r))
+ *       while (mason_reader_next_key(r, &first, &key, &key_len)) { ...consume value... }
+ */
+
+static inline bool mason_reader_skip(mason_reader *r);
+
+static inline bool _mason_reader_open(mason_reader *r, char open) {
+    if (mason_reader_peek(r) != open)
+        return false;
+    if (r->depth >= MASON_READER_NESTING_LIMIT)
+        return mason_reader_fail(r);
+    r->depth++;
+    r->cur++;
+    return true;
+}
+
+/* Consumes '{' if the next value is an object, otherwise leaves it in place */
+static inline bool mason_reader_object_begin(mason_reader *r) { return _mason_reader_open(r, '{'); }
+
+/* Consumes '[' if the next value is an array, otherwise leaves it in place */
+static inline bool mason_reader_array_begin(mason_reader *r) { return _mason_reader_open(r, '['); }
+
+/* Advances to the next member or element, consuming the closing bracket at the end.
+ * `first` tracks whether a separator is expected and must start out true.
+ */
+static inline bool _mason_reader_next(mason_reader *r, char close, bool *first) {
+    if (r->failed)
+        return false;
+    char c = mason_reader_peek(r);
+    if (*first && c == close) {
+        r->cur++;
+        r->depth--;
+        *first = false;
+        return false;
+    }
+    if (!*first) {
+        if (c == close) {
+            r->cur++;
+            r->depth--;
+            return false;
+        }
+        if (c != ',')
+            return mason_reader_fail(r);
+        r->cur++;
+    }
+    *first = false;
+    return true;
+}
+
+static inline bool mason_reader_next_element(mason_reader *r, bool *first) {
+    return _mason_reader_next(r, ']', first);
+}
+
+/* Reads a key string, unescaped into key_buf if it has escapes */
+static inline bool _mason_reader_key(mason_reader *r, const char **key, size_t *key_len) {
+    bool escaped;
+    if (!_mason_reader_string_span(r, key, key_len, &escaped))
+        return false;
+    if (escaped) {
+        /* Escaped keys longer than the buffer can't name a field, only validate them */
+        bool fits = *key_len <= sizeof(r->key_buf);
+        size_t n = _mason_unescape(*key, *key_len, fits ? r->key_buf : NULL);
+        if (n == SIZE_MAX)
+            return mason_reader_fail(r);
+        *key = fits ? r->key_buf : "";
+        *key_len = fits ? n : 0;
+    }
+    return true;
+}
+
+/* Reads the next key (unescaped, not NUL-terminated) and the following ':' */
+static inline bool mason_reader_next_key(mason_reader *r, bool *first, const char **key, size_t *key_len) {
+    if (!_mason_reader_next(r, '}', first) || !_mason_reader_key(r, key, key_len))
+        return false;
+    if (mason_reader_peek(r) != ':')
+        return mason_reader_fail(r);
+    r->cur++;
+    return true;
+}
+
+/* Skips the next value without allocating */
+static inline bool mason_reader_skip(mason_reader *r) {
+    const char *start;
+    size_t len;
+    bool escaped, first = true;
+    double d;
+    switch (mason_reader_peek(r)) {
+    case '"':
+        if (!_mason_reader_string_span(r, &start, &len, &escaped))
+            return false;
+        if (escaped && _mason_unescape(start, len, NULL) == SIZE_MAX)
+            return mason_reader_fail(r);
+        return true;
+    case '{':
+        if (!mason_reader_object_begin(r))
+            return false;
+        while (mason_reader_next_key(r, &first, &start, &len))
+            if (!mason_reader_skip(r))
+                return false;
+        return !r->failed;
+    case '[':
+        if (!mason_reader_array_begin(r))
+            return false;
+        while (mason_reader_next_element(r, &first))
+            if (!mason_reader_skip(r))
+                return false;
+        return !r->failed;
+    case 't':
+        return _mason_reader_literal(r, "true", 4);
+    case 'f':
+        return _mason_reader_literal(r, "false", 5);
+    case 'n':
+        return _mason_reader_literal(r, "null", 4);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        return _mason_reader_number(r, &d);
+    default:
+        return mason_reader_fail(r);
+    }
+}
+
+static inline bool _mason_reader_is_number(char c) { return c == '-' || (c >= '0' && c <= '9'); }
+
+/* Typed value readers
+ * NOTE: consume the next value either way, return false if it has the wrong type
+ */
+
+static inline bool _mason_reader_mismatch(mason_reader *r) {
+    mason_reader_skip(r);
+    return false;
+}
+
+/* Integers come straight from the digits; fractions, exponents and overflow go through strtod and saturate */
+static inline bool _mason_reader_integer(mason_reader *r, int64_t *out) {
+    size_t n = mason_parse_int64(r->cur, r->end, out);
+    if (n) {
+        r->cur += n;
+        return true;
+    }
+    double d;
+    if (!_mason_reader_number(r, &d))
+        return false;
+    *out = _mason_double_int64(d);
+    return true;
+}
+
+static inline bool mason_read_int32(mason_reader *r, int32_t *out) {
+    int64_t v;
+    if (!_mason_reader_is_number(mason_reader_peek(r)))
+        return _mason_reader_mismatch(r);
+    if (!_mason_reader_integer(r, &v))
+        return false;
+    /* Saturates like cJSON's valueint */
+    *out = v >= INT32_MAX ? INT32_MAX : v <= INT32_MIN ? INT32_MIN : (int32_t)v;
+    return true;
+}
+
+/* Also accepts a quoted integer, the way APIs send IDs too large for a double */
+static inline bool mason_read_int64(mason_reader *r, int64_t *out) {
+    char c = mason_reader_peek(r);
+    if (c == '"') {
+        const char *start;
+        size_t len;
+        bool escaped;
+        if (!_mason_reader_string_span(r, &start, &len, &escaped))
+            return false;
+        return !escaped && len && mason_parse_int64(start, start + len, out) == len;
+    }
+    if (!_mason_reader_is_number(c))
+        return _mason_reader_mismatch(r);
+    return _mason_reader_integer(r, out);
+}
+
+static inline bool mason_read_double(mason_reader *r, double *out) {
+    if (!_mason_reader_is_number(mason_reader_peek(r)))
+        return _mason_reader_mismatch(r);
+    return _mason_reader_number(r, out);
+}
+
+static inline bool mason_read_string(mason_reader *r, char **out) {
+    if (mason_reader_peek(r) != '"')
+        return _mason_reader_mismatch(r);
+    *out = _mason_reader_string(r);
+    return *out != NULL;
+}
+
+/* string_view values borrow their storage. With a writable input they are
+ * unescaped in place and NUL-terminated over the closing quote, so nothing is
+ * allocated; an arena reader copies them into the arena instead. Any other
+ * reader has nothing that outlives the struct to borrow from, so the decode
+ * fails rather than quietly leaving the field NULL.
+ */
+static inline bool mason_read_string_view(mason_reader *r, const char **out) {
+    if (mason_reader_peek(r) != '"')
+        return _mason_reader_mismatch(r);
+    if (!r->inplace && !r->arena)
+        return r->skip_views ? _mason_reader_mismatch(r) : mason_reader_fail(r);
+    if (!r->inplace) {
+        *out = _mason_reader_string(r);
+        return *out != NULL;
+    }
+    const char *start;
+    size_t len;
+    bool escaped;
+    if (!_mason_reader_string_span(r, &start, &len, &escaped))
+        return false;
+    char *s = (char *)start;
+    size_t n = escaped ? _mason_unescape(start, len, s) : len;
+    if (n == SIZE_MAX)
+        return mason_reader_fail(r);
+    s[n] = '\0';
+    *out = s;
+    return true;
+}
+
+/* Plain values are looked up straight from the input, so a value already in the
+ * table costs no allocation at all; escaped ones are unescaped into a scratch
+ * buffer first.
+ */
+static inline bool mason_read_interned(mason_reader *r, mason_interned_t *out) {
+    if (mason_reader_peek(r) != '"')
+        return _mason_reader_mismatch(r);
+    const char *start;
+    size_t len;
+    bool escaped;
+    if (!_mason_reader_string_span(r, &start, &len, &escaped))
+        return false;
+    char local[256];
+    char *tmp = local;
+    if (escaped) {
+        if (len > sizeof(local) && !(tmp = (char *)MASON_MALLOC(len)))
+            return mason_reader_fail(r);
+        len = _mason_unescape(start, len, tmp);
+        start = tmp;
+    }
+    const char *s = len == SIZE_MAX ? NULL : mason_intern(start, len);
+    if (tmp != local)
+        MASON_FREE(tmp);
+    if (!s)
+        return mason_reader_fail(r);
+    *out = (mason_interned_t)s;
+    return true;
+}
+
+static inline bool mason_read_bool(mason_reader *r, bool *out) {
+    switch (mason_reader_peek(r)) {
+    case 't':
+        *out = true;
+        return _mason_reader_literal(r, "true", 4);
+    case 'f':
+        *out = false;
+        return _mason_reader_literal(r, "false", 5);
+    default:
+        return _mason_reader_mismatch(r);
+    }
+}
+
+#define mason_read(r, out) _Generic((out),   \
+    int32_t *: mason_read_int32,             \
+    int64_t *: mason_read_int64,             \
+    double *: mason_read_double,             \
+    char **: mason_read_string,              \
+    const char **: mason_read_string_view,   \
+    mason_interned_t *: mason_read_interned, \
+    _Bool *: mason_read_bool)(r, out)
+
+/* Grows a decoded array by one zeroed slot, doubling the capacity as needed */
+static inline void *_mason_reader_push(mason_reader *r, void **arr, size_t *count, size_t *cap, size_t elem_size) {
+    if (*count == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 8;
+        void *grown = _mason_reader_realloc(r, *arr, *cap * elem_size, new_cap * elem_size);
+        if (!grown)
+            return NULL;
+        *arr = grown;
+        *cap = new_cap;
+    }
+    void *slot = (char *)*arr + *count * elem_size;
+    memset(slot, 0, elem_size);
+    (*count)++;
+    return slot;
+}
+
+/* Field Decoders */
+
+#define _MASON_DECODE_FIELD(type, name)       \
+    _MASON_KEY_CASE(name) {                   \
+        _MASON_TYPE_ALIAS(type) _mason_value; \
+        if (mason_read(r, &_mason_value)) {   \
+            obj->name = (type)_mason_value;   \
+            _mason_set_##name = true;         \
+        }                                     \
+    }
+
+/* Array bodies without the key match, so patches can reuse them */
+#define _MASON_DECODE_ARRAY_PRIM_VALUE(type, name)                                                     \
+    if (mason_reader_array_begin(r)) {                                                                 \
+        size_t _mason_cap = 0;                                                                         \
+        bool _mason_first = true;                                                                      \
+        while (mason_reader_next_element(r, &_mason_first)) {                                          \
+            _MASON_TYPE_ALIAS(type) _mason_value;                                                      \
+            type *_mason_slot = (type *)_mason_reader_push(r, (void **)&obj->name, &obj->name##_count, \
+                                                           &_mason_cap, sizeof(type));                 \
+            if (!_mason_slot)                                                                          \
+                return false;                                                                          \
+            if (mason_read(r, &_mason_value))                                                          \
+                *_mason_slot = (type)_mason_value;                                                     \
+        }                                                                                              \
+    } else {                                                                                           \
+        mason_reader_skip(r);                                                                          \
+    }
+
+#define _MASON_DECODE_ARRAY_PRIM(type, name)       \
+    _MASON_KEY_CASE(name) {                        \
+        _MASON_DECODE_ARRAY_PRIM_VALUE(type, name) \
+    }
+
+#define _MASON_DECODE_OBJECT(type, name)                                             \
+    _MASON_KEY_CASE(name) {                                                          \
+        if (mason_reader_peek(r) == '{') {                                           \
+            obj->name = (struct type *)_mason_reader_calloc(r, sizeof(struct type)); \
+            if (!obj->name)                                                          \
+                return false;                                                        \
+            if (!type##_decode_reader(obj->name, r))                                 \
+                return false;                                                        \
+        } else {                                                                     \
+            mason_reader_skip(r);                                                    \
+        }                                                                            \
+    }
+
+#define _MASON_DECODE_ARRAY_OBJECT_VALUE(type, name)                                                   \
+    if (mason_reader_array_begin(r)) {                                                                 \
+        size_t _mason_cap = 0;                                                                         \
+        bool _mason_first = true;                                                                      \
+        while (mason_reader_next_element(r, &_mason_first)) {                                          \
+            type *_mason_slot = (type *)_mason_reader_push(r, (void **)&obj->name, &obj->name##_count, \
+                                                           &_mason_cap, sizeof(type));                 \
+            if (!_mason_slot || !type##_decode_reader(_mason_slot, r))                                 \
+                return false;                                                                          \
+        }                                                                                              \
+    } else {                                                                                           \
+        mason_reader_skip(r);                                                                          \
+    }
+
+#define _MASON_DECODE_ARRAY_OBJECT(type, name)       \
+    _MASON_KEY_CASE(name) {                          \
+        _MASON_DECODE_ARRAY_OBJECT_VALUE(type, name) \
+    }
+
+/* A union that comes before its tag is skipped and its start remembered; once
+ * the object is closed the reader is rewound there to decode it */
+#define _MASON_DECODE_UNION_CASE(value, type, member)                                  \
+    _MASON_UNION_CASE(value) {                                                         \
+        *_mason_union_ptr = _mason_reader_calloc(r, sizeof(struct type));              \
+        if (!*_mason_union_ptr || !type##_decode_reader((type *)*_mason_union_ptr, r)) \
+            return false;                                                              \
+    }
+
+#define _MASON_DECODE_UNION_VALUE(tag, name, CASES) \
+    {                                               \
+        _MASON_UNION_SWITCH(tag, name)              \
+        CASES(_MASON_DECODE_UNION_CASE)             \
+        else {                                      \
+            mason_reader_skip(r);                   \
+        }                                           \
+    }
+
+#define _MASON_DECODE_UNION(tag, name, CASES)           \
+    _MASON_KEY_CASE(name) {                             \
+        if (mason_reader_peek(r) != '{') {              \
+            mason_reader_skip(r);                       \
+        } else if (_mason_set_##tag) {                  \
+            _MASON_DECODE_UNION_VALUE(tag, name, CASES) \
+        } else {                                        \
+            _mason_union_at_##name = r->cur;            \
+            mason_reader_skip(r);                       \
+        }                                               \
+    }
+
+#define _MASON_DECODE_UNION_AT(tag, name, CASES) const char *_mason_union_at_##name = NULL;
+
+#define _MASON_DECODE_UNION_DEFERRED(tag, name, CASES) \
+    if (_mason_union_at_##name && _mason_set_##tag) {  \
+        const char *_mason_resume = r->cur;            \
+        r->cur = _mason_union_at_##name;               \
+        r->depth++;                                    \
+        _MASON_DECODE_UNION_VALUE(tag, name, CASES)    \
+        r->depth--;                                    \
+        r->cur = _mason_resume;                        \
+    }
+
+/* X-Macro Expansion Helpers for Decode */
+
+#define _MASON_EXPAND_DECODE_FIELD(type, name)        _MASON_DECODE_FIELD(type, name)
+#define _MASON_EXPAND_DECODE_ARRAY(type, name)        _MASON_DECODE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_DECODE_ARRAY_MULTI(name)        _MASON_DECODE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_DECODE_OBJECT(type, name)       _MASON_DECODE_OBJECT(type, name)
+#define _MASON_EXPAND_DECODE_ARRAY_OBJECT(type, name) _MASON_DECODE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_DECODE_UNION(tag, name, CASES)  _MASON_DECODE_UNION(tag, name, CASES)
+
+/* Partial decode impl
+ *
+ * _decode_reader fills a zeroed struct from the reader's next value. A value
+ * that isn't an object leaves it zeroed, the same as _from_json. It returns
+ * false only on malformed input or allocation failure, in which case the struct
+ * holds whatever was decoded so far and can still be freed normally.
+ *
+ * The _arena variants take every owned allocation (the struct included) from
+ * the arena; on failure the memory used so far is reclaimed by the next reset.
+ *
+ * _from_string_masked only decodes the top-level fields selected by the mask
+ * (see Field Masks in mason.h); the other values are skipped like unknown keys.
+ *
+ * _decode_inplace takes a writable buffer and points string_view fields into
+ * it, so the struct borrows the buffer for its whole lifetime. `string` fields
+ * are still owned copies. Free the struct with Foo_free as usual.
+ */
+#define _MASON_IMPL_DECODE(struct_name, FIELDS)                                                                \
+    bool struct_name##_decode_reader(struct_name *obj, mason_reader *r) {                                      \
+        typedef struct_name##_FieldIndex _mason_fields;                                                        \
+        const mason_field_mask _mason_mask = r->mask;                                                          \
+        const char *_mason_key;                                                                                \
+        size_t _mason_key_len;                                                                                 \
+        bool _mason_first = true;                                                                              \
+        r->mask = MASON_FIELDS_ALL;                                                                            \
+        if (!mason_reader_object_begin(r))                                                                     \
+            return mason_reader_skip(r);                                                                       \
+        FIELDS(_MASON_KEY_SEEN_MASKED_FIELD, _MASON_KEY_SEEN_MASKED, _MASON_KEY_SEEN_MASKED_MULTI,             \
+               _MASON_KEY_SEEN_MASKED, _MASON_KEY_SEEN_MASKED, _MASON_KEY_SEEN_MASKED_UNION)                   \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,           \
+               _MASON_EXPAND_NONE, _MASON_DECODE_UNION_AT)                                                     \
+        while (mason_reader_next_key(r, &_mason_first, &_mason_key, &_mason_key_len)) {                        \
+            size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                    \
+            if (0) {                                                                                           \
+            }                                                                                                  \
+            FIELDS(_MASON_EXPAND_DECODE_FIELD, _MASON_EXPAND_DECODE_ARRAY, _MASON_EXPAND_DECODE_ARRAY_MULTI,   \
+                   _MASON_EXPAND_DECODE_OBJECT, _MASON_EXPAND_DECODE_ARRAY_OBJECT, _MASON_EXPAND_DECODE_UNION) \
+            else {                                                                                             \
+                mason_reader_skip(r);                                                                          \
+            }                                                                                                  \
+            if (r->failed)                                                                                     \
+                return false;                                                                                  \
+        }                                                                                                      \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,           \
+               _MASON_EXPAND_NONE, _MASON_DECODE_UNION_DEFERRED)                                               \
+        return !r->failed;                                                                                     \
+    }                                                                                                          \
+                                                                                                               \
+    struct_name *struct_name##_decode(const char *json_str, size_t len) {                                      \
+        if (!json_str)                                                                                         \
+            return NULL;                                                                                       \
+        struct_name *obj = (struct_name *)MASON_CALLOC(1, sizeof(struct_name));                                \
+        if (!obj)                                                                                              \
+            return NULL;                                                                                       \
+        mason_reader r;                                                                                        \
+        mason_reader_init(&r, json_str, len);                                                                  \
+        if (!struct_name##_decode_reader(obj, &r)) {                                                           \
+            struct_name##_free(obj);                                                                           \
+            return NULL;                                                                                       \
+        }                                                                                                      \
+        return obj;                                                                                            \
+    }                                                                                                          \
+                                                                                                               \
+    struct_name *struct_name##_decode_inplace(char *json_str, size_t len) {                                    \
+        if (!json_str)                                                                                         \
+            return NULL;                                                                                       \
+        struct_name *obj = (struct_name *)MASON_CALLOC(1, sizeof(struct_name));                                \
+        if (!obj)                                                                                              \
+            return NULL;                                                                                       \
+        mason_reader r;                                                                                        \
+        mason_reader_init(&r, json_str, len);                                                                  \
+        r.inplace = true;                                                                                      \
+        if (!struct_name##_decode_reader(obj, &r)) {                                                           \
+            struct_name##_free(obj);                                                                           \
+            return NULL;                                                                                       \
+        }                                                                                                      \
+        return obj;                                                                                            \
+    }                                                                                                          \
+                                                                                                               \
+    struct_name *struct_name##_from_string_masked(const char *json_str, mason_field_mask mask) {               \
+        if (!json_str)                                                                                         \
+            return NULL;                                                                                       \
+        struct_name *obj = (struct_name *)MASON_CALLOC(1, sizeof(struct_name));                                \
+        if (!obj)                                                                                              \
+            return NULL;                                                                                       \
+        mason_reader r;                                                                                        \
+        mason_reader_init(&r, json_str, strlen(json_str));                                                     \
+        r.mask = mask;                                                                                         \
+        if (!struct_name##_decode_reader(obj, &r)) {                                                           \
+            struct_name##_free(obj);                                                                           \
+            return NULL;                                                                                       \
+        }                                                                                                      \
+        return obj;                                                                                            \
+    }                                                                                                          \
+                                                                                                               \
+    struct_name *struct_name##_from_string_sized_arena(mason_arena *arena, const char *json_str, size_t len) { \
+        if (!arena || !json_str)                                                                               \
+            return NULL;                                                                                       \
+        struct_name *obj = (struct_name *)mason_arena_calloc(arena, 1, sizeof(struct_name));                   \
+        if (!obj)                                                                                              \
+            return NULL;                                                                                       \
+        mason_reader r;                                                                                        \
+        mason_reader_init(&r, json_str, len);                                                                  \
+        r.arena = arena;                                                                                       \
+        return struct_name##_decode_reader(obj, &r) ? obj : NULL;                                              \
+    }                                                                                                          \
+                                                                                                               \
+    struct_name *struct_name##_from_string_arena(mason_arena *arena, const char *json_str) {                   \
+        if (!json_str)                                                                                         \
+            return NULL;                                                                                       \
+        return struct_name##_from_string_sized_arena(arena, json_str, strlen(json_str));                       \
+    }
+
+#endif // MASON_DECODE_H
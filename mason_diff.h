@@ -0,0 +1,369 @@
+#ifndef MASON_DIFF_H
+#define MASON_DIFF_H
+
+/* Struct Diff and Merge Patch
+ *
+ * Foo_diff writes an RFC 7386 JSON merge patch that turns `old` into `cur`.
+ * Only members that differ are written: nested OBJECTs (and a UNION whose tag
+ * is unchanged) are diffed recursively, arrays are replaced whole, and a member
+ * that went away (a NULL OBJECT or string) is written as null. It returns the
+ * number of top-level members in the patch, so 0 means there is nothing to send:
+ *
+ *   if (IdentifyPresence_diff(&last_sent, presence, &out))
+ *       send(out.data, out.len);
+ *
+ * Foo_apply_patch merges a patch into a live struct in place: null clears a
+ * member, nested objects are patched member by member and everything else is
+ * replaced. As when decoding, unknown keys and values of the wrong type are
+ * skipped, and string_view members, which would have to borrow the patch, keep
+ * their value. A patch that sets a UNION's tag replaces the union as well: its
+ * payload is decoded from the patch if present there and dropped otherwise.
+ * Patched structs must own their memory, so not arena or snapshot structs.
+ * The patch must be one object with nothing but whitespace after it; any
+ * other input returns false before `obj` is touched.
+ *
+ * JSON has no NaN or infinity, so a double member or primitive array that
+ * changes to one is left out of the patch rather than sent as null, which
+ * would clear it. Inside an object array or a union that is written whole,
+ * one still goes out as null and is patched to 0.
+ */
+
+/* Diff Writers
+ * NOTE: `old` is the previous struct and `obj` the current one, so the field
+ * writers from mason_write.h emit current values
+ */
+
+/* A non-finite double is written as null, which a patch reads as "clear" */
+static inline bool _mason_diff_writable_double(const double *v) { return isfinite(*v); }
+
+static inline bool _mason_diff_writable_rawvalue(const MASON_RawValue *v) {
+    return v->type != MASON_VALUE_DOUBLE || isfinite(v->value.d);
+}
+
+static inline bool _mason_diff_writable_scalar(const void *v) {
+    (void)v;
+    return true;
+}
+
+/* Whether the value at `p` survives a trip through a patch */
+#define _mason_diff_writable(p) _Generic((p),        \
+    double *: _mason_diff_writable_double,           \
+    MASON_RawValue *: _mason_diff_writable_rawvalue, \
+    default: _mason_diff_writable_scalar)(p)
+
+/* Sets `_mason_same` when an element of a changed array cannot be written, so the array is left out */
+#define _MASON_DIFF_KEEP_UNWRITABLE(name)                          \
+    for (size_t i = 0; !_mason_same && i < obj->name##_count; i++) \
+        _mason_same = !_mason_diff_writable(&obj->name[i]);
+
+#define _MASON_DIFF_NULL(name) \
+    _MASON_WRITE_KEY(name)     \
+    _MASON_WRITE_LITERAL(out, "null");
+
+#define _MASON_DIFF_FIELD(type, name)                                                           \
+    if (!mason_equal((_MASON_TYPE_ALIAS(type))old->name, (_MASON_TYPE_ALIAS(type))obj->name) && \
+        _mason_diff_writable(&obj->name)) {                                                     \
+        _MASON_WRITE_FIELD(type, name)                                                          \
+        _mason_changed++;                                                                       \
+    }
+
+#define _MASON_DIFF_ARRAY_PRIM(type, name)                                    \
+    {                                                                         \
+        bool _mason_same = old->name##_count == obj->name##_count;            \
+        for (size_t i = 0; _mason_same && i < obj->name##_count; i++)         \
+            _mason_same = mason_equal((_MASON_TYPE_ALIAS(type))old->name[i],  \
+                                      (_MASON_TYPE_ALIAS(type))obj->name[i]); \
+        _MASON_DIFF_KEEP_UNWRITABLE(name)                                     \
+        if (!_mason_same) {                                                   \
+            _MASON_WRITE_ARRAY_PRIM(type, name)                               \
+            _mason_changed++;                                                 \
+        }                                                                     \
+    }
+
+#define _MASON_DIFF_ARRAY_MULTI(name)                                         \
+    {                                                                         \
+        bool _mason_same = old->name##_count == obj->name##_count;            \
+        for (size_t i = 0; _mason_same && i < obj->name##_count; i++)         \
+            _mason_same = mason_rawvalue_equal(&old->name[i], &obj->name[i]); \
+        _MASON_DIFF_KEEP_UNWRITABLE(name)                                     \
+        if (!_mason_same) {                                                   \
+            _MASON_WRITE_ARRAY_MULTI(name)                                    \
+            _mason_changed++;                                                 \
+        }                                                                     \
+    }
+
+/* A nested diff that comes out empty is taken back along with its key */
+#define _MASON_DIFF_OBJECT(type, name)              \
+    if (!obj->name) {                               \
+        if (old->name) {                            \
+            _MASON_DIFF_NULL(name)                  \
+            _mason_changed++;                       \
+        }                                           \
+    } else if (!old->name) {                        \
+        _MASON_WRITE_OBJECT(type, name)             \
+        _mason_changed++;                           \
+    } else {                                        \
+        size_t _mason_mark = out->len;              \
+        _MASON_WRITE_KEY(name)                      \
+        if (type##_diff(old->name, obj->name, out)) \
+            _mason_changed++;                       \
+        else                                        \
+            out->len = _mason_mark;                 \
+    }
+
+#define _MASON_DIFF_ARRAY_OBJECT(type, name)                          \
+    {                                                                 \
+        bool _mason_same = old->name##_count == obj->name##_count;    \
+        for (size_t i = 0; _mason_same && i < obj->name##_count; i++) \
+            _mason_same = type##_equal(&old->name[i], &obj->name[i]); \
+        if (!_mason_same) {                                           \
+            _MASON_WRITE_ARRAY_OBJECT(type, name)                     \
+            _mason_changed++;                                         \
+        }                                                             \
+    }
+
+#define _MASON_DIFF_UNION_CASE(value, type, member)                                          \
+    _MASON_UNION_CASE(value) {                                                               \
+        if (type##_diff((const type *)_mason_old_ptr, (const type *)*_mason_union_ptr, out)) \
+            _mason_changed++;                                                                \
+        else                                                                                 \
+            out->len = _mason_mark;                                                          \
+    }
+
+#define _MASON_DIFF_SAME_TAG(tag) _mason_union_match(_MASON_UNION_KEY(old->tag), _MASON_UNION_KEY(obj->tag))
+
+/* With the same tag on both sides the payloads have the same type and are
+ * diffed; a new tag sends the whole payload, which replaces the old one when
+ * the patch is applied */
+#define _MASON_DIFF_UNION(tag, name, CASES)                    \
+    if (!obj->name.ptr) {                                      \
+        if (old->name.ptr) {                                   \
+            _MASON_DIFF_NULL(name)                             \
+            _mason_changed++;                                  \
+        }                                                      \
+    } else if (!old->name.ptr || !_MASON_DIFF_SAME_TAG(tag)) { \
+        size_t _mason_mark = out->len;                         \
+        _MASON_WRITE_UNION(tag, name, CASES)                   \
+        _mason_changed += out->len != _mason_mark;             \
+    } else {                                                   \
+        size_t _mason_mark = out->len;                         \
+        const void *_mason_old_ptr = old->name.ptr;            \
+        _MASON_WRITE_KEY(name)                                 \
+        _MASON_UNION_SWITCH(tag, name)                         \
+        CASES(_MASON_DIFF_UNION_CASE)                          \
+        else                                                   \
+            out->len = _mason_mark;                            \
+    }
+
+/* Patch Appliers */
+
+typedef enum {
+    _MASON_PATCH_SKIP,  // value of the wrong type, already skipped
+    _MASON_PATCH_CLEAR, // null, already consumed
+    _MASON_PATCH_VALUE  // a value starting with `open` is next
+} _mason_patch_op;
+
+static inline bool _mason_patch_null(mason_reader *r) {
+    return mason_reader_peek(r) == 'n' && _mason_reader_literal(r, "null", 4);
+}
+
+static inline _mason_patch_op _mason_patch_begin(mason_reader *r, char open) {
+    if (mason_reader_peek(r) == open)
+        return _MASON_PATCH_VALUE;
+    if (_mason_patch_null(r))
+        return _MASON_PATCH_CLEAR;
+    mason_reader_skip(r);
+    return _MASON_PATCH_SKIP;
+}
+
+#define _MASON_APPLY_FIELD(type, name)                \
+    _MASON_KEY_CASE(name) {                           \
+        _MASON_TYPE_ALIAS(type) _mason_value;         \
+        if (_mason_patch_null(r)) {                   \
+            _MASON_FREE_FIELD_DISPATCH(type, name)    \
+            memset(&obj->name, 0, sizeof(obj->name)); \
+        } else if (mason_read(r, &_mason_value)) {    \
+            _MASON_FREE_FIELD_DISPATCH(type, name)    \
+            obj->name = (type)_mason_value;           \
+        }                                             \
+    }
+
+/* Arrays are replaced whole: freed and emptied, then decoded from the patch */
+#define _MASON_APPLY_REPLACE(name, FREE, VALUE)                 \
+    _MASON_KEY_CASE(name) {                                     \
+        _mason_patch_op _mason_op = _mason_patch_begin(r, '['); \
+        if (_mason_op != _MASON_PATCH_SKIP) {                   \
+            FREE                                                \
+            obj->name = NULL;                                   \
+            obj->name##_count = 0;                              \
+        }                                                       \
+        if (_mason_op == _MASON_PATCH_VALUE) {                  \
+            VALUE                                               \
+        }                                                       \
+    }
+
+#define _MASON_APPLY_ARRAY_PRIM(type, name) \
+    _MASON_APPLY_REPLACE(name, _MASON_FREE_ARRAY_DISPATCH(type, name), _MASON_DECODE_ARRAY_PRIM_VALUE(type, name))
+#define _MASON_APPLY_ARRAY_MULTI(name) \
+    _MASON_APPLY_REPLACE(name, _MASON_FREE_ARRAY_MULTI(name), _MASON_DECODE_ARRAY_MULTI_VALUE(name))
+#define _MASON_APPLY_ARRAY_OBJECT(type, name) \
+    _MASON_APPLY_REPLACE(name, _MASON_FREE_ARRAY_OBJECT(type, name), _MASON_DECODE_ARRAY_OBJECT_VALUE(type, name))
+
+/* A missing struct is patched from zero, which is the same as decoding it */
+#define _MASON_APPLY_OBJECT(type, name)                                                  \
+    _MASON_KEY_CASE(name) {                                                              \
+        _mason_patch_op _mason_op = _mason_patch_begin(r, '{');                          \
+        if (_mason_op == _MASON_PATCH_CLEAR) {                                           \
+            _MASON_FREE_OBJECT(type, name)                                               \
+            obj->name = NULL;                                                            \
+        } else if (_mason_op == _MASON_PATCH_VALUE) {                                    \
+            if (!obj->name)                                                              \
+                obj->name = (struct type *)_mason_reader_calloc(r, sizeof(struct type)); \
+            if (!obj->name || !type##_apply_reader(obj->name, r))                        \
+                return false;                                                            \
+        }                                                                                \
+    }
+
+/* Unions are applied after the other members, once the tag has its new value */
+#define _MASON_APPLY_UNION(tag, name, CASES) \
+    _MASON_KEY_CASE(name) {                  \
+        _mason_union_at_##name = r->cur;     \
+        mason_reader_skip(r);                \
+    }
+
+#define _MASON_APPLY_UNION_CASE(value, type, member)                                  \
+    _MASON_UNION_CASE(value) {                                                        \
+        if (!*_mason_union_ptr)                                                       \
+            *_mason_union_ptr = _mason_reader_calloc(r, sizeof(struct type));         \
+        if (!*_mason_union_ptr || !type##_apply_reader((type *)*_mason_union_ptr, r)) \
+            return false;                                                             \
+    }
+
+#define _MASON_APPLY_UNION_DEFERRED(tag, name, CASES)           \
+    if (_mason_union_at_##name) {                               \
+        const char *_mason_resume = r->cur;                     \
+        r->cur = _mason_union_at_##name;                        \
+        r->depth++;                                             \
+        _mason_patch_op _mason_op = _mason_patch_begin(r, '{'); \
+        if (_mason_op == _MASON_PATCH_CLEAR) {                  \
+            _MASON_FREE_UNION(tag, name, CASES)                 \
+            obj->name.ptr = NULL;                               \
+        } else if (_mason_op == _MASON_PATCH_VALUE) {           \
+            _MASON_UNION_SWITCH(tag, name)                      \
+            CASES(_MASON_APPLY_UNION_CASE)                      \
+            else {                                              \
+                mason_reader_skip(r);                           \
+            }                                                   \
+        }                                                       \
+        r->depth--;                                             \
+        r->cur = _mason_resume;                                 \
+    }
+
+/* A payload is only valid for the tag it was decoded for, so when the patch
+ * sets the tag it is freed (by the old tag) before anything else changes.
+ * A tag value of the wrong type is skipped when applied and keeps the payload. */
+static inline bool _mason_patch_sets_tag(mason_reader *r, _mason_union_key tag) {
+    char c = mason_reader_peek(r);
+    if (c == 'n')
+        return true;
+    return tag.is_str ? c == '"' : c == '-' || (c >= '0' && c <= '9');
+}
+
+#define _MASON_APPLY_LIVE_UNION(tag, name, CASES) || obj->name.ptr
+
+#define _MASON_APPLY_RETAG(tag, name, CASES)                                                        \
+    if (_MASON_KEY_MATCH(tag) && _mason_patch_sets_tag(&_mason_scan, _MASON_UNION_KEY(obj->tag))) { \
+        _MASON_FREE_UNION(tag, name, CASES)                                                         \
+        obj->name.ptr = NULL;                                                                       \
+    }
+
+/* X-Macro Expansion Helpers for Diff */
+
+#define _MASON_EXPAND_DIFF_FIELD(type, name)         _MASON_DIFF_FIELD(type, name)
+#define _MASON_EXPAND_DIFF_ARRAY(type, name)         _MASON_DIFF_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_DIFF_ARRAY_MULTI(name)         _MASON_DIFF_ARRAY_MULTI(name)
+#define _MASON_EXPAND_DIFF_OBJECT(type, name)        _MASON_DIFF_OBJECT(type, name)
+#define _MASON_EXPAND_DIFF_ARRAY_OBJECT(type, name)  _MASON_DIFF_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_DIFF_UNION(tag, name, CASES)   _MASON_DIFF_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_APPLY_FIELD(type, name)        _MASON_APPLY_FIELD(type, name)
+#define _MASON_EXPAND_APPLY_ARRAY(type, name)        _MASON_APPLY_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_APPLY_ARRAY_MULTI(name)        _MASON_APPLY_ARRAY_MULTI(name)
+#define _MASON_EXPAND_APPLY_OBJECT(type, name)       _MASON_APPLY_OBJECT(type, name)
+#define _MASON_EXPAND_APPLY_ARRAY_OBJECT(type, name) _MASON_APPLY_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_APPLY_UNION(tag, name, CASES)  _MASON_APPLY_UNION(tag, name, CASES)
+
+/* Partial diff impl */
+#define _MASON_IMPL_DIFF(struct_name, FIELDS)                                                               \
+    size_t struct_name##_diff(const struct_name *old, const struct_name *cur, mason_buf *out) {             \
+        if (!old || !cur || !out)                                                                           \
+            return 0;                                                                                       \
+        struct_name *obj = (struct_name *)cur;                                                              \
+        size_t _mason_start = out->len;                                                                     \
+        size_t _mason_changed = 0;                                                                          \
+        FIELDS(_MASON_EXPAND_DIFF_FIELD, _MASON_EXPAND_DIFF_ARRAY, _MASON_EXPAND_DIFF_ARRAY_MULTI,          \
+               _MASON_EXPAND_DIFF_OBJECT, _MASON_EXPAND_DIFF_ARRAY_OBJECT, _MASON_EXPAND_DIFF_UNION)        \
+        mason_write_close(out, _mason_start, '{', '}');                                                     \
+        return out->failed ? 0 : _mason_changed;                                                            \
+    }                                                                                                       \
+                                                                                                            \
+    bool struct_name##_apply_reader(struct_name *obj, mason_reader *r) {                                    \
+        const char *_mason_key;                                                                             \
+        size_t _mason_key_len;                                                                              \
+        bool _mason_first = true;                                                                           \
+        bool _mason_retag = false FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI,  \
+                                         _MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_APPLY_LIVE_UNION);  \
+        if (_mason_retag && mason_reader_peek(r) == '{') {                                                  \
+            mason_reader _mason_scan = *r;                                                                  \
+            if (mason_reader_object_begin(&_mason_scan)) {                                                  \
+                while (mason_reader_next_key(&_mason_scan, &_mason_first, &_mason_key, &_mason_key_len)) {  \
+                    size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                         \
+                    (void)_mason_tag;                                                                       \
+                    FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI,                \
+                           _MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_APPLY_RETAG)                      \
+                    mason_reader_skip(&_mason_scan);                                                        \
+                }                                                                                           \
+            }                                                                                               \
+            if (_mason_scan.failed)                                                                         \
+                return mason_reader_fail(r);                                                                \
+            _mason_first = true;                                                                            \
+        }                                                                                                   \
+        if (!mason_reader_object_begin(r))                                                                  \
+            return mason_reader_skip(r);                                                                    \
+        FIELDS(_MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_MULTI,                \
+               _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_UNION)                \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,        \
+               _MASON_EXPAND_NONE, _MASON_DECODE_UNION_AT)                                                  \
+        while (mason_reader_next_key(r, &_mason_first, &_mason_key, &_mason_key_len)) {                     \
+            size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                 \
+            if (0) {                                                                                        \
+            }                                                                                               \
+            FIELDS(_MASON_EXPAND_APPLY_FIELD, _MASON_EXPAND_APPLY_ARRAY, _MASON_EXPAND_APPLY_ARRAY_MULTI,   \
+                   _MASON_EXPAND_APPLY_OBJECT, _MASON_EXPAND_APPLY_ARRAY_OBJECT, _MASON_EXPAND_APPLY_UNION) \
+            else {                                                                                          \
+                mason_reader_skip(r);                                                                       \
+            }                                                                                               \
+            if (r->failed)                                                                                  \
+                return false;                                                                               \
+        }                                                                                                   \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,        \
+               _MASON_EXPAND_NONE, _MASON_APPLY_UNION_DEFERRED)                                             \
+        return !r->failed;                                                                                  \
+    }                                                                                                       \
+                                                                                                            \
+    bool struct_name##_apply_patch(struct_name *obj, const char *patch, size_t len) {                       \
+        if (!obj || !patch)                                                                                 \
+            return false;                                                                                   \
+        mason_reader r;                                                                                     \
+        mason_reader_init(&r, patch, len);                                                                  \
+        r.skip_views = true;                                                                                \
+        if (mason_reader_peek(&r) != '{')                                                                   \
+            return false;                                                                                   \
+        /* Checked whole first so a malformed patch leaves `obj` untouched */                               \
+        mason_reader _mason_scan = r;                                                                       \
+        if (!mason_reader_skip(&_mason_scan) || mason_reader_peek(&_mason_scan) != '\0')                    \
+            return false;                                                                                   \
+        return struct_name##_apply_reader(obj, &r);                                                         \
+    }
+
+#endif // MASON_DIFF_H
@@ -0,0 +1,1089 @@
+#ifndef MASON_ETF_H
+#define MASON_ETF_H
+
+/* Erlang External Term Format
+ *
+ * Foo_from_etf/Foo_to_etf encode the same FIELDS as a map term, the shape
+ * Discord's gateway uses with `encoding=etf`. Decoding follows the JSON path:
+ * missing or mistyped fields stay zeroed, type aliases resolve the same way and
+ * the first of duplicate keys wins. Keys may be atoms or binaries; strings are
+ * binaries and null is the atom `nil` (`null` is accepted too). Integers keep
+ * every bit: int64 values outside 32 bits are written as small big-ints and
+ * read back exactly.
+ *
+ * A string_view value fails the decode: a binary is not NUL-terminated and the
+ * next term's tag follows it directly, so there is nowhere to terminate it in
+ * place.
+ * Compressed terms (tag 80) are rejected.
+ */
+
+#define MASON_ETF_VERSION 131
+
+enum {
+    MASON_ETF_NEW_FLOAT = 70,
+    MASON_ETF_BIT_BINARY = 77,
+    MASON_ETF_COMPRESSED = 80,
+    MASON_ETF_SMALL_INTEGER = 97,
+    MASON_ETF_INTEGER = 98,
+    MASON_ETF_FLOAT = 99,
+    MASON_ETF_ATOM = 100,
+    MASON_ETF_SMALL_TUPLE = 104,
+    MASON_ETF_LARGE_TUPLE = 105,
+    MASON_ETF_NIL = 106,
+    MASON_ETF_STRING = 107,
+    MASON_ETF_LIST = 108,
+    MASON_ETF_BINARY = 109,
+    MASON_ETF_SMALL_BIG = 110,
+    MASON_ETF_LARGE_BIG = 111,
+    MASON_ETF_SMALL_ATOM = 115,
+    MASON_ETF_MAP = 116,
+    MASON_ETF_ATOM_UTF8 = 118,
+    MASON_ETF_SMALL_ATOM_UTF8 = 119,
+};
+
+/* Reader */
+
+typedef struct {
+    const uint8_t *cur;
+    const uint8_t *end;
+    size_t depth;
+    bool failed;
+    size_t byte_elems; // bytes left in a STRING_EXT list, read as small integers
+} mason_etf_reader;
+
+static inline void mason_etf_reader_init(mason_etf_reader *r, const uint8_t *data, size_t len) {
+    r->cur = data;
+    r->end = data + len;
+    r->depth = 0;
+    r->failed = false;
+    r->byte_elems = 0;
+}
+
+static inline bool mason_etf_fail(mason_etf_reader *r) {
+    r->failed = true;
+    r->cur = r->end;
+    r->byte_elems = 0;
+    return false;
+}
+
+static inline bool _mason_etf_need(mason_etf_reader *r, size_t n) {
+    return (size_t)(r->end - r->cur) >= n || mason_etf_fail(r);
+}
+
+static inline uint32_t _mason_etf_be(const uint8_t *p, size_t n) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < n; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/* Tag of the next term without consuming it, 0 at the end of the input */
+static inline uint8_t mason_etf_peek(mason_etf_reader *r) {
+    if (r->byte_elems)
+        return MASON_ETF_SMALL_INTEGER;
+    return r->cur < r->end ? *r->cur : 0;
+}
+
+/* Consumes a tag followed by an n-byte big-endian length */
+static inline bool _mason_etf_header(mason_etf_reader *r, size_t n, uint32_t *len) {
+    if (!_mason_etf_need(r, 1 + n))
+        return false;
+    *len = _mason_etf_be(r->cur + 1, n);
+    r->cur += 1 + n;
+    return true;
+}
+
+/* Consumes an atom of any encoding */
+static inline bool _mason_etf_atom(mason_etf_reader *r, const char **name, size_t *len) {
+    uint32_t n;
+    switch (mason_etf_peek(r)) {
+    case MASON_ETF_ATOM:
+    case MASON_ETF_ATOM_UTF8:
+        if (!_mason_etf_header(r, 2, &n))
+            return false;
+        break;
+    case MASON_ETF_SMALL_ATOM:
+    case MASON_ETF_SMALL_ATOM_UTF8:
+        if (!_mason_etf_header(r, 1, &n))
+            return false;
+        break;
+    default:
+        return false;
+    }
+    if (!_mason_etf_need(r, n))
+        return false;
+    *name = (const char *)r->cur;
+    *len = n;
+    r->cur += n;
+    return true;
+}
+
+/* Consumes a BINARY_EXT and returns its bytes */
+static inline bool _mason_etf_binary(mason_etf_reader *r, const char **data, size_t *len) {
+    uint32_t n;
+    if (mason_etf_peek(r) != MASON_ETF_BINARY || !_mason_etf_header(r, 4, &n) || !_mason_etf_need(r, n))
+        return false;
+    *data = (const char *)r->cur;
+    *len = n;
+    r->cur += n;
+    return true;
+}
+
+#define _MASON_ETF_ATOM_IS(name, len, lit) ((len) == sizeof(lit) - 1 && memcmp((name), lit, sizeof(lit) - 1) == 0)
+
+static inline bool _mason_etf_is_atom_tag(uint8_t tag) {
+    return tag == MASON_ETF_ATOM || tag == MASON_ETF_ATOM_UTF8 || tag == MASON_ETF_SMALL_ATOM ||
+           tag == MASON_ETF_SMALL_ATOM_UTF8;
+}
+
+static inline bool mason_etf_skip(mason_etf_reader *r);
+
+static inline bool _mason_etf_skip_terms(mason_etf_reader *r, uint64_t count) {
+    if (r->depth >= MASON_READER_NESTING_LIMIT)
+        return mason_etf_fail(r);
+    r->depth++;
+    for (uint64_t i = 0; i < count; i++)
+        if (!mason_etf_skip(r))
+            return false;
+    r->depth--;
+    return true;
+}
+
+/* Skips the next term without allocating */
+static inline bool mason_etf_skip(mason_etf_reader *r) {
+    uint32_t n;
+    const char *atom;
+    size_t atom_len;
+    if (r->byte_elems) {
+        r->byte_elems--;
+        r->cur++;
+        return true;
+    }
+    switch (mason_etf_peek(r)) {
+    case MASON_ETF_SMALL_INTEGER:
+        return _mason_etf_header(r, 1, &n);
+    case MASON_ETF_INTEGER:
+        return _mason_etf_header(r, 4, &n);
+    case MASON_ETF_NEW_FLOAT:
+        return _mason_etf_need(r, 9) && (r->cur += 9);
+    case MASON_ETF_FLOAT:
+        return _mason_etf_need(r, 32) && (r->cur += 32);
+    case MASON_ETF_ATOM:
+    case MASON_ETF_ATOM_UTF8:
+    case MASON_ETF_SMALL_ATOM:
+    case MASON_ETF_SMALL_ATOM_UTF8:
+        return _mason_etf_atom(r, &atom, &atom_len);
+    case MASON_ETF_NIL:
+        r->cur++;
+        return true;
+    case MASON_ETF_STRING:
+        return _mason_etf_header(r, 2, &n) && _mason_etf_need(r, n) && (r->cur += n);
+    case MASON_ETF_BINARY:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_need(r, n) && (r->cur += n);
+    case MASON_ETF_BIT_BINARY:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_need(r, (size_t)n + 1) && (r->cur += (size_t)n + 1);
+    case MASON_ETF_SMALL_BIG:
+        return _mason_etf_header(r, 1, &n) && _mason_etf_need(r, (size_t)n + 1) && (r->cur += (size_t)n + 1);
+    case MASON_ETF_LARGE_BIG:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_need(r, (size_t)n + 1) && (r->cur += (size_t)n + 1);
+    case MASON_ETF_SMALL_TUPLE:
+        return _mason_etf_header(r, 1, &n) && _mason_etf_skip_terms(r, n);
+    case MASON_ETF_LARGE_TUPLE:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_skip_terms(r, n);
+    case MASON_ETF_LIST:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_skip_terms(r, (uint64_t)n + 1);
+    case MASON_ETF_MAP:
+        return _mason_etf_header(r, 4, &n) && _mason_etf_skip_terms(r, (uint64_t)n * 2);
+    default:
+        return mason_etf_fail(r);
+    }
+}
+
+/* Maps and lists
+ *
+ * Usage:
+ *   uint32_t arity;
+ *   if (mason_etf_map_begin(r, &arity))
+ *       for (i < arity) { key...; value...; }  then mason_etf_map_end(r)
+ *
+ *   mason_etf_list list;
+ *   if (mason_etf_list_begin(r, &list))
+ *       while (mason_etf_list_next(r, &list)) { ...consume element... }
+ */
+
+static inline bool _mason_etf_enter(mason_etf_reader *r) {
+    if (r->depth >= MASON_READER_NESTING_LIMIT)
+        return mason_etf_fail(r);
+    r->depth++;
+    return true;
+}
+
+/* Consumes the map header if the next term is a map, otherwise leaves it in place */
+static inline bool mason_etf_map_begin(mason_etf_reader *r, uint32_t *arity) {
+    if (mason_etf_peek(r) != MASON_ETF_MAP)
+        return false;
+    return _mason_etf_header(r, 4, arity) && _mason_etf_enter(r);
+}
+
+static inline void mason_etf_map_end(mason_etf_reader *r) { r->depth--; }
+
+/* Reads an atom or binary key; any other key is skipped and false returned */
+static inline bool mason_etf_key(mason_etf_reader *r, const char **key, size_t *len) {
+    uint8_t tag = mason_etf_peek(r);
+    if (_mason_etf_is_atom_tag(tag))
+        return _mason_etf_atom(r, key, len);
+    if (tag == MASON_ETF_BINARY)
+        return _mason_etf_binary(r, key, len);
+    mason_etf_skip(r);
+    return false;
+}
+
+typedef struct {
+    size_t left;
+    bool tail; // LIST_EXT ends with a tail term, normally NIL_EXT
+} mason_etf_list;
+
+/* Accepts the empty list, LIST_EXT and STRING_EXT (a list of bytes) */
+static inline bool mason_etf_list_begin(mason_etf_reader *r, mason_etf_list *list) {
+    uint32_t n;
+    switch (mason_etf_peek(r)) {
+    case MASON_ETF_NIL:
+        r->cur++;
+        list->left = 0;
+        list->tail = false;
+        return _mason_etf_enter(r);
+    case MASON_ETF_LIST:
+        if (!_mason_etf_header(r, 4, &n))
+            return false;
+        list->left = n;
+        list->tail = true;
+        return _mason_etf_enter(r);
+    case MASON_ETF_STRING:
+        if (!_mason_etf_header(r, 2, &n) || !_mason_etf_need(r, n))
+            return false;
+        list->left = n;
+        list->tail = false;
+        r->byte_elems = n;
+        return _mason_etf_enter(r);
+    default:
+        return false;
+    }
+}
+
+/* Advances to the next element, consuming the tail after the last one */
+static inline bool mason_etf_list_next(mason_etf_reader *r, mason_etf_list *list) {
+    if (r->failed)
+        return false;
+    if (list->left) {
+        list->left--;
+        return true;
+    }
+    r->depth--;
+    if (list->tail) {
+        list->tail = false;
+        mason_etf_skip(r);
+    }
+    return false;
+}
+
+/* Scalars
+ *
+ * Numbers convert like the JSON path: every numeric term is accepted by every
+ * numeric field, int32 saturates, and a term of the wrong kind leaves the field
+ * untouched.
+ */
+
+static inline bool _mason_etf_mismatch(mason_etf_reader *r) {
+    mason_etf_skip(r);
+    return false;
+}
+
+/* Reads any numeric term; `exact` is false when only `*d` holds the value */
+static inline bool _mason_etf_number(mason_etf_reader *r, int64_t *i, double *d, bool *exact) {
+    uint32_t n;
+    *exact = true;
+    if (r->byte_elems) {
+        r->byte_elems--;
+        *i = *r->cur++;
+        *d = (double)*i;
+        return true;
+    }
+    switch (mason_etf_peek(r)) {
+    case MASON_ETF_SMALL_INTEGER:
+        if (!_mason_etf_header(r, 1, &n))
+            return false;
+        *i = n;
+        *d = (double)n;
+        return true;
+    case MASON_ETF_INTEGER:
+        if (!_mason_etf_header(r, 4, &n))
+            return false;
+        *i = (int32_t)n;
+        *d = (double)*i;
+        return true;
+    case MASON_ETF_SMALL_BIG:
+    case MASON_ETF_LARGE_BIG: {
+        if (!_mason_etf_header(r, *r->cur == MASON_ETF_SMALL_BIG ? 1 : 4, &n) || !_mason_etf_need(r, (size_t)n + 1))
+            return false;
+        bool negative = r->cur[0] != 0;
+        const uint8_t *digits = r->cur + 1;
+        r->cur += (size_t)n + 1;
+        /* Little-endian base-256 digits */
+        uint64_t magnitude = 0;
+        double approx = 0;
+        for (uint32_t k = n; k-- > 0;) {
+            approx = approx * 256 + digits[k];
+            if (k >= 8 && digits[k])
+                *exact = false;
+            else if (k < 8)
+                magnitude |= (uint64_t)digits[k] << (8 * k);
+        }
+        if (*exact && magnitude > (negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX))
+            *exact = false;
+        *d = negative ? -approx : approx;
+        if (*exact)
+            *i = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+        return true;
+    }
+    case MASON_ETF_NEW_FLOAT: {
+        if (!_mason_etf_need(r, 9))
+            return false;
+        uint64_t bits = ((uint64_t)_mason_etf_be(r->cur + 1, 4) << 32) | _mason_etf_be(r->cur + 5, 4);
+        memcpy(d, &bits, sizeof(*d));
+        r->cur += 9;
+        *exact = false;
+        return true;
+    }
+    case MASON_ETF_FLOAT: {
+        /* Legacy 31-byte "%.20e" text */
+        if (!_mason_etf_need(r, 32))
+            return false;
+        char text[32];
+        memcpy(text, r->cur + 1, 31);
+        text[31] = '\0';
+        *d = strtod(text, NULL);
+        r->cur += 32;
+        *exact = false;
+        return true;
+    }
+    default:
+        return _mason_etf_mismatch(r);
+    }
+}
+
+static inline bool mason_etf_read_int32(mason_etf_reader *r, int32_t *out) {
+    int64_t i;
+    double d;
+    bool exact;
+    if (!_mason_etf_number(r, &i, &d, &exact))
+        return false;
+    if (exact)
+        *out = i >= INT32_MAX ? INT32_MAX : i <= INT32_MIN ? INT32_MIN : (int32_t)i;
+    else
+        *out = d >= INT32_MAX ? INT32_MAX : d <= INT32_MIN ? INT32_MIN : (int32_t)d;
+    return true;
+}
+
+static inline bool mason_etf_read_int64(mason_etf_reader *r, int64_t *out) {
+    int64_t i;
+    double d;
+    bool exact;
+    if (!_mason_etf_number(r, &i, &d, &exact))
+        return false;
+    if (exact)
+        *out = i;
+    else if (d != d) // NaN
+        *out = 0;
+    else
+        *out = d >= 0x1p63 ? INT64_MAX : d <= -0x1p63 ? INT64_MIN : (int64_t)d;
+    return true;
+}
+
+static inline bool mason_etf_read_double(mason_etf_reader *r, double *out) {
+    int64_t i;
+    double d;
+    bool exact;
+    if (!_mason_etf_number(r, &i, &d, &exact))
+        return false;
+    *out = exact ? (double)i : d;
+    return true;
+}
+
+static inline bool mason_etf_read_string(mason_etf_reader *r, char **out) {
+    const char *data;
+    size_t len;
+    if (mason_etf_peek(r) != MASON_ETF_BINARY || r->byte_elems)
+        return _mason_etf_mismatch(r);
+    if (!_mason_etf_binary(r, &data, &len))
+        return false;
+    char *s = (char *)MASON_MALLOC(len + 1);
+    if (!s)
+        return mason_etf_fail(r);
+    memcpy(s, data, len);
+    s[len] = '\0';
+    *out = s;
+    return true;
+}
+
+static inline bool mason_etf_read_string_view(mason_etf_reader *r, const char **out) {
+    (void)out;
+    if (mason_etf_peek(r) != MASON_ETF_BINARY || r->byte_elems)
+        return _mason_etf_mismatch(r);
+    return mason_etf_fail(r);
+}
+
+static inline bool mason_etf_read_interned(mason_etf_reader *r, mason_interned_t *out) {
+    const char *data;
+    size_t len;
+    if (mason_etf_peek(r) != MASON_ETF_BINARY || r->byte_elems)
+        return _mason_etf_mismatch(r);
+    if (!_mason_etf_binary(r, &data, &len))
+        return false;
+    const char *s = mason_intern(data, len);
+    if (!s)
+        return mason_etf_fail(r);
+    *out = (mason_interned_t)s;
+    return true;
+}
+
+static inline bool mason_etf_read_bool(mason_etf_reader *r, bool *out) {
+    const char *atom;
+    size_t len;
+    if (!_mason_etf_is_atom_tag(mason_etf_peek(r)))
+        return _mason_etf_mismatch(r);
+    if (!_mason_etf_atom(r, &atom, &len))
+        return false;
+    if (_MASON_ETF_ATOM_IS(atom, len, "true"))
+        *out = true;
+    else if (_MASON_ETF_ATOM_IS(atom, len, "false"))
+        *out = false;
+    else
+        return false;
+    return true;
+}
+
+#define mason_etf_read(r, out) _Generic((out),   \
+    int32_t *: mason_etf_read_int32,             \
+    int64_t *: mason_etf_read_int64,             \
+    double *: mason_etf_read_double,             \
+    char **: mason_etf_read_string,              \
+    const char **: mason_etf_read_string_view,   \
+    mason_interned_t *: mason_etf_read_interned, \
+    _Bool *: mason_etf_read_bool)(r, out)
+
+/* Grows a decoded array by one zeroed slot, like _mason_reader_push */
+static inline void *_mason_etf_push(mason_etf_reader *r, void **arr, size_t *count, size_t *cap, size_t elem_size) {
+    if (*count == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 8;
+        void *grown = MASON_REALLOC(*arr, new_cap * elem_size);
+        if (!grown) {
+            mason_etf_fail(r);
+            return NULL;
+        }
+        *arr = grown;
+        *cap = new_cap;
+    }
+    void *slot = (char *)*arr + *count * elem_size;
+    memset(slot, 0, elem_size);
+    (*count)++;
+    return slot;
+}
+
+/* ARRAY_MULTI values; nested lists, tuples and maps become JSON handles */
+
+static inline MASON_Parsed _mason_etf_to_ast(mason_etf_reader *r) {
+    int64_t i;
+    double d;
+    bool exact;
+    const char *data;
+    size_t len;
+    uint32_t n;
+    uint8_t tag = mason_etf_peek(r);
+    switch (tag) {
+    case MASON_ETF_SMALL_INTEGER:
+    case MASON_ETF_INTEGER:
+    case MASON_ETF_SMALL_BIG:
+    case MASON_ETF_LARGE_BIG:
+    case MASON_ETF_NEW_FLOAT:
+    case MASON_ETF_FLOAT:
+        if (!_mason_etf_number(r, &i, &d, &exact))
+            return NULL;
+        return cJSON_CreateNumber(exact ? (double)i : d);
+    case MASON_ETF_ATOM:
+    case MASON_ETF_ATOM_UTF8:
+    case MASON_ETF_SMALL_ATOM:
+    case MASON_ETF_SMALL_ATOM_UTF8:
+    case MASON_ETF_BINARY: {
+        if (!(tag == MASON_ETF_BINARY ? _mason_etf_binary(r, &data, &len) : _mason_etf_atom(r, &data, &len)))
+            return NULL;
+        if (tag != MASON_ETF_BINARY) {
+            if (_MASON_ETF_ATOM_IS(data, len, "true") || _MASON_ETF_ATOM_IS(data, len, "false"))
+                return cJSON_CreateBool(len == 4);
+            if (_MASON_ETF_ATOM_IS(data, len, "nil") || _MASON_ETF_ATOM_IS(data, len, "null"))
+                return cJSON_CreateNull();
+        }
+        char *s = (char *)MASON_MALLOC(len + 1);
+        if (!s)
+            return NULL;
+        memcpy(s, data, len);
+        s[len] = '\0';
+        MASON_Parsed str = cJSON_CreateString(s);
+        MASON_FREE(s);
+        return str;
+    }
+    case MASON_ETF_NIL:
+    case MASON_ETF_LIST:
+    case MASON_ETF_STRING:
+    case MASON_ETF_SMALL_TUPLE:
+    case MASON_ETF_LARGE_TUPLE: {
+        mason_etf_list list;
+        if (tag == MASON_ETF_SMALL_TUPLE || tag == MASON_ETF_LARGE_TUPLE) {
+            if (!_mason_etf_header(r, tag == MASON_ETF_SMALL_TUPLE ? 1 : 4, &n) || !_mason_etf_enter(r))
+                return NULL;
+            list.left = n;
+            list.tail = false;
+        } else if (!mason_etf_list_begin(r, &list)) {
+            return NULL;
+        }
+        MASON_Parsed arr = cJSON_CreateArray();
+        while (arr && mason_etf_list_next(r, &list)) {
+            MASON_Parsed elem = _mason_etf_to_ast(r);
+            if (!elem) {
+                mason_delete(arr);
+                return NULL;
+            }
+            cJSON_AddItemToArray(arr, elem);
+        }
+        return arr && !r->failed ? arr : (mason_delete(arr), (MASON_Parsed)NULL);
+    }
+    case MASON_ETF_MAP: {
+        if (!mason_etf_map_begin(r, &n))
+            return NULL;
+        MASON_Parsed obj = cJSON_CreateObject();
+        for (uint32_t k = 0; obj && k < n; k++) {
+            char key[256];
+            bool named = mason_etf_key(r, &data, &len) && len < sizeof(key);
+            if (named) {
+                memcpy(key, data, len);
+                key[len] = '\0';
+            }
+            MASON_Parsed value = r->failed ? NULL : named ? _mason_etf_to_ast(r) : (mason_etf_skip(r), NULL);
+            if (r->failed) {
+                mason_delete(value);
+                mason_delete(obj);
+                return NULL;
+            }
+            if (value)
+                cJSON_AddItemToObject(obj, key, value);
+        }
+        mason_etf_map_end(r);
+        return obj;
+    }
+    default:
+        mason_etf_fail(r);
+        return NULL;
+    }
+}
+
+static inline bool _mason_etf_read_rawvalue(mason_etf_reader *r, MASON_RawValue *out) {
+    int64_t i;
+    double d;
+    bool exact;
+    const char *data;
+    size_t len;
+    uint8_t tag = mason_etf_peek(r);
+    switch (tag) {
+    case MASON_ETF_SMALL_INTEGER:
+    case MASON_ETF_INTEGER:
+    case MASON_ETF_SMALL_BIG:
+    case MASON_ETF_LARGE_BIG:
+    case MASON_ETF_NEW_FLOAT:
+    case MASON_ETF_FLOAT:
+        if (!_mason_etf_number(r, &i, &d, &exact))
+            return false;
+        if (!exact)
+            *out = mason_rawvalue_double(d);
+        else if (i >= INT32_MIN && i <= INT32_MAX)
+            *out = mason_rawvalue_int32_t((int32_t)i);
+        else
+            *out = mason_rawvalue_int64_t(i);
+        return true;
+    case MASON_ETF_BINARY: {
+        if (!_mason_etf_binary(r, &data, &len))
+            return false;
+        char *s = (char *)MASON_MALLOC(len + 1);
+        if (!s)
+            return mason_etf_fail(r);
+        memcpy(s, data, len);
+        s[len] = '\0';
+        out->type = MASON_VALUE_STRING;
+        out->value.s = s;
+        return true;
+    }
+    case MASON_ETF_ATOM:
+    case MASON_ETF_ATOM_UTF8:
+    case MASON_ETF_SMALL_ATOM:
+    case MASON_ETF_SMALL_ATOM_UTF8:
+        if (!_mason_etf_atom(r, &data, &len))
+            return false;
+        if (_MASON_ETF_ATOM_IS(data, len, "true") || _MASON_ETF_ATOM_IS(data, len, "false")) {
+            *out = mason_rawvalue_bool(len == 4);
+        } else if (_MASON_ETF_ATOM_IS(data, len, "nil") || _MASON_ETF_ATOM_IS(data, len, "null")) {
+            *out = mason_rawvalue_null();
+        } else {
+            char *s = (char *)MASON_MALLOC(len + 1);
+            if (!s)
+                return mason_etf_fail(r);
+            memcpy(s, data, len);
+            s[len] = '\0';
+            out->type = MASON_VALUE_STRING;
+            out->value.s = s;
+        }
+        return true;
+    default: {
+        MASON_Parsed ast = _mason_etf_to_ast(r);
+        if (!ast)
+            return r->failed ? false : mason_etf_fail(r);
+        *out = tag == MASON_ETF_MAP ? mason_rawvalue_object(ast) : mason_rawvalue_array(ast);
+        return true;
+    }
+    }
+}
+
+/* Writer */
+
+static inline void _mason_etf_put(mason_buf *out, uint8_t tag, uint64_t value, size_t bytes) {
+    char tmp[9];
+    tmp[0] = (char)tag;
+    for (size_t i = 0; i < bytes; i++)
+        tmp[1 + i] = (char)(value >> (8 * (bytes - 1 - i)));
+    mason_buf_append(out, tmp, 1 + bytes);
+}
+
+static inline void _mason_etf_write_atom(mason_buf *out, const char *name, size_t len) {
+    _mason_etf_put(out, MASON_ETF_SMALL_ATOM_UTF8, len, 1);
+    mason_buf_append(out, name, len);
+}
+
+static inline void _mason_etf_write_binary(mason_buf *out, const char *data, size_t len) {
+    _mason_etf_put(out, MASON_ETF_BINARY, len, 4);
+    mason_buf_append(out, data, len);
+}
+
+/* Keys are atoms, which only hold 255 bytes; longer keys fall back to binaries */
+static inline void _mason_etf_write_key(mason_buf *out, const char *key, size_t len) {
+    if (len <= 255)
+        _mason_etf_write_atom(out, key, len);
+    else
+        _mason_etf_write_binary(out, key, len);
+}
+
+static inline void _mason_etf_write_nil(mason_buf *out) { _mason_etf_write_atom(out, "nil", 3); }
+
+static inline void mason_etf_write_int64(mason_buf *out, int64_t v) {
+    if (v >= 0 && v <= 255) {
+        _mason_etf_put(out, MASON_ETF_SMALL_INTEGER, (uint64_t)v, 1);
+    } else if (v >= INT32_MIN && v <= INT32_MAX) {
+        _mason_etf_put(out, MASON_ETF_INTEGER, (uint32_t)(int32_t)v, 4);
+    } else {
+        uint64_t magnitude = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+        char digits[10];
+        size_t n = 0;
+        while (magnitude) {
+            digits[2 + n++] = (char)(magnitude & 0xFF);
+            magnitude >>= 8;
+        }
+        digits[0] = (char)n;
+        digits[1] = (char)(v < 0);
+        mason_buf_putc(out, (char)MASON_ETF_SMALL_BIG);
+        mason_buf_append(out, digits, 2 + n);
+    }
+}
+
+static inline void mason_etf_write_int32(mason_buf *out, int32_t v) { mason_etf_write_int64(out, v); }
+
+static inline void mason_etf_write_double(mason_buf *out, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    _mason_etf_put(out, MASON_ETF_NEW_FLOAT, bits, 8);
+}
+
+static inline void mason_etf_write_string(mason_buf *out, const char *v) {
+    if (v)
+        _mason_etf_write_binary(out, v, strlen(v));
+    else
+        _mason_etf_write_nil(out);
+}
+
+static inline void mason_etf_write_interned(mason_buf *out, mason_interned_t v) {
+    mason_etf_write_string(out, (const char *)v);
+}
+
+static inline void mason_etf_write_bool(mason_buf *out, bool v) {
+    _mason_etf_write_atom(out, v ? "true" : "false", v ? 4 : 5);
+}
+
+#define mason_etf_write(out, value) _Generic((value), \
+    int32_t: mason_etf_write_int32,                   \
+    int64_t: mason_etf_write_int64,                   \
+    double: mason_etf_write_double,                   \
+    char *: mason_etf_write_string,                   \
+    const char *: mason_etf_write_string,             \
+    mason_interned_t: mason_etf_write_interned,       \
+    _Bool: mason_etf_write_bool)(out, value)
+
+/* A non-empty list ends with a NIL_EXT tail */
+static inline void _mason_etf_write_list_begin(mason_buf *out, size_t count) {
+    if (count)
+        _mason_etf_put(out, MASON_ETF_LIST, count, 4);
+}
+
+static inline void _mason_etf_write_list_end(mason_buf *out) { mason_buf_putc(out, (char)MASON_ETF_NIL); }
+
+/* Rewrites the u32 arity reserved at `at` once the entries are known */
+static inline void _mason_etf_patch_arity(mason_buf *out, size_t at, uint32_t arity) {
+    if (out->failed || at + 4 > out->len)
+        return;
+    for (size_t i = 0; i < 4; i++)
+        out->data[at + i] = (char)(arity >> (8 * (3 - i)));
+}
+
+static inline void mason_etf_write_ast(mason_buf *out, MASON_Parsed item) {
+    if (!item) {
+        _mason_etf_write_nil(out);
+        return;
+    }
+    switch (item->type & 0xFF) {
+    case cJSON_False:
+    case cJSON_True:
+        mason_etf_write_bool(out, (item->type & 0xFF) == cJSON_True);
+        break;
+    case cJSON_Number: {
+        double d = item->valuedouble;
+        if (d >= -0x1p63 && d < 0x1p63 && d == (double)(int64_t)d)
+            mason_etf_write_int64(out, (int64_t)d);
+        else
+            mason_etf_write_double(out, d);
+        break;
+    }
+    case cJSON_String:
+    case cJSON_Raw:
+        mason_etf_write_string(out, item->valuestring);
+        break;
+    case cJSON_Array: {
+        size_t count = 0;
+        for (MASON_Parsed child = item->child; child; child = child->next)
+            count++;
+        _mason_etf_write_list_begin(out, count);
+        for (MASON_Parsed child = item->child; child; child = child->next)
+            mason_etf_write_ast(out, child);
+        _mason_etf_write_list_end(out);
+        break;
+    }
+    case cJSON_Object: {
+        size_t at = out->len + 1;
+        uint32_t arity = 0;
+        _mason_etf_put(out, MASON_ETF_MAP, 0, 4);
+        for (MASON_Parsed child = item->child; child; child = child->next, arity++) {
+            const char *key = child->string ? child->string : "";
+            _mason_etf_write_key(out, key, strlen(key));
+            mason_etf_write_ast(out, child);
+        }
+        _mason_etf_patch_arity(out, at, arity);
+        break;
+    }
+    default:
+        _mason_etf_write_nil(out);
+        break;
+    }
+}
+
+static inline void _mason_etf_write_rawvalue(mason_buf *out, const MASON_RawValue *val) {
+    switch (val->type) {
+    case MASON_VALUE_INT32:
+        mason_etf_write_int32(out, val->value.i32);
+        break;
+    case MASON_VALUE_INT64:
+        mason_etf_write_int64(out, val->value.i64);
+        break;
+    case MASON_VALUE_DOUBLE:
+        mason_etf_write_double(out, val->value.d);
+        break;
+    case MASON_VALUE_STRING:
+        mason_etf_write_string(out, val->value.s);
+        break;
+    case MASON_VALUE_BOOL:
+        mason_etf_write_bool(out, val->value.b);
+        break;
+    case MASON_VALUE_ARRAY:
+    case MASON_VALUE_OBJECT:
+        mason_etf_write_ast(out, val->value.ast);
+        break;
+    default:
+        _mason_etf_write_nil(out);
+        break;
+    }
+}
+
+/* Field Decoders */
+
+#define _MASON_ETF_DECODE_FIELD(type, name)     \
+    _MASON_KEY_CASE(name) {                     \
+        _MASON_TYPE_ALIAS(type) _mason_value;   \
+        if (mason_etf_read(r, &_mason_value)) { \
+            obj->name = (type)_mason_value;     \
+            _mason_set_##name = true;           \
+        }                                       \
+    }
+
+#define _MASON_ETF_DECODE_ARRAY_PRIM(type, name)                                                        \
+    _MASON_KEY_CASE(name) {                                                                             \
+        mason_etf_list _mason_list;                                                                     \
+        if (mason_etf_list_begin(r, &_mason_list)) {                                                    \
+            size_t _mason_cap = 0;                                                                      \
+            while (mason_etf_list_next(r, &_mason_list)) {                                              \
+                _MASON_TYPE_ALIAS(type) _mason_value;                                                   \
+                type *_mason_slot = (type *)_mason_etf_push(r, (void **)&obj->name, &obj->name##_count, \
+                                                            &_mason_cap, sizeof(type));                 \
+                if (!_mason_slot)                                                                       \
+                    return false;                                                                       \
+                if (mason_etf_read(r, &_mason_value))                                                   \
+                    *_mason_slot = (type)_mason_value;                                                  \
+            }                                                                                           \
+        } else {                                                                                        \
+            mason_etf_skip(r);                                                                          \
+        }                                                                                               \
+    }
+
+#define _MASON_ETF_DECODE_ARRAY_MULTI(name)                                                           \
+    _MASON_KEY_CASE(name) {                                                                           \
+        mason_etf_list _mason_list;                                                                   \
+        if (mason_etf_list_begin(r, &_mason_list)) {                                                  \
+            size_t _mason_cap = 0;                                                                    \
+            while (mason_etf_list_next(r, &_mason_list)) {                                            \
+                MASON_RawValue *_mason_slot = (MASON_RawValue *)_mason_etf_push(                      \
+                    r, (void **)&obj->name, &obj->name##_count, &_mason_cap, sizeof(MASON_RawValue)); \
+                if (!_mason_slot || !_mason_etf_read_rawvalue(r, _mason_slot))                        \
+                    return false;                                                                     \
+            }                                                                                         \
+        } else {                                                                                      \
+            mason_etf_skip(r);                                                                        \
+        }                                                                                             \
+    }
+
+#define _MASON_ETF_DECODE_OBJECT(type, name)                                 \
+    _MASON_KEY_CASE(name) {                                                  \
+        if (mason_etf_peek(r) == MASON_ETF_MAP) {                            \
+            obj->name = (struct type *)MASON_CALLOC(1, sizeof(struct type)); \
+            if (!obj->name)                                                  \
+                return mason_etf_fail(r);                                    \
+            if (!type##_etf_decode_term(obj->name, r))                       \
+                return false;                                                \
+        } else {                                                             \
+            mason_etf_skip(r);                                               \
+        }                                                                    \
+    }
+
+#define _MASON_ETF_DECODE_ARRAY_OBJECT(type, name)                                                      \
+    _MASON_KEY_CASE(name) {                                                                             \
+        mason_etf_list _mason_list;                                                                     \
+        if (mason_etf_list_begin(r, &_mason_list)) {                                                    \
+            size_t _mason_cap = 0;                                                                      \
+            while (mason_etf_list_next(r, &_mason_list)) {                                              \
+                type *_mason_slot = (type *)_mason_etf_push(r, (void **)&obj->name, &obj->name##_count, \
+                                                            &_mason_cap, sizeof(type));                 \
+                if (!_mason_slot || !type##_etf_decode_term(_mason_slot, r))                            \
+                    return false;                                                                       \
+            }                                                                                           \
+        } else {                                                                                        \
+            mason_etf_skip(r);                                                                          \
+        }                                                                                               \
+    }
+
+/* A union ahead of its tag is decoded after the other entries, like in _decode_reader */
+#define _MASON_ETF_DECODE_UNION_CASE(value, type, member)          \
+    _MASON_UNION_CASE(value) {                                     \
+        *_mason_union_ptr = MASON_CALLOC(1, sizeof(struct type));  \
+        if (!*_mason_union_ptr)                                    \
+            return mason_etf_fail(r);                              \
+        if (!type##_etf_decode_term((type *)*_mason_union_ptr, r)) \
+            return false;                                          \
+    }
+
+#define _MASON_ETF_DECODE_UNION_VALUE(tag, name, CASES) \
+    {                                                   \
+        _MASON_UNION_SWITCH(tag, name)                  \
+        CASES(_MASON_ETF_DECODE_UNION_CASE)             \
+        else {                                          \
+            mason_etf_skip(r);                          \
+        }                                               \
+    }
+
+#define _MASON_ETF_DECODE_UNION(tag, name, CASES)           \
+    _MASON_KEY_CASE(name) {                                 \
+        if (mason_etf_peek(r) != MASON_ETF_MAP) {           \
+            mason_etf_skip(r);                              \
+        } else if (_mason_set_##tag) {                      \
+            _MASON_ETF_DECODE_UNION_VALUE(tag, name, CASES) \
+        } else {                                            \
+            _mason_etf_union_at_##name = r->cur;            \
+            mason_etf_skip(r);                              \
+        }                                                   \
+    }
+
+#define _MASON_ETF_DECODE_UNION_AT(tag, name, CASES) const uint8_t *_mason_etf_union_at_##name = NULL;
+
+#define _MASON_ETF_DECODE_UNION_DEFERRED(tag, name, CASES) \
+    if (_mason_etf_union_at_##name && _mason_set_##tag) {  \
+        const uint8_t *_mason_resume = r->cur;             \
+        r->cur = _mason_etf_union_at_##name;               \
+        _MASON_ETF_DECODE_UNION_VALUE(tag, name, CASES)    \
+        r->cur = _mason_resume;                            \
+    }
+
+/* Field Writers */
+
+#define _MASON_ETF_KEY(name)                              \
+    _mason_etf_write_atom(out, #name, sizeof(#name) - 1); \
+    _mason_arity++;
+
+#define _MASON_ETF_WRITE_FIELD(type, name) \
+    _MASON_ETF_KEY(name)                   \
+    mason_etf_write(out, (_MASON_TYPE_ALIAS(type))obj->name);
+
+#define _MASON_ETF_WRITE_ARRAY_PRIM(type, name)                      \
+    _MASON_ETF_KEY(name)                                             \
+    _mason_etf_write_list_begin(out, obj->name##_count);             \
+    for (size_t i = 0; i < obj->name##_count; i++)                   \
+        mason_etf_write(out, (_MASON_TYPE_ALIAS(type))obj->name[i]); \
+    _mason_etf_write_list_end(out);
+
+#define _MASON_ETF_WRITE_ARRAY_MULTI(name)               \
+    _MASON_ETF_KEY(name)                                 \
+    _mason_etf_write_list_begin(out, obj->name##_count); \
+    for (size_t i = 0; i < obj->name##_count; i++)       \
+        _mason_etf_write_rawvalue(out, &obj->name[i]);   \
+    _mason_etf_write_list_end(out);
+
+#define _MASON_ETF_WRITE_OBJECT(type, name)    \
+    if (obj->name) {                           \
+        _MASON_ETF_KEY(name)                   \
+        type##_etf_write_term(obj->name, out); \
+    }
+
+#define _MASON_ETF_WRITE_ARRAY_OBJECT(type, name)        \
+    _MASON_ETF_KEY(name)                                 \
+    _mason_etf_write_list_begin(out, obj->name##_count); \
+    for (size_t i = 0; i < obj->name##_count; i++)       \
+        type##_etf_write_term(&obj->name[i], out);       \
+    _mason_etf_write_list_end(out);
+
+#define _MASON_ETF_WRITE_UNION_CASE(value, type, member)       \
+    _MASON_UNION_CASE(value) {                                 \
+        type##_etf_write_term((type *)*_mason_union_ptr, out); \
+    }
+
+#define _MASON_ETF_WRITE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                         \
+        size_t _mason_key_mark = out->len;       \
+        _MASON_ETF_KEY(name)                     \
+        _MASON_UNION_SWITCH(tag, name)           \
+        CASES(_MASON_ETF_WRITE_UNION_CASE)       \
+        else {                                   \
+            out->len = _mason_key_mark;          \
+            _mason_arity--;                      \
+        }                                        \
+    }
+
+/* X-Macro Expansion Helpers for ETF */
+
+#define _MASON_EXPAND_ETF_DECODE_FIELD(type, name)        _MASON_ETF_DECODE_FIELD(type, name)
+#define _MASON_EXPAND_ETF_DECODE_ARRAY(type, name)        _MASON_ETF_DECODE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_ETF_DECODE_ARRAY_MULTI(name)        _MASON_ETF_DECODE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_ETF_DECODE_OBJECT(type, name)       _MASON_ETF_DECODE_OBJECT(type, name)
+#define _MASON_EXPAND_ETF_DECODE_ARRAY_OBJECT(type, name) _MASON_ETF_DECODE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_ETF_DECODE_UNION(tag, name, CASES)  _MASON_ETF_DECODE_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_ETF_WRITE_FIELD(type, name)        _MASON_ETF_WRITE_FIELD(type, name)
+#define _MASON_EXPAND_ETF_WRITE_ARRAY(type, name)        _MASON_ETF_WRITE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_ETF_WRITE_ARRAY_MULTI(name)        _MASON_ETF_WRITE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_ETF_WRITE_OBJECT(type, name)       _MASON_ETF_WRITE_OBJECT(type, name)
+#define _MASON_EXPAND_ETF_WRITE_ARRAY_OBJECT(type, name) _MASON_ETF_WRITE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_ETF_WRITE_UNION(tag, name, CASES)  _MASON_ETF_WRITE_UNION(tag, name, CASES)
+
+/* Partial ETF impl
+ *
+ * _etf_decode_term fills a zeroed struct from the next term; anything but a map
+ * leaves it zeroed. Like _decode_reader it returns false only on malformed
+ * input or allocation failure. _etf_write_term appends the map term without the
+ * version byte, which Foo_to_etf adds in front.
+ */
+#define _MASON_IMPL_ETF(struct_name, FIELDS)                                                                      \
+    bool struct_name##_etf_decode_term(struct_name *obj, mason_etf_reader *r) {                                   \
+        const char *_mason_key;                                                                                   \
+        size_t _mason_key_len;                                                                                    \
+        uint32_t _mason_arity;                                                                                    \
+        if (!mason_etf_map_begin(r, &_mason_arity))                                                               \
+            return mason_etf_skip(r);                                                                             \
+        FIELDS(_MASON_EXPAND_KEY_SEEN_FIELD, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_MULTI,                \
+               _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_UNION)                      \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,              \
+               _MASON_EXPAND_NONE, _MASON_ETF_DECODE_UNION_AT)                                                    \
+        for (uint32_t _mason_i = 0; _mason_i < _mason_arity; _mason_i++) {                                        \
+            if (!mason_etf_key(r, &_mason_key, &_mason_key_len)) {                                                \
+                if (!mason_etf_skip(r))                                                                           \
+                    return false;                                                                                 \
+                continue;                                                                                         \
+            }                                                                                                     \
+            size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                       \
+            if (0) {                                                                                              \
+            }                                                                                                     \
+            FIELDS(_MASON_EXPAND_ETF_DECODE_FIELD, _MASON_EXPAND_ETF_DECODE_ARRAY,                                \
+                   _MASON_EXPAND_ETF_DECODE_ARRAY_MULTI, _MASON_EXPAND_ETF_DECODE_OBJECT,                         \
+                   _MASON_EXPAND_ETF_DECODE_ARRAY_OBJECT, _MASON_EXPAND_ETF_DECODE_UNION)                         \
+            else {                                                                                                \
+                mason_etf_skip(r);                                                                                \
+            }                                                                                                     \
+            if (r->failed)                                                                                        \
+                return false;                                                                                     \
+        }                                                                                                         \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,              \
+               _MASON_EXPAND_NONE, _MASON_ETF_DECODE_UNION_DEFERRED)                                              \
+        mason_etf_map_end(r);                                                                                     \
+        return !r->failed;                                                                                        \
+    }                                                                                                             \
+                                                                                                                  \
+    struct_name *struct_name##_from_etf(const uint8_t *data, size_t len) {                                        \
+        if (!data || len < 1 || data[0] != MASON_ETF_VERSION)                                                     \
+            return NULL;                                                                                          \
+        struct_name *obj = (struct_name *)MASON_CALLOC(1, sizeof(struct_name));                                   \
+        if (!obj)                                                                                                 \
+            return NULL;                                                                                          \
+        mason_etf_reader r;                                                                                       \
+        mason_etf_reader_init(&r, data + 1, len - 1);                                                             \
+        if (!struct_name##_etf_decode_term(obj, &r)) {                                                            \
+            struct_name##_free(obj);                                                                              \
+            return NULL;                                                                                          \
+        }                                                                                                         \
+        return obj;                                                                                               \
+    }                                                                                                             \
+                                                                                                                  \
+    bool struct_name##_etf_write_term(struct_name *obj, mason_buf *out) {                                         \
+        size_t _mason_at = out->len + 1;                                                                          \
+        uint32_t _mason_arity = 0;                                                                                \
+        _mason_etf_put(out, MASON_ETF_MAP, 0, 4);                                                                 \
+        FIELDS(_MASON_EXPAND_ETF_WRITE_FIELD, _MASON_EXPAND_ETF_WRITE_ARRAY, _MASON_EXPAND_ETF_WRITE_ARRAY_MULTI, \
+               _MASON_EXPAND_ETF_WRITE_OBJECT, _MASON_EXPAND_ETF_WRITE_ARRAY_OBJECT,                              \
+               _MASON_EXPAND_ETF_WRITE_UNION)                                                                     \
+        _mason_etf_patch_arity(out, _mason_at, _mason_arity);                                                     \
+        return !out->failed;                                                                                      \
+    }                                                                                                             \
+                                                                                                                  \
+    bool struct_name##_to_etf(struct_name *obj, mason_buf *out) {                                                 \
+        if (!obj || !out)                                                                                         \
+            return false;                                                                                         \
+        mason_buf_putc(out, (char)MASON_ETF_VERSION);                                                             \
+        return struct_name##_etf_write_term(obj, out);                                                            \
+    }
+
+#endif // MASON_ETF_H
@@ -0,0 +1,155 @@
+#ifndef MASON_FILE_H
+#define MASON_FILE_H
+
+#include <stdio.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MASON_HAVE_MMAP 1
+#else
+#define MASON_HAVE_MMAP 0
+#endif
+
+/* Mapped Input Files
+ *
+ * mason_map_file maps a file read-only so it can be decoded in place, without
+ * copying it into a heap buffer first. The mapping is advised for sequential
+ * access where the headers offer madvise (not under strict -std=c11), which
+ * lets the kernel read ahead and drop pages behind the decoder.
+ * Files that cannot be mapped (pipes, special files, platforms without mmap)
+ * are read into an owned buffer instead; the data is NOT NUL-terminated in
+ * either case, so always use the length.
+ *
+ * mason_map_file_writable maps the file copy-on-write instead, for decoders
+ * that patch the data in place (snapshot loading). Writes never reach the file.
+ */
+
+typedef struct {
+    const char *data;
+    size_t len;
+    bool mapped; // false when data is an owned heap copy
+} mason_file;
+
+static inline bool _mason_read_stream(FILE *fp, mason_file *file) {
+    mason_buf buf;
+    mason_buf_init(&buf);
+    char chunk[16384];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        mason_buf_append(&buf, chunk, n);
+    if (ferror(fp) || buf.failed) {
+        mason_buf_free(&buf);
+        return false;
+    }
+    file->len = buf.len;
+    file->data = mason_buf_detach(&buf);
+    file->mapped = false;
+    return file->data != NULL;
+}
+
+#if MASON_HAVE_MMAP
+/* Plain read() rather than fdopen, which strict ISO C headers leave undeclared */
+static inline bool _mason_read_fd(int fd, mason_file *file) {
+    mason_buf buf;
+    mason_buf_init(&buf);
+    char chunk[16384];
+    for (;;) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            if (n < 0)
+                buf.failed = true;
+            break;
+        }
+        mason_buf_append(&buf, chunk, (size_t)n);
+    }
+    if (buf.failed) {
+        mason_buf_free(&buf);
+        return false;
+    }
+    file->len = buf.len;
+    file->data = mason_buf_detach(&buf);
+    file->mapped = false;
+    return file->data != NULL;
+}
+#endif
+
+static inline bool _mason_map_file(const char *path, mason_file *file, bool writable) {
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = false;
+    if (!path)
+        return false;
+#if MASON_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *p = mmap(NULL, (size_t)st.st_size, prot, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+            close(fd);
+            file->data = (const char *)p;
+            file->len = (size_t)st.st_size;
+            file->mapped = true;
+            return true;
+        }
+    }
+    bool ok = _mason_read_fd(fd, file);
+    close(fd);
+    return ok;
+#else
+    (void)writable;
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    bool ok = _mason_read_stream(fp, file);
+    fclose(fp);
+    return ok;
+#endif
+}
+
+/* Returns false and leaves errno set if the file cannot be opened or read */
+static inline bool mason_map_file(const char *path, mason_file *file) { return _mason_map_file(path, file, false); }
+
+/* Same, but the data may be modified; changes stay private to the mapping */
+static inline bool mason_map_file_writable(const char *path, mason_file *file) {
+    return _mason_map_file(path, file, true);
+}
+
+static inline void mason_unmap_file(mason_file *file) {
+    if (!file->data)
+        return;
+#if MASON_HAVE_MMAP
+    if (file->mapped)
+        munmap((void *)file->data, file->len);
+    else
+        MASON_FREE((void *)file->data);
+#else
+    MASON_FREE((void *)file->data);
+#endif
+    file->data = NULL;
+    file->len = 0;
+}
+
+/* Partial file impl */
+#define _MASON_IMPL_FILE(struct_name, FIELDS)                         \
+    struct_name *struct_name##_from_file(const char *path) {          \
+        mason_file file;                                              \
+        if (!mason_map_file(path, &file))                             \
+            return NULL;                                              \
+        struct_name *obj = struct_name##_decode(file.data, file.len); \
+        mason_unmap_file(&file);                                      \
+        return obj;                                                   \
+    }
+
+#endif // MASON_FILE_H
@@ -0,0 +1,410 @@
+#ifndef MASON_HASH_H
+#define MASON_HASH_H
+
+/* Equality and Hashing
+ *
+ * Foo_equal compares two structs field by field, recursing into nested objects,
+ * arrays and unions, and Foo_hash folds the same fields into a 64-bit hash, so
+ * decoded structs can key a hash table or dedupe cache without serializing:
+ *
+ *   uint64_t h = Foo_hash(obj, seed);
+ *   for (Entry *e = table[h % n]; e; e = e->next)
+ *       if (e->hash == h && Foo_equal(e->obj, obj))
+ *           return e;
+ *
+ * Equal structs always hash the same. Equality follows the JSON values, so a
+ * NULL array equals an empty one, NaN equals NaN and interned strings are
+ * compared by pointer. Objects inside ARRAY_MULTI values match with their keys
+ * in any order. Hashes depend on byte order, so keep them within one process.
+ */
+
+/* Value Equality */
+
+static inline bool mason_equal_int32(int32_t a, int32_t b) { return a == b; }
+static inline bool mason_equal_int64(int64_t a, int64_t b) { return a == b; }
+static inline bool mason_equal_bool(bool a, bool b) { return a == b; }
+
+/* NaN is written as null, so two NaNs are the same value */
+static inline bool mason_equal_double(double a, double b) { return a == b || (a != a && b != b); }
+
+static inline bool mason_equal_string(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* Interned strings are equal exactly when they are the same pointer */
+static inline bool mason_equal_interned(mason_interned_t a, mason_interned_t b) { return a == b; }
+
+#define mason_equal(a, b) _Generic((a),     \
+    int32_t: mason_equal_int32,             \
+    int64_t: mason_equal_int64,             \
+    double: mason_equal_double,             \
+    char *: mason_equal_string,             \
+    const char *: mason_equal_string,       \
+    mason_interned_t: mason_equal_interned, \
+    _Bool: mason_equal_bool)(a, b)
+
+/* The member of `b` with x's key and the same position among members with that key, so that with equal sizes every
+ * member of `b` is matched once even when keys repeat */
+static inline MASON_Parsed _mason_ast_same_member(MASON_Parsed a, MASON_Parsed x, MASON_Parsed b) {
+    size_t nth = 0;
+    for (MASON_Parsed m = a->child; m != x; m = m->next)
+        nth += m->string && strcmp(m->string, x->string) == 0;
+    for (MASON_Parsed y = b->child; y; y = y->next)
+        if (y->string && strcmp(y->string, x->string) == 0 && nth-- == 0)
+            return y;
+    return NULL;
+}
+
+/* Like cJSON_Compare, but numbers must match exactly so equal trees hash the same */
+static inline bool _mason_ast_equal(MASON_Parsed a, MASON_Parsed b) {
+    if ((a->type & 0xFF) != (b->type & 0xFF))
+        return false;
+    switch (a->type & 0xFF) {
+    case cJSON_Number:
+        return mason_equal_double(a->valuedouble, b->valuedouble);
+    case cJSON_String:
+    case cJSON_Raw:
+        return mason_equal_string(a->valuestring, b->valuestring);
+    case cJSON_Array: {
+        MASON_Parsed x = a->child, y = b->child;
+        for (; x && y; x = x->next, y = y->next)
+            if (!_mason_ast_equal(x, y))
+                return false;
+        return !x && !y;
+    }
+    case cJSON_Object: {
+        if (cJSON_GetArraySize(a) != cJSON_GetArraySize(b))
+            return false;
+        for (MASON_Parsed x = a->child; x; x = x->next) {
+            MASON_Parsed y = x->string ? _mason_ast_same_member(a, x, b) : NULL;
+            if (!y || !_mason_ast_equal(x, y))
+                return false;
+        }
+        return true;
+    }
+    default:
+        return true;
+    }
+}
+
+static inline bool mason_rawvalue_equal(const MASON_RawValue *a, const MASON_RawValue *b) {
+    if (a->type != b->type)
+        return false;
+    switch (a->type) {
+    case MASON_VALUE_NULL:
+        return true;
+    case MASON_VALUE_INT32:
+        return a->value.i32 == b->value.i32;
+    case MASON_VALUE_INT64:
+        return a->value.i64 == b->value.i64;
+    case MASON_VALUE_DOUBLE:
+        return mason_equal_double(a->value.d, b->value.d);
+    case MASON_VALUE_STRING:
+        return mason_equal_string(a->value.s, b->value.s);
+    case MASON_VALUE_BOOL:
+        return a->value.b == b->value.b;
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        if (!a->value.ast || !b->value.ast)
+            return a->value.ast == b->value.ast;
+        return _mason_ast_equal(a->value.ast, b->value.ast);
+    }
+    return false;
+}
+
+/* Hashing
+ *
+ * Words are mixed in with the MurmurHash3 round and the result is finalized
+ * with its avalanche step, so arrays of fixed-size values hash 8 bytes at a time.
+ */
+
+#define _MASON_HASH_NULL 0x9e3779b97f4a7c15u
+
+static inline uint64_t _mason_hash_rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t _mason_hash_word(uint64_t h, uint64_t w) {
+    w *= 0x87c37b91114253d5u;
+    w = _mason_hash_rotl(w, 31);
+    w *= 0x4cf5ad432745937fu;
+    h ^= w;
+    h = _mason_hash_rotl(h, 27);
+    return h * 5 + 0x52dce729;
+}
+
+static inline uint64_t _mason_hash_final(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdu;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53u;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Hashes `len` bytes a word at a time, the length included */
+static inline uint64_t mason_hash_bytes(const void *data, size_t len, uint64_t h) {
+    const unsigned char *p = (const unsigned char *)data;
+    h = _mason_hash_word(h, len);
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = _mason_hash_word(h, w);
+    }
+    if (len) {
+        uint64_t w = 0;
+        memcpy(&w, p, len);
+        h = _mason_hash_word(h, w);
+    }
+    return h;
+}
+
+static inline uint64_t mason_hash_int32(int32_t v, uint64_t h) { return _mason_hash_word(h, (uint64_t)(uint32_t)v); }
+static inline uint64_t mason_hash_int64(int64_t v, uint64_t h) { return _mason_hash_word(h, (uint64_t)v); }
+static inline uint64_t mason_hash_bool(bool v, uint64_t h) { return _mason_hash_word(h, v); }
+
+/* -0.0 and every NaN hash like 0.0 and one NaN, matching mason_equal_double */
+static inline uint64_t mason_hash_double(double v, uint64_t h) {
+    uint64_t w = 0x7ff8000000000000u;
+    if (v == 0)
+        w = 0;
+    else if (v == v)
+        memcpy(&w, &v, sizeof(w));
+    return _mason_hash_word(h, w);
+}
+
+static inline uint64_t mason_hash_string(const char *v, uint64_t h) {
+    return v ? mason_hash_bytes(v, strlen(v), h) : _mason_hash_word(h, _MASON_HASH_NULL);
+}
+
+/* By content rather than pointer, so hashes don't depend on where strings were interned */
+static inline uint64_t mason_hash_interned(mason_interned_t v, uint64_t h) {
+    return mason_hash_string((const char *)v, h);
+}
+
+#define mason_hash(v, h) _Generic((v),     \
+    int32_t: mason_hash_int32,             \
+    int64_t: mason_hash_int64,             \
+    double: mason_hash_double,             \
+    char *: mason_hash_string,             \
+    const char *: mason_hash_string,       \
+    mason_interned_t: mason_hash_interned, \
+    _Bool: mason_hash_bool)(v, h)
+
+/* Arrays of fixed-size values hash their memory directly */
+static inline uint64_t mason_hash_array_int32(const int32_t *arr, size_t count, uint64_t h) {
+    return mason_hash_bytes(arr, count * sizeof(*arr), h);
+}
+
+static inline uint64_t mason_hash_array_int64(const int64_t *arr, size_t count, uint64_t h) {
+    return mason_hash_bytes(arr, count * sizeof(*arr), h);
+}
+
+static inline uint64_t mason_hash_array_bool(const bool *arr, size_t count, uint64_t h) {
+    return mason_hash_bytes(arr, count * sizeof(*arr), h);
+}
+
+static inline uint64_t mason_hash_array_double(const double *arr, size_t count, uint64_t h) {
+    h = _mason_hash_word(h, count);
+    for (size_t i = 0; i < count; i++)
+        h = mason_hash_double(arr[i], h);
+    return h;
+}
+
+static inline uint64_t mason_hash_array_string(char *const *arr, size_t count, uint64_t h) {
+    h = _mason_hash_word(h, count);
+    for (size_t i = 0; i < count; i++)
+        h = mason_hash_string(arr[i], h);
+    return h;
+}
+
+static inline uint64_t mason_hash_array_string_view(const char *const *arr, size_t count, uint64_t h) {
+    h = _mason_hash_word(h, count);
+    for (size_t i = 0; i < count; i++)
+        h = mason_hash_string(arr[i], h);
+    return h;
+}
+
+static inline uint64_t mason_hash_array_interned(const mason_interned_t *arr, size_t count, uint64_t h) {
+    h = _mason_hash_word(h, count);
+    for (size_t i = 0; i < count; i++)
+        h = mason_hash_interned(arr[i], h);
+    return h;
+}
+
+#define mason_hash_array(arr, count, h) _Generic((arr), \
+    int32_t *: mason_hash_array_int32,                  \
+    int64_t *: mason_hash_array_int64,                  \
+    double *: mason_hash_array_double,                  \
+    char **: mason_hash_array_string,                   \
+    const char **: mason_hash_array_string_view,        \
+    mason_interned_t *: mason_hash_array_interned,      \
+    _Bool *: mason_hash_array_bool)(arr, count, h)
+
+/* Object members are summed so their order doesn't matter, as in _mason_ast_equal */
+static inline uint64_t _mason_hash_ast(MASON_Parsed item, uint64_t h) {
+    h = _mason_hash_word(h, (uint64_t)(item->type & 0xFF));
+    switch (item->type & 0xFF) {
+    case cJSON_Number:
+        return mason_hash_double(item->valuedouble, h);
+    case cJSON_String:
+    case cJSON_Raw:
+        return mason_hash_string(item->valuestring, h);
+    case cJSON_Array:
+        for (MASON_Parsed child = item->child; child; child = child->next)
+            h = _mason_hash_ast(child, h);
+        return h;
+    case cJSON_Object: {
+        uint64_t members = 0;
+        for (MASON_Parsed child = item->child; child; child = child->next)
+            members += _mason_hash_final(_mason_hash_ast(child, mason_hash_string(child->string, 0)));
+        return _mason_hash_word(h, members);
+    }
+    default:
+        return h;
+    }
+}
+
+static inline uint64_t mason_rawvalue_hash(const MASON_RawValue *v, uint64_t h) {
+    h = _mason_hash_word(h, (uint64_t)v->type);
+    switch (v->type) {
+    case MASON_VALUE_INT32:
+        return mason_hash_int32(v->value.i32, h);
+    case MASON_VALUE_INT64:
+        return mason_hash_int64(v->value.i64, h);
+    case MASON_VALUE_DOUBLE:
+        return mason_hash_double(v->value.d, h);
+    case MASON_VALUE_STRING:
+        return mason_hash_string(v->value.s, h);
+    case MASON_VALUE_BOOL:
+        return mason_hash_bool(v->value.b, h);
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        return v->value.ast ? _mason_hash_ast(v->value.ast, h) : _mason_hash_word(h, _MASON_HASH_NULL);
+    default:
+        return h;
+    }
+}
+
+/* Field Comparisons (obj and other are the two structs) */
+
+#define _MASON_EQUAL_FIELD(type, name)                                                          \
+    if (!mason_equal((_MASON_TYPE_ALIAS(type))obj->name, (_MASON_TYPE_ALIAS(type))other->name)) \
+        return false;
+
+#define _MASON_EQUAL_ARRAY_PRIM(type, name)                                                               \
+    if (obj->name##_count != other->name##_count)                                                         \
+        return false;                                                                                     \
+    for (size_t i = 0; i < obj->name##_count; i++)                                                        \
+        if (!mason_equal((_MASON_TYPE_ALIAS(type))obj->name[i], (_MASON_TYPE_ALIAS(type))other->name[i])) \
+            return false;
+
+#define _MASON_EQUAL_ARRAY_MULTI(name)                             \
+    if (obj->name##_count != other->name##_count)                  \
+        return false;                                              \
+    for (size_t i = 0; i < obj->name##_count; i++)                 \
+        if (!mason_rawvalue_equal(&obj->name[i], &other->name[i])) \
+            return false;
+
+#define _MASON_EQUAL_OBJECT(type, name)        \
+    if (!type##_equal(obj->name, other->name)) \
+        return false;
+
+#define _MASON_EQUAL_ARRAY_OBJECT(type, name)              \
+    if (obj->name##_count != other->name##_count)          \
+        return false;                                      \
+    for (size_t i = 0; i < obj->name##_count; i++)         \
+        if (!type##_equal(&obj->name[i], &other->name[i])) \
+            return false;
+
+#define _MASON_EQUAL_UNION_CASE(value, type, member)                                        \
+    _MASON_UNION_CASE(value) {                                                              \
+        if (!type##_equal((const type *)*_mason_union_ptr, (const type *)_mason_other_ptr)) \
+            return false;                                                                   \
+    }
+
+/* Payloads are only the same type when the tags match, whichever field comes first */
+#define _MASON_EQUAL_UNION(tag, name, CASES)                                                    \
+    if (!obj->name.ptr || !other->name.ptr) {                                                   \
+        if (obj->name.ptr != other->name.ptr)                                                   \
+            return false;                                                                       \
+    } else if (!_mason_union_match(_MASON_UNION_KEY(obj->tag), _MASON_UNION_KEY(other->tag))) { \
+        return false;                                                                           \
+    } else {                                                                                    \
+        const void *_mason_other_ptr = other->name.ptr;                                         \
+        _MASON_UNION_SWITCH(tag, name)                                                          \
+        CASES(_MASON_EQUAL_UNION_CASE)                                                          \
+    }
+
+/* Field Hashes */
+
+#define _MASON_HASH_FIELD(type, name) _mason_hash = mason_hash((_MASON_TYPE_ALIAS(type))obj->name, _mason_hash);
+
+#define _MASON_HASH_ARRAY_PRIM(type, name) \
+    _mason_hash = mason_hash_array((_MASON_TYPE_ALIAS(type) *)obj->name, obj->name##_count, _mason_hash);
+
+#define _MASON_HASH_ARRAY_MULTI(name)                               \
+    _mason_hash = _mason_hash_word(_mason_hash, obj->name##_count); \
+    for (size_t i = 0; i < obj->name##_count; i++)                  \
+        _mason_hash = mason_rawvalue_hash(&obj->name[i], _mason_hash);
+
+#define _MASON_HASH_OBJECT(type, name) _mason_hash = type##_hash(obj->name, _mason_hash);
+
+#define _MASON_HASH_ARRAY_OBJECT(type, name)                        \
+    _mason_hash = _mason_hash_word(_mason_hash, obj->name##_count); \
+    for (size_t i = 0; i < obj->name##_count; i++)                  \
+        _mason_hash = type##_hash(&obj->name[i], _mason_hash);
+
+#define _MASON_HASH_UNION_CASE(value, type, member)                              \
+    _MASON_UNION_CASE(value) {                                                   \
+        _mason_hash = type##_hash((const type *)*_mason_union_ptr, _mason_hash); \
+    }
+
+#define _MASON_HASH_UNION(tag, name, CASES)                            \
+    if (obj->name.ptr) {                                               \
+        _MASON_UNION_SWITCH(tag, name)                                 \
+        CASES(_MASON_HASH_UNION_CASE)                                  \
+    } else {                                                           \
+        _mason_hash = _mason_hash_word(_mason_hash, _MASON_HASH_NULL); \
+    }
+
+/* X-Macro Expansion Helpers for Equality and Hashing */
+
+#define _MASON_EXPAND_EQUAL_FIELD(type, name)        _MASON_EQUAL_FIELD(type, name)
+#define _MASON_EXPAND_EQUAL_ARRAY(type, name)        _MASON_EQUAL_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_EQUAL_ARRAY_MULTI(name)        _MASON_EQUAL_ARRAY_MULTI(name)
+#define _MASON_EXPAND_EQUAL_OBJECT(type, name)       _MASON_EQUAL_OBJECT(type, name)
+#define _MASON_EXPAND_EQUAL_ARRAY_OBJECT(type, name) _MASON_EQUAL_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_EQUAL_UNION(tag, name, CASES)  _MASON_EQUAL_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_HASH_FIELD(type, name)        _MASON_HASH_FIELD(type, name)
+#define _MASON_EXPAND_HASH_ARRAY(type, name)        _MASON_HASH_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_HASH_ARRAY_MULTI(name)        _MASON_HASH_ARRAY_MULTI(name)
+#define _MASON_EXPAND_HASH_OBJECT(type, name)       _MASON_HASH_OBJECT(type, name)
+#define _MASON_EXPAND_HASH_ARRAY_OBJECT(type, name) _MASON_HASH_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_HASH_UNION(tag, name, CASES)  _MASON_HASH_UNION(tag, name, CASES)
+
+/* Partial equality and hash impl */
+#define _MASON_IMPL_HASH(struct_name, FIELDS)                                                           \
+    bool struct_name##_equal(const struct_name *a, const struct_name *b) {                              \
+        if (a == b)                                                                                     \
+            return true;                                                                                \
+        if (!a || !b)                                                                                   \
+            return false;                                                                               \
+        struct_name *obj = (struct_name *)a;                                                            \
+        const struct_name *other = b;                                                                   \
+        FIELDS(_MASON_EXPAND_EQUAL_FIELD, _MASON_EXPAND_EQUAL_ARRAY, _MASON_EXPAND_EQUAL_ARRAY_MULTI,   \
+               _MASON_EXPAND_EQUAL_OBJECT, _MASON_EXPAND_EQUAL_ARRAY_OBJECT, _MASON_EXPAND_EQUAL_UNION) \
+        (void)other;                                                                                    \
+        return true;                                                                                    \
+    }                                                                                                   \
+                                                                                                        \
+    uint64_t struct_name##_hash(const struct_name *value, uint64_t seed) {                              \
+        if (!value)                                                                                     \
+            return _mason_hash_final(_mason_hash_word(seed, _MASON_HASH_NULL));                         \
+        struct_name *obj = (struct_name *)value;                                                        \
+        uint64_t _mason_hash = seed;                                                                    \
+        FIELDS(_MASON_EXPAND_HASH_FIELD, _MASON_EXPAND_HASH_ARRAY, _MASON_EXPAND_HASH_ARRAY_MULTI,      \
+               _MASON_EXPAND_HASH_OBJECT, _MASON_EXPAND_HASH_ARRAY_OBJECT, _MASON_EXPAND_HASH_UNION)    \
+        return _mason_hash_final(_mason_hash);                                                          \
+    }
+
+#endif // MASON_HASH_H
@@ -0,0 +1,147 @@
+#ifndef MASON_INTERN_H
+#define MASON_INTERN_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* String Interning
+ *
+ * `interned` fields hold a pointer to the one canonical copy of their value in
+ * a process-wide table, so a value that repeats across millions of objects is
+ * stored once, equal values compare equal by pointer, and decoding a value that
+ * is already in the table allocates nothing. Interned strings live until
+ * mason_intern_clear() and are never freed by Foo_free.
+ *
+ * The table is split into shards, each guarded by its own spinlock, so threads
+ * decoding in parallel rarely contend. Use it for low-cardinality values only:
+ * every distinct string ever seen stays resident.
+ */
+
+#define MASON_INTERN_SHARDS 16
+
+typedef struct mason_intern_entry {
+    struct mason_intern_entry *next;
+    size_t hash;
+    size_t len;
+    char str[];
+} mason_intern_entry;
+
+typedef struct {
+    atomic_bool lock;
+    mason_intern_entry **buckets;
+    size_t nbuckets; // power of two
+    size_t count;
+} mason_intern_shard;
+
+_MASON_SHARED(mason_intern_shard _mason_intern_shards[MASON_INTERN_SHARDS], {0});
+
+static inline void _mason_intern_lock(mason_intern_shard *s) {
+    while (atomic_exchange_explicit(&s->lock, true, memory_order_acquire))
+        ;
+}
+
+static inline void _mason_intern_unlock(mason_intern_shard *s) {
+    atomic_store_explicit(&s->lock, false, memory_order_release);
+}
+
+/* FNV-1a */
+static inline size_t _mason_intern_hash(const char *str, size_t len) {
+    uint64_t h = 14695981039346656037u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)str[i];
+        h *= 1099511628211u;
+    }
+    return (size_t)(h ^ (h >> 32));
+}
+
+/* Doubles the bucket array; keeps the old one if that allocation fails */
+static inline void _mason_intern_grow(mason_intern_shard *s) {
+    size_t nbuckets = s->nbuckets ? s->nbuckets * 2 : 64;
+    mason_intern_entry **buckets = (mason_intern_entry **)MASON_CALLOC(nbuckets, sizeof(mason_intern_entry *));
+    if (!buckets)
+        return;
+    for (size_t i = 0; i < s->nbuckets; i++) {
+        mason_intern_entry *e = s->buckets[i];
+        while (e) {
+            mason_intern_entry *next = e->next;
+            size_t b = (e->hash / MASON_INTERN_SHARDS) & (nbuckets - 1);
+            e->next = buckets[b];
+            buckets[b] = e;
+            e = next;
+        }
+    }
+    MASON_FREE(s->buckets);
+    s->buckets = buckets;
+    s->nbuckets = nbuckets;
+}
+
+/* Returns the canonical NUL-terminated copy of str[0..len), or NULL if it could not be allocated */
+static inline const char *mason_intern(const char *str, size_t len) {
+    if (!str)
+        return NULL;
+    size_t hash = _mason_intern_hash(str, len);
+    mason_intern_shard *s = &_mason_intern_shards[hash % MASON_INTERN_SHARDS];
+    _mason_intern_lock(s);
+    if (s->count >= s->nbuckets)
+        _mason_intern_grow(s);
+    const char *found = NULL;
+    if (s->nbuckets) {
+        mason_intern_entry **head = &s->buckets[(hash / MASON_INTERN_SHARDS) & (s->nbuckets - 1)];
+        for (mason_intern_entry *e = *head; e && !found; e = e->next)
+            if (e->hash == hash && e->len == len && memcmp(e->str, str, len) == 0)
+                found = e->str;
+        if (!found) {
+            mason_intern_entry *e = (mason_intern_entry *)MASON_MALLOC(sizeof(mason_intern_entry) + len + 1);
+            if (e) {
+                e->hash = hash;
+                e->len = len;
+                memcpy(e->str, str, len);
+                e->str[len] = '\0';
+                e->next = *head;
+                *head = e;
+                s->count++;
+                found = e->str;
+            }
+        }
+    }
+    _mason_intern_unlock(s);
+    return found;
+}
+
+/* Number of distinct strings in the table */
+static inline size_t mason_intern_count(void) {
+    size_t count = 0;
+    for (size_t i = 0; i < MASON_INTERN_SHARDS; i++) {
+        _mason_intern_lock(&_mason_intern_shards[i]);
+        count += _mason_intern_shards[i].count;
+        _mason_intern_unlock(&_mason_intern_shards[i]);
+    }
+    return count;
+}
+
+/* Frees every interned string
+ * NOTE: only call this once no live struct holds an interned pointer
+ */
+static inline void mason_intern_clear(void) {
+    for (size_t i = 0; i < MASON_INTERN_SHARDS; i++) {
+        mason_intern_shard *s = &_mason_intern_shards[i];
+        _mason_intern_lock(s);
+        for (size_t b = 0; b < s->nbuckets; b++) {
+            mason_intern_entry *e = s->buckets[b];
+            while (e) {
+                mason_intern_entry *next = e->next;
+                MASON_FREE(e);
+                e = next;
+            }
+        }
+        MASON_FREE(s->buckets);
+        s->buckets = NULL;
+        s->nbuckets = 0;
+        s->count = 0;
+        _mason_intern_unlock(s);
+    }
+}
+
+#endif // MASON_INTERN_H
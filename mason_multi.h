@@ -58,6 +58,18 @@ static inline MASON_RawValue mason_rawvalue_null(void) {
     return v;
 }
 
+/* Integers take the narrowest of int32 and int64 that holds them */
+static inline MASON_RawValue _mason_rawvalue_integer(int64_t val) {
+    return val >= INT32_MIN && val <= INT32_MAX ? mason_rawvalue_int32_t((int32_t)val) : mason_rawvalue_int64_t(val);
+}
+
+/* Whole doubles within int64_t (such as 1.0) count as integers too */
+static inline MASON_RawValue _mason_rawvalue_number(double val) {
+    if (val >= -0x1p63 && val < 0x1p63 && val == (double)(int64_t)val)
+        return _mason_rawvalue_integer((int64_t)val);
+    return mason_rawvalue_double(val);
+}
+
 static inline MASON_RawValue mason_rawvalue_object(MASON_Parsed ast) {
     MASON_RawValue v = {MASON_VALUE_OBJECT, {.ast = ast}};
     return v;
@@ -73,7 +85,7 @@ static inline void mason_rawvalue_free(MASON_RawValue *val) {
         return;
     switch (val->type) {
     case MASON_VALUE_STRING:
-        free(val->value.s);
+        MASON_FREE(val->value.s);
         break;
     case MASON_VALUE_OBJECT:
         mason_delete(val->value.ast);
@@ -94,95 +106,234 @@ static inline void mason_rawvalue_free(MASON_RawValue *val) {
 
 /* Parser */
 
-#define _MASON_PARSE_ARRAY_MULTI(name)                                                   \
-    item = cJSON_GetObjectItemCaseSensitive(json, #name);                                \
-    if (cJSON_IsArray(item)) {                                                           \
-        obj->name##_count = (size_t)cJSON_GetArraySize(item);                            \
-        obj->name = (MASON_RawValue *)calloc(obj->name##_count, sizeof(MASON_RawValue)); \
-        if (obj->name) {                                                                 \
-            for (size_t i = 0; i < obj->name##_count; i++) {                             \
-                MASON_Parsed elem = cJSON_GetArrayItem(item, (int)i);                    \
-                if (cJSON_IsNumber(elem)) {                                              \
-                    double d = elem->valuedouble;                                        \
-                    if (d == (int64_t)d) {                                               \
-                        if (d >= INT32_MIN && d <= INT32_MAX) {                          \
-                            obj->name[i] = mason_rawvalue_int32_t((int32_t)d);           \
-                        } else {                                                         \
-                            obj->name[i] = mason_rawvalue_int64_t((int64_t)d);           \
-                        }                                                                \
-                    } else {                                                             \
-                        obj->name[i] = mason_rawvalue_double(d);                         \
-                    }                                                                    \
-                } else if (cJSON_IsString(elem) && elem->valuestring) {                  \
-                    obj->name[i] = mason_rawvalue_string(elem->valuestring);             \
-                } else if (cJSON_IsBool(elem)) {                                         \
-                    obj->name[i] = mason_rawvalue_bool(cJSON_IsTrue(elem));              \
-                } else if (cJSON_IsNull(elem)) {                                         \
-                    obj->name[i] = mason_rawvalue_null();                                \
-                } else if (cJSON_IsArray(elem)) {                                        \
-                    MASON_Parsed dup = cJSON_Duplicate(elem, 1);                         \
+#define _MASON_PARSE_ARRAY_MULTI(name)                                                                   \
+    _MASON_KEY_CASE(name) {                                                                              \
+        if (cJSON_IsArray(item)) {                                                                       \
+            obj->name##_count = (size_t)cJSON_GetArraySize(item);                                        \
+            obj->name = (MASON_RawValue *)MASON_CALLOC(obj->name##_count, sizeof(MASON_RawValue));       \
+            if (obj->name) {                                                                             \
+                size_t i = 0;                                                                            \
+                MASON_Parsed elem = NULL;                                                                \
+                cJSON_ArrayForEach(elem, item) {                                                         \
+                    int64_t _mason_int;                                                                  \
+                    if (cJSON_IsNumber(elem)) {                                                          \
+                        obj->name[i] = _mason_rawvalue_number(elem->valuedouble);                        \
+                    } else if (cJSON_IsRaw(elem) && _mason_text_int64(elem->valuestring, &_mason_int)) { \
+                        obj->name[i] = _mason_rawvalue_integer(_mason_int);                              \
+                    } else if (cJSON_IsString(elem) && elem->valuestring) {                              \
+                        obj->name[i] = mason_rawvalue_string(elem->valuestring);                         \
+                    } else if (cJSON_IsBool(elem)) {                                                     \
+                        obj->name[i] = mason_rawvalue_bool(cJSON_IsTrue(elem));                          \
+                    } else if (cJSON_IsNull(elem)) {                                                     \
+                        obj->name[i] = mason_rawvalue_null();                                            \
+                    } else if (cJSON_IsArray(elem)) {                                                    \
+                        MASON_Parsed dup = cJSON_Duplicate(elem, 1);                                     \
+                        if (dup)                                                                         \
+                            obj->name[i] = mason_rawvalue_array(dup);                                    \
+                    } else if (cJSON_IsObject(elem)) {                                                   \
+                        MASON_Parsed dup = cJSON_Duplicate(elem, 1);                                     \
+                        if (dup)                                                                         \
+                            obj->name[i] = mason_rawvalue_object(dup);                                   \
+                    }                                                                                    \
+                    i++;                                                                                 \
+                }                                                                                        \
+            } else {                                                                                     \
+                obj->name##_count = 0;                                                                   \
+            }                                                                                            \
+        }                                                                                                \
+    }
+
+/* Single-pass decoder */
+
+static inline void _mason_arena_delete_json(void *json) { mason_delete((MASON_Parsed)json); }
+
+static inline bool _mason_read_rawvalue(mason_reader *r, MASON_RawValue *out) {
+    char c = mason_reader_peek(r);
+    if (_mason_reader_is_number(c)) {
+        int64_t v;
+        size_t n = mason_parse_int64(r->cur, r->end, &v);
+        if (n) {
+            r->cur += n;
+            *out = _mason_rawvalue_integer(v);
+            return true;
+        }
+        double d;
+        if (!_mason_reader_number(r, &d))
+            return false;
+        *out = _mason_rawvalue_number(d);
+        return true;
+    }
+    switch (c) {
+    case '"':
+        out->type = MASON_VALUE_STRING;
+        out->value.s = _mason_reader_string(r);
+        return out->value.s != NULL;
+    case 't':
+        *out = mason_rawvalue_bool(true);
+        return _mason_reader_literal(r, "true", 4);
+    case 'f':
+        *out = mason_rawvalue_bool(false);
+        return _mason_reader_literal(r, "false", 5);
+    case 'n':
+        *out = mason_rawvalue_null();
+        return _mason_reader_literal(r, "null", 4);
+    case '[':
+    case '{': {
+        /* Nested containers are still stored as JSON handles */
+        const char *start = r->cur;
+        if (!mason_reader_skip(r))
+            return false;
+        MASON_Parsed dup = mason_parse_sized(start, (size_t)(r->cur - start));
+        if (dup && r->arena && !mason_arena_defer(r->arena, _mason_arena_delete_json, dup)) {
+            mason_delete(dup);
+            return mason_reader_fail(r);
+        }
+        if (dup)
+            *out = c == '[' ? mason_rawvalue_array(dup) : mason_rawvalue_object(dup);
+        return true;
+    }
+    default:
+        return mason_reader_fail(r);
+    }
+}
+
+#define _MASON_DECODE_ARRAY_MULTI_VALUE(name)                                                     \
+    if (mason_reader_array_begin(r)) {                                                            \
+        size_t _mason_cap = 0;                                                                    \
+        bool _mason_first = true;                                                                 \
+        while (mason_reader_next_element(r, &_mason_first)) {                                     \
+            MASON_RawValue *_mason_slot = (MASON_RawValue *)_mason_reader_push(                   \
+                r, (void **)&obj->name, &obj->name##_count, &_mason_cap, sizeof(MASON_RawValue)); \
+            if (!_mason_slot || !_mason_read_rawvalue(r, _mason_slot))                            \
+                return false;                                                                     \
+        }                                                                                         \
+    } else {                                                                                      \
+        mason_reader_skip(r);                                                                     \
+    }
+
+#define _MASON_DECODE_ARRAY_MULTI(name)       \
+    _MASON_KEY_CASE(name) {                   \
+        _MASON_DECODE_ARRAY_MULTI_VALUE(name) \
+    }
+
+/* Serializer */
+
+#define _MASON_SERIALIZE_ARRAY_MULTI(name)                                               \
+    {                                                                                    \
+        MASON_Parsed arr = cJSON_CreateArray();                                          \
+        for (size_t i = 0; i < obj->name##_count; i++) {                                 \
+            switch (obj->name[i].type) {                                                 \
+            case MASON_VALUE_INT32:                                                      \
+                cJSON_AddItemToArray(arr, cJSON_CreateNumber(obj->name[i].value.i32));   \
+                break;                                                                   \
+            case MASON_VALUE_INT64:                                                      \
+                cJSON_AddItemToArray(arr, mason_create_int64(obj->name[i].value.i64));   \
+                break;                                                                   \
+            case MASON_VALUE_DOUBLE:                                                     \
+                cJSON_AddItemToArray(arr, cJSON_CreateNumber(obj->name[i].value.d));     \
+                break;                                                                   \
+            case MASON_VALUE_STRING:                                                     \
+                if (obj->name[i].value.s) {                                              \
+                    cJSON_AddItemToArray(arr, cJSON_CreateString(obj->name[i].value.s)); \
+                } else {                                                                 \
+                    cJSON_AddItemToArray(arr, cJSON_CreateNull());                       \
+                }                                                                        \
+                break;                                                                   \
+            case MASON_VALUE_BOOL:                                                       \
+                cJSON_AddItemToArray(arr, cJSON_CreateBool(obj->name[i].value.b));       \
+                break;                                                                   \
+            case MASON_VALUE_NULL:                                                       \
+                cJSON_AddItemToArray(arr, cJSON_CreateNull());                           \
+                break;                                                                   \
+            case MASON_VALUE_ARRAY:                                                      \
+                if (obj->name[i].value.ast) {                                            \
+                    MASON_Parsed dup = cJSON_Duplicate(obj->name[i].value.ast, 1);       \
                     if (dup)                                                             \
-                        obj->name[i] = mason_rawvalue_array(dup);                        \
-                } else if (cJSON_IsObject(elem)) {                                       \
-                    MASON_Parsed dup = cJSON_Duplicate(elem, 1);                         \
+                        cJSON_AddItemToArray(arr, dup);                                  \
+                }                                                                        \
+                break;                                                                   \
+            case MASON_VALUE_OBJECT:                                                     \
+                if (obj->name[i].value.ast) {                                            \
+                    MASON_Parsed dup = cJSON_Duplicate(obj->name[i].value.ast, 1);       \
                     if (dup)                                                             \
-                        obj->name[i] = mason_rawvalue_object(dup);                       \
+                        cJSON_AddItemToArray(arr, dup);                                  \
                 }                                                                        \
+                break;                                                                   \
+            default:                                                                     \
+                break;                                                                   \
             }                                                                            \
-        } else {                                                                         \
-            obj->name##_count = 0;                                                       \
         }                                                                                \
+        cJSON_AddItemToObject(json, #name, arr);                                         \
     }
 
-/* Serializer */
+/* Direct writer */
+
+#define _MASON_WRITE_ARRAY_MULTI(name)                            \
+    _MASON_WRITE_KEY(name) {                                      \
+        size_t _mason_arr = out->len;                             \
+        for (size_t i = 0; i < obj->name##_count; i++) {          \
+            switch (obj->name[i].type) {                          \
+            case MASON_VALUE_INT32:                               \
+                mason_buf_putc(out, ',');                         \
+                mason_write_int32(out, obj->name[i].value.i32);   \
+                break;                                            \
+            case MASON_VALUE_INT64:                               \
+                mason_buf_putc(out, ',');                         \
+                mason_write_int64(out, obj->name[i].value.i64);   \
+                break;                                            \
+            case MASON_VALUE_DOUBLE:                              \
+                mason_buf_putc(out, ',');                         \
+                mason_write_double(out, obj->name[i].value.d);    \
+                break;                                            \
+            case MASON_VALUE_STRING:                              \
+                mason_buf_putc(out, ',');                         \
+                mason_write_string(out, obj->name[i].value.s);    \
+                break;                                            \
+            case MASON_VALUE_BOOL:                                \
+                mason_buf_putc(out, ',');                         \
+                mason_write_bool(out, obj->name[i].value.b);      \
+                break;                                            \
+            case MASON_VALUE_NULL:                                \
+                mason_buf_putc(out, ',');                         \
+                _MASON_WRITE_LITERAL(out, "null");                \
+                break;                                            \
+            case MASON_VALUE_ARRAY:                               \
+            case MASON_VALUE_OBJECT:                              \
+                if (obj->name[i].value.ast) {                     \
+                    mason_buf_putc(out, ',');                     \
+                    mason_write_ast(out, obj->name[i].value.ast); \
+                }                                                 \
+                break;                                            \
+            default:                                              \
+                break;                                            \
+            }                                                     \
+        }                                                         \
+        mason_write_close(out, _mason_arr, '[', ']');             \
+    }
 
-#define _MASON_SERIALIZE_ARRAY_MULTI(name)                                                     \
-    {                                                                                          \
-        MASON_Parsed arr = cJSON_CreateArray();                                                \
-        for (size_t i = 0; i < obj->name##_count; i++) {                                       \
-            switch (obj->name[i].type) {                                                       \
-            case MASON_VALUE_INT32:                                                            \
-                cJSON_AddItemToArray(arr, cJSON_CreateNumber(obj->name[i].value.i32));         \
-                break;                                                                         \
-            case MASON_VALUE_INT64:                                                            \
-                cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)obj->name[i].value.i64)); \
-                break;                                                                         \
-            case MASON_VALUE_DOUBLE:                                                           \
-                cJSON_AddItemToArray(arr, cJSON_CreateNumber(obj->name[i].value.d));           \
-                break;                                                                         \
-            case MASON_VALUE_STRING:                                                           \
-                if (obj->name[i].value.s) {                                                    \
-                    cJSON_AddItemToArray(arr, cJSON_CreateString(obj->name[i].value.s));       \
-                } else {                                                                       \
-                    cJSON_AddItemToArray(arr, cJSON_CreateNull());                             \
-                }                                                                              \
-                break;                                                                         \
-            case MASON_VALUE_BOOL:                                                             \
-                cJSON_AddItemToArray(arr, cJSON_CreateBool(obj->name[i].value.b));             \
-                break;                                                                         \
-            case MASON_VALUE_NULL:                                                             \
-                cJSON_AddItemToArray(arr, cJSON_CreateNull());                                 \
-                break;                                                                         \
-            case MASON_VALUE_ARRAY:                                                            \
-                if (obj->name[i].value.ast) {                                                  \
-                    MASON_Parsed dup = cJSON_Duplicate(obj->name[i].value.ast, 1);             \
-                    if (dup)                                                                   \
-                        cJSON_AddItemToArray(arr, dup);                                        \
-                }                                                                              \
-                break;                                                                         \
-            case MASON_VALUE_OBJECT:                                                           \
-                if (obj->name[i].value.ast) {                                                  \
-                    MASON_Parsed dup = cJSON_Duplicate(obj->name[i].value.ast, 1);             \
-                    if (dup)                                                                   \
-                        cJSON_AddItemToArray(arr, dup);                                        \
-                }                                                                              \
-                break;                                                                         \
-            default:                                                                           \
-                break;                                                                         \
-            }                                                                                  \
-        }                                                                                      \
-        cJSON_AddItemToObject(json, #name, arr);                                               \
+static inline size_t mason_size_hint_rawvalue(const MASON_RawValue *val) {
+    switch (val->type) {
+    case MASON_VALUE_INT32:
+        return mason_size_hint_int32(val->value.i32);
+    case MASON_VALUE_INT64:
+    case MASON_VALUE_DOUBLE:
+        return MASON_NUMBER_MAX_CHARS;
+    case MASON_VALUE_STRING:
+        return mason_size_hint_string(val->value.s);
+    case MASON_VALUE_BOOL:
+        return mason_size_hint_bool(val->value.b);
+    case MASON_VALUE_ARRAY:
+    case MASON_VALUE_OBJECT:
+        return mason_size_hint_ast(val->value.ast);
+    default:
+        return 4;
     }
+}
+
+#define _MASON_SIZE_ARRAY_MULTI(name)              \
+    size += _MASON_KEY_SIZE(name) + 2;             \
+    for (size_t i = 0; i < obj->name##_count; i++) \
+        size += 1 + mason_size_hint_rawvalue(&obj->name[i]);
 
 /* Print */
 #ifdef MASON_PRINT_IMPL
@@ -234,7 +385,7 @@ static inline void mason_rawvalue_free(MASON_RawValue *val) {
         for (size_t i = 0; i < obj->name##_count; i++) { \
             mason_rawvalue_free(&obj->name[i]);          \
         }                                                \
-        free(obj->name);                                 \
+        MASON_FREE(obj->name);                           \
     }
 
 #endif // MASON_MULTI_H
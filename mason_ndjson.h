@@ -0,0 +1,161 @@
+#ifndef MASON_NDJSON_H
+#define MASON_NDJSON_H
+
+#include <stdio.h>
+
+/* NDJSON / JSON Lines Streaming
+ *
+ * Records are read through one fixed-size buffer that is refilled with fread,
+ * so memory stays constant regardless of file size. A record split across
+ * reads is moved to the front of the buffer before the next read; a record
+ * longer than the whole buffer is skipped and reported instead of growing it.
+ */
+
+#ifndef MASON_NDJSON_BUFFER_SIZE
+#define MASON_NDJSON_BUFFER_SIZE (64 * 1024)
+#endif
+
+typedef enum {
+    MASON_NDJSON_END,
+    MASON_NDJSON_LINE,
+    MASON_NDJSON_TOO_LONG,
+} mason_ndjson_status;
+
+typedef struct {
+    FILE *fp;
+    char *buf;
+    size_t cap;
+    size_t pos;  // start of the unread bytes
+    size_t len;  // end of the buffered bytes
+    size_t line; // 1-based number of the last line returned
+    bool eof;
+    bool io_error;
+    bool skipping; // inside a line that did not fit
+} mason_ndjson_reader;
+
+/* A cap of 0 uses MASON_NDJSON_BUFFER_SIZE, which also bounds the line length */
+static inline bool mason_ndjson_reader_init(mason_ndjson_reader *r, FILE *fp, size_t cap) {
+    memset(r, 0, sizeof(*r));
+    r->fp = fp;
+    r->cap = cap ? cap : MASON_NDJSON_BUFFER_SIZE;
+    r->buf = (char *)MASON_MALLOC(r->cap);
+    return r->buf != NULL;
+}
+
+static inline void mason_ndjson_reader_destroy(mason_ndjson_reader *r) {
+    MASON_FREE(r->buf);
+    r->buf = NULL;
+}
+
+/* Returns the next line without its '\n'; the span stays valid until the next call */
+static inline mason_ndjson_status mason_ndjson_next_line(mason_ndjson_reader *r, const char **line, size_t *len) {
+    for (;;) {
+        char *start = r->buf + r->pos;
+        char *nl = (char *)memchr(start, '\n', r->len - r->pos);
+        if (nl || (r->eof && (r->pos < r->len || r->skipping))) {
+            char *stop = nl ? nl : r->buf + r->len;
+            *line = start;
+            *len = (size_t)(stop - start);
+            r->pos = nl ? (size_t)(nl + 1 - r->buf) : r->len;
+            r->line++;
+            if (r->skipping) {
+                r->skipping = false;
+                return MASON_NDJSON_TOO_LONG;
+            }
+            return MASON_NDJSON_LINE;
+        }
+        if (r->eof)
+            return MASON_NDJSON_END;
+
+        /* Keep the partial line and refill behind it */
+        memmove(r->buf, start, r->len - r->pos);
+        r->len -= r->pos;
+        r->pos = 0;
+        if (r->len == r->cap) {
+            r->skipping = true;
+            r->len = 0;
+        }
+        size_t n = fread(r->buf + r->len, 1, r->cap - r->len, r->fp);
+        r->len += n;
+        if (n == 0) {
+            r->eof = true;
+            r->io_error = ferror(r->fp) != 0;
+        }
+    }
+}
+
+/* Blank (whitespace-only) lines are skipped rather than reported */
+static inline bool _mason_ndjson_blank(const char *line, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        if ((unsigned char)line[i] > 32)
+            return false;
+    return true;
+}
+
+/* Partial NDJSON impl
+ *
+ * Each record is decoded with the single-pass reader into an arena that is
+ * reset after the callback returns, so the object passed to the callback is
+ * borrowed: copy anything that has to outlive the call. string_view fields point
+ * into the line buffer, which is unescaped in place. Failed lines reach the
+ * callback with obj == NULL and an error message. Returning false from the
+ * callback stops the stream. Foo_read_ndjson returns false on a read error.
+ */
+#define _MASON_IMPL_NDJSON(struct_name, FIELDS)                                                                    \
+    bool struct_name##_read_ndjson(FILE *fp, struct_name##_ndjson_callback cb, void *ctx) {                        \
+        if (!fp || !cb)                                                                                            \
+            return false;                                                                                          \
+        mason_ndjson_reader lines;                                                                                 \
+        if (!mason_ndjson_reader_init(&lines, fp, 0))                                                              \
+            return false;                                                                                          \
+        mason_arena arena;                                                                                         \
+        mason_arena_init(&arena, 0);                                                                               \
+        const char *line;                                                                                          \
+        size_t len;                                                                                                \
+        mason_ndjson_status status;                                                                                \
+        bool more = true;                                                                                          \
+        while (more && (status = mason_ndjson_next_line(&lines, &line, &len)) != MASON_NDJSON_END) {               \
+            if (status == MASON_NDJSON_TOO_LONG) {                                                                 \
+                more = cb(NULL, lines.line, "line exceeds the NDJSON buffer", ctx);                                \
+                continue;                                                                                          \
+            }                                                                                                      \
+            if (_mason_ndjson_blank(line, len))                                                                    \
+                continue;                                                                                          \
+            struct_name obj;                                                                                       \
+            memset(&obj, 0, sizeof(obj));                                                                          \
+            mason_reader r;                                                                                        \
+            mason_reader_init(&r, line, len);                                                                      \
+            r.arena = &arena;                                                                                      \
+            r.inplace = true;                                                                                      \
+            if (mason_reader_peek(&r) != '{')                                                                      \
+                more = cb(NULL, lines.line, "record is not a JSON object", ctx);                                   \
+            else if (!struct_name##_decode_reader(&obj, &r) || mason_reader_peek(&r) != '\0')                      \
+                more = cb(NULL, lines.line, "malformed JSON record", ctx);                                         \
+            else                                                                                                   \
+                more = cb(&obj, lines.line, NULL, ctx);                                                            \
+            mason_arena_reset(&arena);                                                                             \
+        }                                                                                                          \
+        mason_arena_destroy(&arena);                                                                               \
+        mason_ndjson_reader_destroy(&lines);                                                                       \
+        return !lines.io_error;                                                                                    \
+    }                                                                                                              \
+                                                                                                                   \
+    bool struct_name##_write_ndjson(FILE *fp, struct_name *obj, mason_buf *scratch) {                              \
+        if (!fp || !obj)                                                                                           \
+            return false;                                                                                          \
+        mason_buf local;                                                                                           \
+        mason_buf *out = scratch ? scratch : &local;                                                               \
+        if (!scratch)                                                                                              \
+            mason_buf_init(&local);                                                                                \
+        mason_buf_reset(out);                                                                                      \
+        bool ok = struct_name##_write(obj, out);                                                                   \
+        if (ok) {                                                                                                  \
+            mason_buf_putc(out, '\n');                                                                             \
+            ok = !out->failed && fwrite(out->data, 1, out->len, fp) == out->len;                                   \
+        }                                                                                                          \
+        if (!scratch)                                                                                              \
+            mason_buf_free(&local);                                                                                \
+        return ok;                                                                                                 \
+    }
+
+#endif // MASON_NDJSON_H
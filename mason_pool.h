@@ -0,0 +1,239 @@
+#ifndef MASON_POOL_H
+#define MASON_POOL_H
+
+#include <pthread.h>
+#include <unistd.h>
+
+/* Work-Stealing Thread Pool
+ *
+ * Runs index-based jobs (one index per document) across a fixed set of
+ * workers. Each worker starts with an even slice of the index range in its own
+ * queue and takes indices from the front; a worker that runs dry steals the
+ * back half of another worker's remaining slice, so uneven documents still keep
+ * every core busy. The calling thread works as worker 0.
+ *
+ * Workers allocate through the active Mason allocator on their own thread, so
+ * with mason_pool_allocator() each one recycles its own thread-local cache.
+ */
+
+typedef void (*mason_pool_task)(size_t index, void *ctx);
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+    char pad[64]; // keeps neighbouring queues off the same cache line
+} mason_pool_queue;
+
+typedef struct mason_pool {
+    size_t nworkers; // including the calling thread
+    pthread_t *threads;
+    mason_pool_queue *queues;
+    pthread_mutex_t run_lock; // one job at a time
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    uint64_t generation;
+    size_t active;
+    bool stopping;
+    mason_pool_task task;
+    void *ctx;
+} mason_pool;
+
+typedef struct {
+    mason_pool *pool;
+    size_t worker;
+} _mason_pool_worker_arg;
+
+static inline bool _mason_pool_take(mason_pool_queue *q, size_t *index) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = q->next < q->end;
+    if (ok)
+        *index = q->next++;
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+/* Moves the back half of a victim's remaining range into the thief's queue */
+static inline bool _mason_pool_steal(mason_pool *pool, size_t thief) {
+    for (size_t k = 1; k < pool->nworkers; k++) {
+        mason_pool_queue *victim = &pool->queues[(thief + k) % pool->nworkers];
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->next;
+        size_t lo = victim->end - (remaining + 1) / 2;
+        size_t hi = victim->end;
+        if (remaining)
+            victim->end = lo;
+        pthread_mutex_unlock(&victim->lock);
+        if (!remaining)
+            continue;
+        mason_pool_queue *own = &pool->queues[thief];
+        pthread_mutex_lock(&own->lock);
+        own->next = lo;
+        own->end = hi;
+        pthread_mutex_unlock(&own->lock);
+        return true;
+    }
+    return false;
+}
+
+static inline void _mason_pool_work(mason_pool *pool, size_t worker) {
+    size_t index;
+    do {
+        while (_mason_pool_take(&pool->queues[worker], &index))
+            pool->task(index, pool->ctx);
+    } while (_mason_pool_steal(pool, worker));
+}
+
+static inline void *_mason_pool_main(void *p) {
+    _mason_pool_worker_arg arg = *(_mason_pool_worker_arg *)p;
+    MASON_FREE(p);
+    mason_pool *pool = arg.pool;
+    uint64_t seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->stopping)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        _mason_pool_work(pool, arg.worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    mason_pool_thread_exit();
+    return NULL;
+}
+
+/* A thread count of 0 uses one worker per online CPU */
+static inline mason_pool *mason_pool_create(size_t threads) {
+    if (!threads) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    mason_pool *pool = (mason_pool *)MASON_CALLOC(1, sizeof(mason_pool));
+    if (!pool)
+        return NULL;
+    pool->queues = (mason_pool_queue *)MASON_CALLOC(threads, sizeof(mason_pool_queue));
+    pool->threads = (pthread_t *)MASON_CALLOC(threads, sizeof(pthread_t));
+    if (!pool->queues || !pool->threads) {
+        MASON_FREE(pool->queues);
+        MASON_FREE(pool->threads);
+        MASON_FREE(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->queues[0].lock, NULL);
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    /* Worker 0 is whichever thread calls mason_pool_run */
+    pool->nworkers = 1;
+    for (size_t i = 1; i < threads; i++) {
+        _mason_pool_worker_arg *arg = (_mason_pool_worker_arg *)MASON_MALLOC(sizeof(_mason_pool_worker_arg));
+        if (!arg)
+            break;
+        arg->pool = pool;
+        arg->worker = i;
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+        if (pthread_create(&pool->threads[i], NULL, _mason_pool_main, arg) != 0) {
+            pthread_mutex_destroy(&pool->queues[i].lock);
+            MASON_FREE(arg);
+            break;
+        }
+        pool->nworkers++;
+    }
+    return pool;
+}
+
+static inline size_t mason_pool_size(const mason_pool *pool) { return pool ? pool->nworkers : 1; }
+
+/* Calls task(i, ctx) for every i in [0, n) and returns once all have finished */
+static inline void mason_pool_run(mason_pool *pool, size_t n, mason_pool_task task, void *ctx) {
+    if (!pool || pool->nworkers == 1 || n < 2) {
+        for (size_t i = 0; i < n; i++)
+            task(i, ctx);
+        return;
+    }
+    pthread_mutex_lock(&pool->run_lock);
+    pthread_mutex_lock(&pool->lock);
+    for (size_t w = 0; w < pool->nworkers; w++) {
+        pthread_mutex_lock(&pool->queues[w].lock);
+        pool->queues[w].next = n * w / pool->nworkers;
+        pool->queues[w].end = n * (w + 1) / pool->nworkers;
+        pthread_mutex_unlock(&pool->queues[w].lock);
+    }
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->active = pool->nworkers - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    _mason_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+static inline void mason_pool_destroy(mason_pool *pool) {
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 1; i < pool->nworkers; i++)
+        pthread_join(pool->threads[i], NULL);
+    for (size_t i = 0; i < pool->nworkers; i++)
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    MASON_FREE(pool->queues);
+    MASON_FREE(pool->threads);
+    MASON_FREE(pool);
+}
+
+/* Batch decode */
+
+typedef struct {
+    const char **docs;
+    const size_t *lens; // NULL means NUL-terminated documents
+    void *out;
+} _mason_batch;
+
+/* Partial batch impl */
+#define _MASON_IMPL_BATCH(struct_name, FIELDS)                                                            \
+    static void struct_name##_decode_batch_task(size_t i, void *ctx) {                                    \
+        _mason_batch *b = (_mason_batch *)ctx;                                                            \
+        const char *doc = b->docs[i];                                                                     \
+        size_t len = doc ? (b->lens ? b->lens[i] : strlen(doc)) : 0;                                      \
+        ((struct_name **)b->out)[i] = struct_name##_decode(doc, len);                                     \
+    }                                                                                                     \
+                                                                                                          \
+    size_t struct_name##_decode_batch(const char **docs, const size_t *lens, size_t n, struct_name **out, \
+                                      mason_pool *pool) {                                                 \
+        if (!docs || !out)                                                                                \
+            return 0;                                                                                     \
+        _mason_batch batch = {docs, lens, out};                                                           \
+        mason_pool_run(pool, n, struct_name##_decode_batch_task, &batch);                                 \
+        size_t decoded = 0;                                                                               \
+        for (size_t i = 0; i < n; i++)                                                                    \
+            decoded += out[i] != NULL;                                                                    \
+        return decoded;                                                                                   \
+    }
+
+#endif // MASON_POOL_H
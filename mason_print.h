@@ -47,6 +47,9 @@ static inline void mason_print_string(const char *name, const char *v, int inden
     _mason_print_indent(indent);
     printf("%s: \"%s\"\n", name, v ? v : "null");
 }
+static inline void mason_print_interned(const char *name, mason_interned_t v, int indent) {
+    mason_print_string(name, (const char *)v, indent);
+}
 static inline void mason_print_bool(const char *name, bool v, int indent) {
     _mason_print_indent(indent);
     printf("%s: %s\n", name, v ? "true" : "false");
@@ -58,6 +61,7 @@ static inline void mason_print_bool(const char *name, bool v, int indent) {
     double: mason_print_double,                                      \
     char *: mason_print_string,                                      \
     const char *: mason_print_string,                                \
+    mason_interned_t: mason_print_interned,                          \
     _Bool: mason_print_bool)(name_str, value, indent)
 
 /* Array element printers */
@@ -65,6 +69,9 @@ static inline void mason_print_array_elem_int32(int32_t v) { printf("%" PRId32,
 static inline void mason_print_array_elem_int64(int64_t v) { printf("%" PRId64, v); }
 static inline void mason_print_array_elem_double(double v) { printf("%f", v); }
 static inline void mason_print_array_elem_string(const char *v) { printf("\"%s\"", v ? v : "null"); }
+static inline void mason_print_array_elem_interned(mason_interned_t v) {
+    mason_print_array_elem_string((const char *)v);
+}
 static inline void mason_print_array_elem_bool(bool v) { printf("%s", v ? "true" : "false"); }
 
 #define mason_print_array_elem(value) _Generic((value), \
@@ -73,6 +80,7 @@ static inline void mason_print_array_elem_bool(bool v) { printf("%s", v ? "true"
     double: mason_print_array_elem_double,              \
     char *: mason_print_array_elem_string,              \
     const char *: mason_print_array_elem_string,        \
+    mason_interned_t: mason_print_array_elem_interned,  \
     _Bool: mason_print_array_elem_bool)(value)
 
 #define _MASON_PRINT_FIELD_DISPATCH(type, name) \
@@ -115,6 +123,29 @@ static inline void mason_print_array_elem_bool(bool v) { printf("%s", v ? "true"
         printf("]\n");                                             \
     } while (0);
 
+#define _MASON_PRINT_UNION_CASE(value, type, member)                       \
+    _MASON_UNION_CASE(value) {                                             \
+        printf("{\n");                                                     \
+        type##_print_indent((type *)*_mason_union_ptr, _mason_indent + 2); \
+        _MASON_PRINT_INDENT(_mason_indent);                                \
+        printf("}\n");                                                     \
+    }
+
+#define _MASON_PRINT_UNION(tag, name, CASES) \
+    do {                                     \
+        _MASON_PRINT_INDENT(_mason_indent);  \
+        printf("%s: ", #name);               \
+        if (!obj->name.ptr) {                \
+            printf("null\n");                \
+            break;                           \
+        }                                    \
+        _MASON_UNION_SWITCH(tag, name)       \
+        CASES(_MASON_PRINT_UNION_CASE)       \
+        else {                               \
+            printf("null\n");                \
+        }                                    \
+    } while (0);
+
 /* X-Macro Expansion Helpers for Print */
 
 #define _MASON_EXPAND_PRINT_FIELD(type, name)        _MASON_PRINT_FIELD_DISPATCH(type, name)
@@ -122,6 +153,7 @@ static inline void mason_print_array_elem_bool(bool v) { printf("%s", v ? "true"
 #define _MASON_EXPAND_PRINT_ARRAY_MULTI(name)        _MASON_PRINT_ARRAY_MULTI(name)
 #define _MASON_EXPAND_PRINT_OBJECT(type, name)       _MASON_PRINT_OBJECT(type, name)
 #define _MASON_EXPAND_PRINT_ARRAY_OBJECT(type, name) _MASON_PRINT_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_PRINT_UNION(tag, name, CASES)  _MASON_PRINT_UNION(tag, name, CASES)
 
 /* Partial print impl */
 #define _MASON_IMPL_PRINT(struct_name, FIELDS)                                                        \
@@ -135,7 +167,8 @@ static inline void mason_print_array_elem_bool(bool v) { printf("%s", v ? "true"
         printf("%s {\n", #struct_name);                                                               \
         int _mason_indent = indent + 2;                                                               \
         FIELDS(_MASON_EXPAND_PRINT_FIELD, _MASON_EXPAND_PRINT_ARRAY, _MASON_EXPAND_PRINT_ARRAY_MULTI, \
-               _MASON_EXPAND_PRINT_OBJECT, _MASON_EXPAND_PRINT_ARRAY_OBJECT)                          \
+               _MASON_EXPAND_PRINT_OBJECT, _MASON_EXPAND_PRINT_ARRAY_OBJECT,                          \
+               _MASON_EXPAND_PRINT_UNION)                                                             \
         _MASON_PRINT_INDENT(indent);                                                                  \
         printf("}\n");                                                                                \
     }                                                                                                 \
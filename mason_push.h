@@ -0,0 +1,752 @@
+#ifndef MASON_PUSH_H
+#define MASON_PUSH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Push Decoder
+ *
+ * Foo_decoder takes a document in chunks of any size as they arrive and fills
+ * a Foo as it goes, so decoding overlaps the network instead of waiting for a
+ * reassembled buffer. It keeps its own parse stack rather than recursing and
+ * can stop at any byte; only a string or number cut in half by a chunk boundary
+ * is copied aside. Values are converted by the single-pass readers, so the
+ * result is the same as Foo_decode on the whole document:
+ *
+ *   GatewayEventPayload_decoder *dec = GatewayEventPayload_decoder_create(0);
+ *   while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+ *       if (GatewayEventPayload_decoder_feed(dec, chunk, n, NULL) != MASON_PUSH_MORE)
+ *           break;
+ *   GatewayEventPayload *event = GatewayEventPayload_decoder_finish(dec); // NULL if malformed or cut short
+ *   GatewayEventPayload_decoder_free(dec);
+ *
+ * With a byte budget, feed returns MASON_PUSH_YIELD after consuming that many
+ * bytes of the chunk so a large payload can be decoded a slice at a time from an
+ * event loop; `consumed` says where to resume. Bytes after the root value are
+ * left unconsumed. finish hands over the struct and readies the decoder for the
+ * next document, reusing its buffers.
+ *
+ * A string_view value fails the document since chunks don't outlive the call.
+ * Containers inside ARRAY_MULTI elements are collected and parsed with cJSON, as
+ * in Foo_decode. A UNION that arrives before its tag is collected the same way
+ * and decoded when its struct closes.
+ */
+
+typedef enum {
+    MASON_PUSH_MORE,  // chunk consumed, the document continues
+    MASON_PUSH_YIELD, // byte budget spent, feed the rest of the chunk again
+    MASON_PUSH_DONE,  // root value complete, take it with finish
+    MASON_PUSH_ERROR  // malformed input or out of memory
+} mason_push_status;
+
+/* Destination of the next value */
+typedef enum {
+    MASON_PUSH_SKIP,
+    MASON_PUSH_VALUE, // FIELD, converted by the owning struct's read function
+    MASON_PUSH_ARRAY,
+    MASON_PUSH_ARRAY_MULTI,
+    MASON_PUSH_OBJECT,
+    MASON_PUSH_ARRAY_OBJECT,
+    MASON_PUSH_STRUCT,  // the root or an ARRAY_OBJECT element, filled where it lies
+    MASON_PUSH_ELEMENT, // ARRAY element
+    MASON_PUSH_RAW,     // ARRAY_MULTI element
+    MASON_PUSH_UNION    // UNION ahead of its tag, kept until the struct closes
+} mason_push_kind;
+
+typedef struct mason_push_type mason_push_type;
+
+typedef struct {
+    mason_push_kind kind;
+    size_t field;                // index in Foo_FieldIndex
+    void *ptr;                   // array or struct member, or the struct or element itself
+    size_t *count;               // array members
+    size_t elem_size;            // array members
+    const mason_push_type *type; // struct filled by OBJECT, ARRAY_OBJECT and STRUCT values
+} mason_push_slot;
+
+/* Per-field flags of a struct being filled: its key was taken, and (FIELDs only) its value decoded */
+enum { _MASON_PUSH_SEEN = 1, _MASON_PUSH_SET = 2 };
+
+/* Generated per struct by MASON_IMPL; read returns whether it stored the value */
+struct mason_push_type {
+    size_t size;
+    size_t fields;
+    bool (*lookup)(void *obj, const uint8_t *seen, const char *key, size_t key_len, mason_push_slot *slot);
+    bool (*read)(void *obj, size_t field, size_t index, mason_reader *r);
+    bool (*defer)(void *obj, const uint8_t *seen, size_t field, const char *json, size_t len);
+    void (*release)(void *obj);
+};
+
+enum {
+    _MASON_PUSH_ROOT,
+    _MASON_PUSH_OBJECT_FRAME, // a struct being filled
+    _MASON_PUSH_ARRAY_FRAME,  // an array member being appended to
+    _MASON_PUSH_SKIP_OBJECT,
+    _MASON_PUSH_SKIP_ARRAY
+};
+
+/* What the innermost container expects next */
+enum { _MASON_PUSH_FIRST, _MASON_PUSH_KEY, _MASON_PUSH_COLON, _MASON_PUSH_VALUE, _MASON_PUSH_NEXT };
+
+enum { _MASON_PUSH_NO_TOKEN, _MASON_PUSH_STRING, _MASON_PUSH_NUMBER, _MASON_PUSH_LITERAL };
+
+typedef struct {
+    uint8_t kind;
+    uint8_t state;
+    mason_push_slot slot;        // array frames: the member being appended to
+    void *obj;                   // object frames: the struct; array frames: the struct owning the member
+    const mason_push_type *type; // type of obj
+    size_t cap;                  // array frames: allocated elements
+    size_t seen;                 // object frames: offset of their duplicate key flags
+} mason_push_frame;
+
+typedef struct {
+    size_t frame; // object frame of the struct owning the union
+    size_t field;
+    size_t at; // span in deferred_json
+    size_t len;
+} mason_push_deferred;
+
+typedef struct {
+    const mason_push_type *type;
+    void *root;
+    mason_push_status status;
+    size_t budget; // bytes per feed, 0 for no limit
+    mason_push_frame *frames;
+    size_t depth; // frames[0] holds the root value
+    size_t frames_cap;
+    uint8_t *seen;
+    size_t seen_len;
+    size_t seen_cap;
+    mason_push_slot target; // where the value being parsed goes
+    uint8_t token;
+    bool escape; // string token: the last byte was a backslash
+    const char *literal;
+    size_t literal_len;
+    size_t literal_pos;
+    const char *mark; // start of the token in the current chunk
+    mason_buf tok;    // token split across chunks
+    size_t capture;   // frame of the ARRAY_MULTI element or UNION being collected, 0 for none
+    size_t capture_field;
+    const char *capture_mark;
+    MASON_RawValue *capture_raw; // NULL for a UNION
+    mason_buf captured;
+    mason_push_deferred *deferred; // unions waiting for their struct to close, innermost last
+    size_t deferred_len;
+    size_t deferred_cap;
+    mason_buf deferred_json;
+} mason_push_decoder;
+
+static inline bool _mason_push_fail(mason_push_decoder *p) {
+    p->status = MASON_PUSH_ERROR;
+    return false;
+}
+
+/* Drops a partial document and starts over, keeping the buffers */
+static inline void mason_push_reset(mason_push_decoder *p) {
+    if (p->root)
+        p->type->release(p->root);
+    p->root = NULL;
+    p->status = MASON_PUSH_MORE;
+    p->depth = 1;
+    memset(&p->frames[0], 0, sizeof(mason_push_frame));
+    p->frames[0].kind = _MASON_PUSH_ROOT;
+    p->frames[0].state = _MASON_PUSH_VALUE;
+    p->seen_len = 0;
+    p->token = _MASON_PUSH_NO_TOKEN;
+    p->capture = 0;
+    p->deferred_len = 0;
+    mason_buf_reset(&p->tok);
+    mason_buf_reset(&p->captured);
+    mason_buf_reset(&p->deferred_json);
+}
+
+static inline bool mason_push_init(mason_push_decoder *p, const mason_push_type *type, size_t budget) {
+    memset(p, 0, sizeof(*p));
+    p->type = type;
+    p->budget = budget;
+    mason_buf_init(&p->tok);
+    mason_buf_init(&p->captured);
+    mason_buf_init(&p->deferred_json);
+    p->frames = (mason_push_frame *)MASON_MALLOC(8 * sizeof(mason_push_frame));
+    if (!p->frames)
+        return false;
+    p->frames_cap = 8;
+    mason_push_reset(p);
+    return true;
+}
+
+static inline void mason_push_destroy(mason_push_decoder *p) {
+    if (p->root)
+        p->type->release(p->root);
+    MASON_FREE(p->frames);
+    MASON_FREE(p->seen);
+    MASON_FREE(p->deferred);
+    mason_buf_free(&p->tok);
+    mason_buf_free(&p->captured);
+    mason_buf_free(&p->deferred_json);
+}
+
+static inline mason_push_frame *_mason_push_open(mason_push_decoder *p, uint8_t kind) {
+    if (p->depth > MASON_READER_NESTING_LIMIT) {
+        _mason_push_fail(p);
+        return NULL;
+    }
+    if (p->depth == p->frames_cap) {
+        size_t cap = p->frames_cap * 2;
+        mason_push_frame *frames = (mason_push_frame *)MASON_REALLOC(p->frames, cap * sizeof(mason_push_frame));
+        if (!frames) {
+            _mason_push_fail(p);
+            return NULL;
+        }
+        p->frames = frames;
+        p->frames_cap = cap;
+    }
+    mason_push_frame *f = &p->frames[p->depth++];
+    memset(f, 0, sizeof(*f));
+    f->kind = kind;
+    f->state = _MASON_PUSH_FIRST;
+    return f;
+}
+
+/* Reserves duplicate key flags for a struct being filled */
+static inline bool _mason_push_open_struct(mason_push_decoder *p, void *obj, const mason_push_type *type) {
+    if (p->seen_len + type->fields > p->seen_cap) {
+        size_t cap = p->seen_cap ? p->seen_cap : 64;
+        while (cap < p->seen_len + type->fields)
+            cap *= 2;
+        uint8_t *seen = (uint8_t *)MASON_REALLOC(p->seen, cap);
+        if (!seen)
+            return _mason_push_fail(p);
+        p->seen = seen;
+        p->seen_cap = cap;
+    }
+    mason_push_frame *f = _mason_push_open(p, _MASON_PUSH_OBJECT_FRAME);
+    if (!f)
+        return false;
+    f->obj = obj;
+    f->type = type;
+    f->seen = p->seen_len;
+    memset(p->seen + p->seen_len, 0, type->fields);
+    p->seen_len += type->fields;
+    return true;
+}
+
+/* A value ended, move its container on to the separator */
+static inline void _mason_push_value_done(mason_push_decoder *p) {
+    mason_push_frame *f = &p->frames[p->depth - 1];
+    if (f->kind == _MASON_PUSH_ROOT)
+        p->status = MASON_PUSH_DONE;
+    else
+        f->state = _MASON_PUSH_NEXT;
+}
+
+/* Keeps a collected union until the struct owning it closes */
+static inline bool _mason_push_defer(mason_push_decoder *p) {
+    if (p->deferred_len == p->deferred_cap) {
+        size_t cap = p->deferred_cap ? p->deferred_cap * 2 : 4;
+        mason_push_deferred *deferred =
+            (mason_push_deferred *)MASON_REALLOC(p->deferred, cap * sizeof(mason_push_deferred));
+        if (!deferred)
+            return _mason_push_fail(p);
+        p->deferred = deferred;
+        p->deferred_cap = cap;
+    }
+    p->deferred[p->deferred_len++] =
+        (mason_push_deferred){p->depth - 1, p->capture_field, p->deferred_json.len, p->captured.len};
+    mason_buf_append(&p->deferred_json, p->captured.data, p->captured.len);
+    return !p->deferred_json.failed || _mason_push_fail(p);
+}
+
+/* Decodes the unions kept for a closing struct, now that its tag is known */
+static inline bool _mason_push_resolve(mason_push_decoder *p, mason_push_frame *f) {
+    size_t first = p->deferred_len;
+    while (first && p->deferred[first - 1].frame == p->depth)
+        first--;
+    for (size_t i = first; i < p->deferred_len; i++) {
+        mason_push_deferred *d = &p->deferred[i];
+        if (!f->type->defer(f->obj, p->seen + f->seen, d->field, p->deferred_json.data + d->at, d->len))
+            return _mason_push_fail(p);
+    }
+    if (first < p->deferred_len) {
+        p->deferred_json.len = p->deferred[first].at;
+        p->deferred_len = first;
+    }
+    return true;
+}
+
+static inline const char *_mason_push_close(mason_push_decoder *p, const char *cur) {
+    mason_push_frame *f = &p->frames[--p->depth];
+    if (f->kind == _MASON_PUSH_OBJECT_FRAME) {
+        p->seen_len = f->seen;
+        if (p->deferred_len && !_mason_push_resolve(p, f))
+            return cur + 1;
+    }
+    if (p->capture == p->depth) {
+        mason_buf_append(&p->captured, p->capture_mark, (size_t)(cur + 1 - p->capture_mark));
+        p->capture = 0;
+        if (p->captured.failed) {
+            _mason_push_fail(p);
+            return cur + 1;
+        }
+        if (!p->capture_raw) {
+            if (!_mason_push_defer(p))
+                return cur + 1;
+        } else {
+            MASON_Parsed dup = mason_parse_sized(p->captured.data, p->captured.len);
+            if (dup)
+                *p->capture_raw =
+                    f->kind == _MASON_PUSH_SKIP_ARRAY ? mason_rawvalue_array(dup) : mason_rawvalue_object(dup);
+        }
+    }
+    _mason_push_value_done(p);
+    return cur + 1;
+}
+
+/* Converts a finished token, or routes a finished key to its field */
+static inline const char *_mason_push_token_end(mason_push_decoder *p, const char *cur) {
+    const char *text = p->mark;
+    size_t len = (size_t)(cur - p->mark);
+    if (p->token == _MASON_PUSH_LITERAL) {
+        text = p->literal;
+        len = p->literal_len;
+    } else if (p->tok.len) {
+        if (cur > p->mark)
+            mason_buf_append(&p->tok, p->mark, (size_t)(cur - p->mark));
+        if (p->tok.failed) {
+            _mason_push_fail(p);
+            return cur;
+        }
+        text = p->tok.data;
+        len = p->tok.len;
+    }
+    p->token = _MASON_PUSH_NO_TOKEN;
+
+    mason_reader r;
+    mason_reader_init(&r, text, len);
+    mason_push_frame *f = &p->frames[p->depth - 1];
+    bool object = f->kind == _MASON_PUSH_OBJECT_FRAME || f->kind == _MASON_PUSH_SKIP_OBJECT;
+    if (object && f->state != _MASON_PUSH_VALUE) {
+        const char *key;
+        size_t key_len;
+        mason_push_slot slot;
+        p->target.kind = MASON_PUSH_SKIP;
+        if (_mason_reader_key(&r, &key, &key_len) && f->kind == _MASON_PUSH_OBJECT_FRAME &&
+            f->type->lookup(f->obj, p->seen + f->seen, key, key_len, &slot) && !p->seen[f->seen + slot.field]) {
+            p->seen[f->seen + slot.field] = _MASON_PUSH_SEEN;
+            p->target = slot;
+        }
+        f->state = _MASON_PUSH_COLON;
+    } else {
+        switch (p->target.kind) {
+        case MASON_PUSH_VALUE:
+            if (f->type->read(f->obj, p->target.field, 0, &r))
+                p->seen[f->seen + p->target.field] |= _MASON_PUSH_SET;
+            break;
+        case MASON_PUSH_ELEMENT:
+            f->type->read(f->obj, f->slot.field, *f->slot.count - 1, &r);
+            break;
+        case MASON_PUSH_RAW:
+            _mason_read_rawvalue(&r, (MASON_RawValue *)p->target.ptr);
+            break;
+        default:
+            mason_reader_skip(&r);
+            break;
+        }
+        _mason_push_value_done(p);
+    }
+    if (r.failed || r.cur != r.end)
+        _mason_push_fail(p);
+    return cur;
+}
+
+static inline bool _mason_push_is_number(char c) {
+    return (c >= '0' && c <= '9') || c == '+' || c == '-' || c == 'e' || c == 'E' || c == '.';
+}
+
+/* Scans the current token, returning `end` if the chunk runs out first */
+static inline const char *_mason_push_token(mason_push_decoder *p, const char *cur, const char *end) {
+    switch (p->token) {
+    case _MASON_PUSH_STRING:
+        while (cur < end) {
+            if (p->escape) {
+                p->escape = false;
+                cur++;
+                continue;
+            }
+            cur = mason_scan_string(cur, end);
+            if (cur == end)
+                break;
+            if (*cur++ == '"')
+                return _mason_push_token_end(p, cur);
+            p->escape = true;
+        }
+        return end;
+    case _MASON_PUSH_NUMBER:
+        while (cur < end && _mason_push_is_number(*cur))
+            cur++;
+        return cur < end ? _mason_push_token_end(p, cur) : end;
+    default:
+        while (cur < end && p->literal_pos < p->literal_len) {
+            if (*cur++ != p->literal[p->literal_pos++]) {
+                _mason_push_fail(p);
+                return end;
+            }
+        }
+        return p->literal_pos == p->literal_len ? _mason_push_token_end(p, cur) : end;
+    }
+}
+
+static inline const char *_mason_push_token_begin(mason_push_decoder *p, const char *cur, const char *end) {
+    char c = *cur;
+    p->mark = cur;
+    mason_buf_reset(&p->tok);
+    if (c == '"') {
+        p->token = _MASON_PUSH_STRING;
+        p->escape = false;
+        return _mason_push_token(p, cur + 1, end);
+    }
+    if (_mason_reader_is_number(c)) {
+        p->token = _MASON_PUSH_NUMBER;
+        return _mason_push_token(p, cur + 1, end);
+    }
+    p->literal = c == 't' ? "true" : c == 'f' ? "false" : c == 'n' ? "null" : NULL;
+    if (!p->literal) {
+        _mason_push_fail(p);
+        return end;
+    }
+    p->token = _MASON_PUSH_LITERAL;
+    p->literal_len = strlen(p->literal);
+    p->literal_pos = 0;
+    return _mason_push_token(p, cur, end);
+}
+
+/* Points the target at the next element of an array, growing it by one zeroed slot */
+static inline bool _mason_push_element(mason_push_decoder *p, mason_push_frame *f) {
+    mason_push_slot *t = &p->target;
+    mason_reader r;
+    void *elem;
+    switch (f->kind) {
+    case _MASON_PUSH_ROOT:
+        p->root = MASON_CALLOC(1, p->type->size);
+        if (!p->root)
+            return _mason_push_fail(p);
+        *t = (mason_push_slot){MASON_PUSH_STRUCT, 0, p->root, NULL, 0, p->type};
+        return true;
+    case _MASON_PUSH_ARRAY_FRAME:
+        mason_reader_init(&r, NULL, 0);
+        elem = _mason_reader_push(&r, (void **)f->slot.ptr, f->slot.count, &f->cap, f->slot.elem_size);
+        if (!elem)
+            return _mason_push_fail(p);
+        if (f->slot.kind == MASON_PUSH_ARRAY)
+            *t = (mason_push_slot){MASON_PUSH_ELEMENT, f->slot.field, elem, NULL, 0, NULL};
+        else if (f->slot.kind == MASON_PUSH_ARRAY_MULTI)
+            *t = (mason_push_slot){MASON_PUSH_RAW, f->slot.field, elem, NULL, 0, NULL};
+        else
+            *t = (mason_push_slot){MASON_PUSH_STRUCT, f->slot.field, elem, NULL, 0, f->slot.type};
+        return true;
+    default:
+        t->kind = MASON_PUSH_SKIP;
+        return true;
+    }
+}
+
+/* Starts a value: containers push a frame, scalars start a token */
+static inline const char *_mason_push_value(mason_push_decoder *p, const char *cur, const char *end) {
+    mason_push_slot *t = &p->target;
+    char c = *cur;
+    if (c != '{' && c != '[')
+        return _mason_push_token_begin(p, cur, end);
+    if ((t->kind == MASON_PUSH_RAW || (t->kind == MASON_PUSH_UNION && c == '{')) && !p->capture) {
+        p->capture = p->depth;
+        p->capture_field = t->field;
+        p->capture_raw = t->kind == MASON_PUSH_RAW ? (MASON_RawValue *)t->ptr : NULL;
+        p->capture_mark = cur;
+        mason_buf_reset(&p->captured);
+    }
+    if (c == '{' && (t->kind == MASON_PUSH_STRUCT || t->kind == MASON_PUSH_OBJECT)) {
+        void *obj = t->ptr;
+        if (t->kind == MASON_PUSH_OBJECT) {
+            if (!(obj = MASON_CALLOC(1, t->type->size))) {
+                _mason_push_fail(p);
+                return end;
+            }
+            *(void **)t->ptr = obj;
+        }
+        _mason_push_open_struct(p, obj, t->type);
+    } else if (c == '[' && (t->kind == MASON_PUSH_ARRAY || t->kind == MASON_PUSH_ARRAY_MULTI ||
+                            t->kind == MASON_PUSH_ARRAY_OBJECT)) {
+        mason_push_frame *owner = &p->frames[p->depth - 1];
+        void *obj = owner->obj;
+        const mason_push_type *type = owner->type;
+        mason_push_slot slot = *t;
+        mason_push_frame *f = _mason_push_open(p, _MASON_PUSH_ARRAY_FRAME);
+        if (f) {
+            f->slot = slot;
+            f->obj = obj;
+            f->type = type;
+        }
+    } else {
+        _mason_push_open(p, c == '{' ? _MASON_PUSH_SKIP_OBJECT : _MASON_PUSH_SKIP_ARRAY);
+    }
+    return cur + 1;
+}
+
+/* Consumes one structural byte or token */
+static inline const char *_mason_push_step(mason_push_decoder *p, const char *cur, const char *end) {
+    mason_push_frame *f = &p->frames[p->depth - 1];
+    bool object = f->kind == _MASON_PUSH_OBJECT_FRAME || f->kind == _MASON_PUSH_SKIP_OBJECT;
+    char c = *cur;
+    switch (f->state) {
+    case _MASON_PUSH_NEXT:
+        if (c == ',') {
+            f->state = object ? _MASON_PUSH_KEY : _MASON_PUSH_VALUE;
+            return cur + 1;
+        }
+        if (c == (object ? '}' : ']'))
+            return _mason_push_close(p, cur);
+        _mason_push_fail(p);
+        return end;
+    case _MASON_PUSH_COLON:
+        if (c != ':') {
+            _mason_push_fail(p);
+            return end;
+        }
+        f->state = _MASON_PUSH_VALUE;
+        return cur + 1;
+    case _MASON_PUSH_FIRST:
+        if (c == (object ? '}' : ']'))
+            return _mason_push_close(p, cur);
+        /* fallthrough */
+    default:
+        if (object && f->state != _MASON_PUSH_VALUE) {
+            if (c != '"') {
+                _mason_push_fail(p);
+                return end;
+            }
+            return _mason_push_token_begin(p, cur, end);
+        }
+        if (!object && !_mason_push_element(p, f))
+            return end;
+        return _mason_push_value(p, cur, end);
+    }
+}
+
+static inline mason_push_status mason_push_feed(mason_push_decoder *p, const char *chunk, size_t len,
+                                                size_t *consumed) {
+    if (consumed)
+        *consumed = 0;
+    if (p->status == MASON_PUSH_DONE || p->status == MASON_PUSH_ERROR)
+        return p->status;
+    if (!chunk) {
+        if (len)
+            _mason_push_fail(p);
+        return p->status;
+    }
+    const char *cur = chunk, *end = chunk + len;
+    const char *stop = p->budget && p->budget < len ? chunk + p->budget : end;
+    p->status = MASON_PUSH_MORE;
+    p->mark = chunk;
+    p->capture_mark = chunk;
+    if (p->token)
+        cur = _mason_push_token(p, cur, end);
+    while (cur < end && p->status == MASON_PUSH_MORE) {
+        if (cur >= stop) {
+            p->status = MASON_PUSH_YIELD;
+            break;
+        }
+        if ((unsigned char)*cur <= 32)
+            cur++;
+        else
+            cur = _mason_push_step(p, cur, end);
+    }
+    if (p->status == MASON_PUSH_ERROR)
+        return p->status;
+
+    /* Keep whatever the next chunk continues */
+    if (p->token && p->token != _MASON_PUSH_LITERAL)
+        mason_buf_append(&p->tok, p->mark, (size_t)(cur - p->mark));
+    if (p->capture)
+        mason_buf_append(&p->captured, p->capture_mark, (size_t)(cur - p->capture_mark));
+    if (p->tok.failed || p->captured.failed)
+        _mason_push_fail(p);
+    else if (consumed)
+        *consumed = (size_t)(cur - chunk);
+    return p->status;
+}
+
+/* Ends the input and returns the decoded struct, or NULL if the document was malformed or incomplete */
+static inline void *mason_push_finish(mason_push_decoder *p) {
+    /* A number only ends at the next byte, so a bare number root ends here */
+    if (p->token == _MASON_PUSH_NUMBER && p->status != MASON_PUSH_ERROR) {
+        p->mark = NULL;
+        _mason_push_token_end(p, NULL);
+    }
+    void *root = NULL;
+    if (p->status == MASON_PUSH_DONE) {
+        root = p->root;
+        p->root = NULL;
+    }
+    mason_push_reset(p);
+    return root;
+}
+
+/* Field Routing */
+
+#define _MASON_PUSH_SLOT(kind, name, ptr, count, elem_size, type)                                    \
+    else if (_MASON_KEY_MATCH(name)) {                                                               \
+        *slot = (mason_push_slot){kind, offsetof(_mason_fields, name), ptr, count, elem_size, type}; \
+    }
+
+#define _MASON_PUSH_READ_FIELD(type, name)        \
+    if (field == offsetof(_mason_fields, name)) { \
+        _MASON_TYPE_ALIAS(type) _mason_value;     \
+        if (!mason_read(r, &_mason_value))        \
+            return false;                         \
+        obj->name = (type)_mason_value;           \
+        return true;                              \
+    }
+
+#define _MASON_PUSH_READ_ARRAY(type, name)        \
+    if (field == offsetof(_mason_fields, name)) { \
+        _MASON_TYPE_ALIAS(type) _mason_value;     \
+        if (!mason_read(r, &_mason_value))        \
+            return false;                         \
+        obj->name[index] = (type)_mason_value;    \
+        return true;                              \
+    }
+
+/* A union whose tag already decoded is filled in place like an OBJECT */
+#define _MASON_PUSH_UNION_CASE(value, case_type, member) \
+    _MASON_UNION_CASE(value) {                           \
+        slot->kind = MASON_PUSH_OBJECT;                  \
+        slot->type = case_type##_push_type();            \
+    }
+
+#define _MASON_PUSH_UNION(tag, name, CASES)                                                                        \
+    else if (_MASON_KEY_MATCH(name)) {                                                                             \
+        *slot = (mason_push_slot){MASON_PUSH_UNION, offsetof(_mason_fields, name), &obj->name.ptr, NULL, 0, NULL}; \
+        if (seen[offsetof(_mason_fields, tag)] & _MASON_PUSH_SET) {                                                \
+            _MASON_UNION_SWITCH(tag, name)                                                                         \
+            CASES(_MASON_PUSH_UNION_CASE)                                                                          \
+            else {                                                                                                 \
+                slot->kind = MASON_PUSH_SKIP;                                                                      \
+            }                                                                                                      \
+        }                                                                                                          \
+    }
+
+#define _MASON_PUSH_DEFER(tag, name, CASES)                       \
+    if (field == offsetof(_mason_fields, name)) {                 \
+        if (seen[offsetof(_mason_fields, tag)] & _MASON_PUSH_SET) \
+            _MASON_DECODE_UNION_VALUE(tag, name, CASES)           \
+        return !r->failed;                                        \
+    }
+
+/* X-Macro Expansion Helpers for the Push Decoder */
+
+#define _MASON_EXPAND_PUSH_FIELD(type, name) _MASON_PUSH_SLOT(MASON_PUSH_VALUE, name, NULL, NULL, 0, NULL)
+#define _MASON_EXPAND_PUSH_ARRAY(type, name) \
+    _MASON_PUSH_SLOT(MASON_PUSH_ARRAY, name, &obj->name, &obj->name##_count, sizeof(type), NULL)
+#define _MASON_EXPAND_PUSH_ARRAY_MULTI(name) \
+    _MASON_PUSH_SLOT(MASON_PUSH_ARRAY_MULTI, name, &obj->name, &obj->name##_count, sizeof(MASON_RawValue), NULL)
+#define _MASON_EXPAND_PUSH_OBJECT(type, name) \
+    _MASON_PUSH_SLOT(MASON_PUSH_OBJECT, name, &obj->name, NULL, 0, type##_push_type())
+#define _MASON_EXPAND_PUSH_ARRAY_OBJECT(type, name) \
+    _MASON_PUSH_SLOT(MASON_PUSH_ARRAY_OBJECT, name, &obj->name, &obj->name##_count, sizeof(type), type##_push_type())
+#define _MASON_EXPAND_PUSH_UNION(tag, name, CASES) _MASON_PUSH_UNION(tag, name, CASES)
+#define _MASON_EXPAND_PUSH_READ_FIELD(type, name) _MASON_PUSH_READ_FIELD(type, name)
+#define _MASON_EXPAND_PUSH_READ_ARRAY(type, name) _MASON_PUSH_READ_ARRAY(type, name)
+#define _MASON_EXPAND_PUSH_NONE(type, name)
+#define _MASON_EXPAND_PUSH_NONE_MULTI(name)
+#define _MASON_EXPAND_PUSH_NONE_UNION(tag, name, CASES)
+#define _MASON_EXPAND_PUSH_DEFER(tag, name, CASES) _MASON_PUSH_DEFER(tag, name, CASES)
+
+/* Partial push decoder impl
+ *
+ * _push_type describes the struct to the generic decoder: lookup maps a key to
+ * its member, read converts a scalar into a FIELD or ARRAY element, and defer
+ * decodes a UNION that was collected before its tag.
+ */
+#define _MASON_IMPL_PUSH(struct_name, FIELDS)                                                               \
+    static bool struct_name##_push_lookup(void *_mason_obj, const uint8_t *seen, const char *_mason_key,    \
+                                          size_t _mason_key_len, mason_push_slot *slot) {                   \
+        typedef struct_name##_FieldIndex _mason_fields;                                                     \
+        struct_name *obj = (struct_name *)_mason_obj;                                                       \
+        size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                     \
+        (void)obj;                                                                                          \
+        (void)seen;                                                                                         \
+        if (0) {                                                                                            \
+        }                                                                                                   \
+        FIELDS(_MASON_EXPAND_PUSH_FIELD, _MASON_EXPAND_PUSH_ARRAY, _MASON_EXPAND_PUSH_ARRAY_MULTI,          \
+               _MASON_EXPAND_PUSH_OBJECT, _MASON_EXPAND_PUSH_ARRAY_OBJECT, _MASON_EXPAND_PUSH_UNION)        \
+        else {                                                                                              \
+            return false;                                                                                   \
+        }                                                                                                   \
+        return true;                                                                                        \
+    }                                                                                                       \
+                                                                                                            \
+    static bool struct_name##_push_read(void *_mason_obj, size_t field, size_t index, mason_reader *r) {    \
+        typedef struct_name##_FieldIndex _mason_fields;                                                     \
+        struct_name *obj = (struct_name *)_mason_obj;                                                       \
+        FIELDS(_MASON_EXPAND_PUSH_READ_FIELD, _MASON_EXPAND_PUSH_READ_ARRAY, _MASON_EXPAND_PUSH_NONE_MULTI, \
+               _MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_NONE_UNION)             \
+        (void)obj;                                                                                          \
+        (void)field;                                                                                        \
+        (void)index;                                                                                        \
+        (void)sizeof(_mason_fields);                                                                        \
+        mason_reader_skip(r);                                                                               \
+        return false;                                                                                       \
+    }                                                                                                       \
+                                                                                                            \
+    static bool struct_name##_push_defer(void *_mason_obj, const uint8_t *seen, size_t field,               \
+                                         const char *json, size_t len) {                                    \
+        typedef struct_name##_FieldIndex _mason_fields;                                                     \
+        struct_name *obj = (struct_name *)_mason_obj;                                                       \
+        mason_reader _mason_r, *r = &_mason_r;                                                              \
+        mason_reader_init(r, json, len);                                                                    \
+        FIELDS(_MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_NONE_MULTI,             \
+               _MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_NONE, _MASON_EXPAND_PUSH_DEFER)                  \
+        (void)obj;                                                                                          \
+        (void)seen;                                                                                         \
+        (void)field;                                                                                        \
+        (void)sizeof(_mason_fields);                                                                        \
+        return true;                                                                                        \
+    }                                                                                                       \
+                                                                                                            \
+    static void struct_name##_push_release(void *obj) { struct_name##_free((struct_name *)obj); }           \
+                                                                                                            \
+    const mason_push_type *struct_name##_push_type(void) {                                                  \
+        static const mason_push_type _mason_type = {sizeof(struct_name), sizeof(struct_name##_FieldIndex),  \
+                                                    struct_name##_push_lookup, struct_name##_push_read,     \
+                                                    struct_name##_push_defer, struct_name##_push_release};  \
+        return &_mason_type;                                                                                \
+    }                                                                                                       \
+                                                                                                            \
+    struct_name##_decoder *struct_name##_decoder_create(size_t budget) {                                    \
+        struct_name##_decoder *dec = (struct_name##_decoder *)MASON_MALLOC(sizeof(struct_name##_decoder));  \
+        if (!dec)                                                                                           \
+            return NULL;                                                                                    \
+        if (!mason_push_init(&dec->push, struct_name##_push_type(), budget)) {                              \
+            MASON_FREE(dec);                                                                                \
+            return NULL;                                                                                    \
+        }                                                                                                   \
+        return dec;                                                                                         \
+    }                                                                                                       \
+                                                                                                            \
+    mason_push_status struct_name##_decoder_feed(struct_name##_decoder *dec, const char *chunk, size_t len, \
+                                                 size_t *consumed) {                                        \
+        return mason_push_feed(&dec->push, chunk, len, consumed);                                           \
+    }                                                                                                       \
+                                                                                                            \
+    struct_name *struct_name##_decoder_finish(struct_name##_decoder *dec) {                                 \
+        return (struct_name *)mason_push_finish(&dec->push);                                                \
+    }                                                                                                       \
+                                                                                                            \
+    void struct_name##_decoder_free(struct_name##_decoder *dec) {                                           \
+        if (!dec)                                                                                           \
+            return;                                                                                         \
+        mason_push_destroy(&dec->push);                                                                     \
+        MASON_FREE(dec);                                                                                    \
+    }
+
+#endif // MASON_PUSH_H
@@ -0,0 +1,111 @@
+#ifndef MASON_SIMD_H
+#define MASON_SIMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* String Scan Kernels
+ *
+ * Encoding and decoding strings mostly means finding the next byte that needs
+ * attention: a quote or backslash when reading a literal, and additionally a
+ * control character when writing one. Everything in between is copied as one
+ * run. On x86-64 these scans test 16 bytes at a time with SSE2 (always present)
+ * or 32 with AVX2 when the CPU has it, checked at runtime so one binary runs
+ * everywhere; other targets, and inputs shorter than a vector, use the scalar
+ * loop. Define MASON_NO_SIMD to always use the scalar loop.
+ *
+ * Kernels only read inside [p, end) and stop at the first match, so callers
+ * get the same answer whichever kernel ran.
+ */
+
+#if !defined(MASON_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MASON_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef MASON_SIMD_X86
+
+#define _MASON_AVX2 __attribute__((target("avx2")))
+
+static inline bool _mason_cpu_has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+
+/* Quote or backslash */
+static inline const char *_mason_scan_string_sse2(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        int hits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        if (hits)
+            return p + __builtin_ctz((unsigned)hits);
+    }
+    return p;
+}
+
+_MASON_AVX2 static inline const char *_mason_scan_string_avx2(const char *p, const char *end) {
+    const __m256i quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\');
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        int hits = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+        if (hits)
+            return p + __builtin_ctz((unsigned)hits);
+    }
+    return p;
+}
+
+/* Quote, backslash or a control character; unsigned v <= 0x1F is max(v, 0x1F) == 0x1F */
+static inline const char *_mason_scan_escape_sse2(const char *p, const char *end) {
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+        int hits = _mm_movemask_epi8(special);
+        if (hits)
+            return p + __builtin_ctz((unsigned)hits);
+    }
+    return p;
+}
+
+_MASON_AVX2 static inline const char *_mason_scan_escape_avx2(const char *p, const char *end) {
+    const __m256i quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\'), ctrl = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+        int hits = _mm256_movemask_epi8(special);
+        if (hits)
+            return p + __builtin_ctz((unsigned)hits);
+    }
+    return p;
+}
+
+#endif // MASON_SIMD_X86
+
+/* Returns the first quote or backslash in [p, end), or `end` */
+static inline const char *mason_scan_string(const char *p, const char *end) {
+#ifdef MASON_SIMD_X86
+    if (end - p >= 32 && _mason_cpu_has_avx2())
+        p = _mason_scan_string_avx2(p, end);
+    else if (end - p >= 16)
+        p = _mason_scan_string_sse2(p, end);
+#endif
+    while (p < end && *p != '"' && *p != '\\')
+        p++;
+    return p;
+}
+
+/* Returns the first byte in [p, end) that must be escaped in a JSON string, or `end` */
+static inline const char *mason_scan_escape(const char *p, const char *end) {
+#ifdef MASON_SIMD_X86
+    if (end - p >= 32 && _mason_cpu_has_avx2())
+        p = _mason_scan_escape_avx2(p, end);
+    else if (end - p >= 16)
+        p = _mason_scan_escape_sse2(p, end);
+#endif
+    while (p < end && (unsigned char)*p >= 0x20 && *p != '"' && *p != '\\')
+        p++;
+    return p;
+}
+
+#endif // MASON_SIMD_H
@@ -0,0 +1,623 @@
+#ifndef MASON_SNAPSHOT_H
+#define MASON_SNAPSHOT_H
+
+/* Flat Snapshots
+ *
+ * Foo_snapshot_write copies a struct and everything it owns (strings, arrays,
+ * nested objects and unions, ARRAY_MULTI values and their JSON trees) into one
+ * contiguous image in which every pointer is stored as an offset from the image
+ * start. Foo_snapshot_load turns those offsets back into pointers in place and
+ * returns the root struct, which lives inside the image: loading allocates
+ * nothing and parses no text. Interned strings are looked up in the intern table
+ * again so pointer comparison keeps working.
+ *
+ *   size_t size = Foo_snapshot_size(obj);
+ *   void *image = malloc(size);
+ *   Foo_snapshot_write(obj, image, size); // store it anywhere
+ *   ...
+ *   mason_file file;
+ *   Foo *cached = Foo_snapshot_from_file("cache.snap", &file);
+ *   mason_unmap_file(&file); // when done, instead of Foo_free
+ *
+ * NOTE: images are only valid on the ABI that wrote them and for the same
+ * FIELDS, which the header records and the loader checks for the root and every
+ * struct it can reach. Loading validates every offset and bool; other numbers
+ * are taken as stored. Never pass a loaded struct to Foo_free; release the
+ * image instead. A failed load may leave the image half patched, so don't
+ * retry it.
+ */
+
+#define MASON_SNAPSHOT_MAGIC   "MASONSNP"
+#define MASON_SNAPSHOT_VERSION 1
+#define MASON_SNAPSHOT_ALIGN   8
+
+/* Self-referencing types stop folding nested layouts in after this many levels */
+#define MASON_SNAPSHOT_LAYOUT_DEPTH 8
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t root_size; // sizeof the root struct
+    uint64_t size;      // whole image, header included
+    uint64_t layout;    // hash of the FIELDS and sizes of every struct reachable from the root
+} mason_snapshot_header;
+
+static inline size_t _mason_snapshot_align(size_t n) {
+    return (n + MASON_SNAPSHOT_ALIGN - 1) & ~(size_t)(MASON_SNAPSHOT_ALIGN - 1);
+}
+
+/* Copies n bytes to the cursor and returns their offset */
+static inline uintptr_t _mason_snapshot_copy(char *base, size_t *cursor, const void *src, size_t n) {
+    size_t off = *cursor;
+    memcpy(base + off, src, n);
+    *cursor += _mason_snapshot_align(n);
+    return off;
+}
+
+/* Turns a stored offset into a pointer to `count` elements of `size` bytes; offset 0 is NULL */
+static inline bool _mason_snapshot_resolve(void **ptr, char *base, size_t len, size_t count, size_t size) {
+    uintptr_t off = (uintptr_t)*ptr;
+    if (!off)
+        return true;
+    if (off % MASON_SNAPSHOT_ALIGN || off < sizeof(mason_snapshot_header) || off >= len || count > (len - off) / size)
+        return false;
+    *ptr = base + off;
+    return true;
+}
+
+static inline bool _mason_snapshot_check(char *base, size_t len, size_t root_size, uint64_t layout) {
+    if (!base || (uintptr_t)base % MASON_SNAPSHOT_ALIGN || len < sizeof(mason_snapshot_header) + root_size)
+        return false;
+    const mason_snapshot_header *h = (const mason_snapshot_header *)base;
+    return memcmp(h->magic, MASON_SNAPSHOT_MAGIC, sizeof(h->magic)) == 0 && h->version == MASON_SNAPSHOT_VERSION &&
+           h->root_size == root_size && h->layout == layout && h->size >= sizeof(*h) + root_size && h->size <= len;
+}
+
+/* Strings */
+
+static inline size_t _mason_snapshot_extent_str(const char *s) { return s ? _mason_snapshot_align(strlen(s) + 1) : 0; }
+
+/* What a copy at `off` is linked by: its offset in an image (`relative`), or a pointer in a clone; offset 0 is NULL */
+static inline void *_mason_snapshot_link(char *base, uintptr_t off, bool relative) {
+    if (!off)
+        return NULL;
+    return relative ? (void *)off : base + off;
+}
+
+static inline void _mason_snapshot_copy_str(const char **s, char *base, size_t *cursor, bool relative) {
+    if (*s)
+        *s = (const char *)_mason_snapshot_link(base, _mason_snapshot_copy(base, cursor, *s, strlen(*s) + 1), relative);
+}
+
+static inline void _mason_snapshot_place_str(const char **s, char *base, size_t *cursor) {
+    _mason_snapshot_copy_str(s, base, cursor, true);
+}
+
+static inline bool _mason_snapshot_fixup_str(const char **s, char *base, size_t len) {
+    if (!_mason_snapshot_resolve((void **)s, base, len, 1, 1))
+        return false;
+    return !*s || memchr(*s, '\0', (size_t)(base + len - *s)) != NULL;
+}
+
+/* Value Handlers (dispatched on a pointer to the field's alias type) */
+
+static inline size_t mason_snapshot_extent_scalar(const void *v) {
+    (void)v;
+    return 0;
+}
+
+static inline size_t mason_snapshot_extent_string(char **v) { return _mason_snapshot_extent_str(*v); }
+
+static inline size_t mason_snapshot_extent_string_view(const char **v) { return _mason_snapshot_extent_str(*v); }
+
+static inline size_t mason_snapshot_extent_interned(mason_interned_t *v) {
+    return _mason_snapshot_extent_str((const char *)*v);
+}
+
+#define mason_snapshot_extent(v) _Generic((v),          \
+    int32_t *: mason_snapshot_extent_scalar,            \
+    int64_t *: mason_snapshot_extent_scalar,            \
+    double *: mason_snapshot_extent_scalar,             \
+    char **: mason_snapshot_extent_string,              \
+    const char **: mason_snapshot_extent_string_view,   \
+    mason_interned_t *: mason_snapshot_extent_interned, \
+    _Bool *: mason_snapshot_extent_scalar)(v)
+
+static inline void mason_snapshot_place_scalar(const void *v, char *base, size_t *cursor) {
+    (void)v;
+    (void)base;
+    (void)cursor;
+}
+
+static inline void mason_snapshot_place_string(char **v, char *base, size_t *cursor) {
+    _mason_snapshot_place_str((const char **)v, base, cursor);
+}
+
+static inline void mason_snapshot_place_string_view(const char **v, char *base, size_t *cursor) {
+    _mason_snapshot_place_str(v, base, cursor);
+}
+
+static inline void mason_snapshot_place_interned(mason_interned_t *v, char *base, size_t *cursor) {
+    _mason_snapshot_place_str((const char **)v, base, cursor);
+}
+
+#define mason_snapshot_place(v, base, cursor) _Generic((v), \
+    int32_t *: mason_snapshot_place_scalar,                 \
+    int64_t *: mason_snapshot_place_scalar,                 \
+    double *: mason_snapshot_place_scalar,                  \
+    char **: mason_snapshot_place_string,                   \
+    const char **: mason_snapshot_place_string_view,        \
+    mason_interned_t *: mason_snapshot_place_interned,      \
+    _Bool *: mason_snapshot_place_scalar)(v, base, cursor)
+
+/* A bool byte other than 0 or 1 is a corrupt image, and loading it as a bool is undefined */
+static inline bool _mason_snapshot_valid_bool(const void *v) {
+    unsigned char byte;
+    memcpy(&byte, v, 1);
+    return byte <= 1;
+}
+
+static inline bool _mason_snapshot_valid_scalar(const void *v) {
+    (void)v;
+    return true;
+}
+
+/* Checks a field's stored bytes before they are loaded as its type */
+#define _mason_snapshot_valid(p) _Generic((p), \
+    _Bool *: _mason_snapshot_valid_bool,       \
+    default: _mason_snapshot_valid_scalar)(p)
+
+static inline bool mason_snapshot_fixup_scalar(const void *v, char *base, size_t len) {
+    (void)v;
+    (void)base;
+    (void)len;
+    return true;
+}
+
+static inline bool mason_snapshot_fixup_string(char **v, char *base, size_t len) {
+    return _mason_snapshot_fixup_str((const char **)v, base, len);
+}
+
+static inline bool mason_snapshot_fixup_string_view(const char **v, char *base, size_t len) {
+    return _mason_snapshot_fixup_str(v, base, len);
+}
+
+/* Swaps the image's copy for the canonical one */
+static inline bool mason_snapshot_fixup_interned(mason_interned_t *v, char *base, size_t len) {
+    const char *s = (const char *)*v;
+    if (!_mason_snapshot_fixup_str(&s, base, len))
+        return false;
+    if (s && !(s = mason_intern(s, strlen(s))))
+        return false;
+    *v = (mason_interned_t)s;
+    return true;
+}
+
+#define mason_snapshot_fixup(v, base, len) _Generic((v), \
+    int32_t *: mason_snapshot_fixup_scalar,              \
+    int64_t *: mason_snapshot_fixup_scalar,              \
+    double *: mason_snapshot_fixup_scalar,               \
+    char **: mason_snapshot_fixup_string,                \
+    const char **: mason_snapshot_fixup_string_view,     \
+    mason_interned_t *: mason_snapshot_fixup_interned,   \
+    _Bool *: mason_snapshot_fixup_scalar)(v, base, len)
+
+/* ARRAY_MULTI values; JSON trees are copied node by node */
+
+static inline size_t _mason_snapshot_ast_extent(MASON_Parsed node) {
+    size_t size = 0;
+    for (; node; node = node->next)
+        size += _mason_snapshot_align(sizeof(*node)) + _mason_snapshot_extent_str(node->string) +
+                _mason_snapshot_extent_str(node->valuestring) + _mason_snapshot_ast_extent(node->child);
+    return size;
+}
+
+/* Copies a sibling list to the cursor and returns its first node; links are made by _mason_snapshot_link, so
+ * Foo_clone copies JSON trees with this too */
+static inline MASON_Parsed _mason_snapshot_ast_copy(MASON_Parsed node, char *base, size_t *cursor, bool relative) {
+    uintptr_t first = 0, last = 0;
+    for (; node; node = node->next) {
+        uintptr_t off = _mason_snapshot_copy(base, cursor, node, sizeof(*node));
+        MASON_Parsed copy = (MASON_Parsed)(base + off);
+        copy->next = NULL;
+        copy->prev = (MASON_Parsed)_mason_snapshot_link(base, last, relative);
+        _mason_snapshot_copy_str((const char **)&copy->string, base, cursor, relative);
+        _mason_snapshot_copy_str((const char **)&copy->valuestring, base, cursor, relative);
+        copy->child = _mason_snapshot_ast_copy(node->child, base, cursor, relative);
+        if (last)
+            ((MASON_Parsed)(base + last))->next = (MASON_Parsed)_mason_snapshot_link(base, off, relative);
+        else
+            first = off;
+        last = off;
+    }
+    /* The first sibling's prev points at the last one */
+    if (first)
+        ((MASON_Parsed)(base + first))->prev = (MASON_Parsed)_mason_snapshot_link(base, last, relative);
+    return (MASON_Parsed)_mason_snapshot_link(base, first, relative);
+}
+
+static inline bool _mason_snapshot_ast_fixup(MASON_Parsed *head, char *base, size_t len, size_t depth) {
+    if (depth >= MASON_READER_NESTING_LIMIT ||
+        !_mason_snapshot_resolve((void **)head, base, len, 1, sizeof(**head)))
+        return false;
+    for (MASON_Parsed node = *head; node; node = node->next) {
+        if (!_mason_snapshot_resolve((void **)&node->next, base, len, 1, sizeof(*node)) ||
+            !_mason_snapshot_resolve((void **)&node->prev, base, len, 1, sizeof(*node)) ||
+            !_mason_snapshot_fixup_str((const char **)&node->string, base, len) ||
+            !_mason_snapshot_fixup_str((const char **)&node->valuestring, base, len) ||
+            !_mason_snapshot_ast_fixup(&node->child, base, len, depth + 1))
+            return false;
+    }
+    return true;
+}
+
+static inline size_t _mason_snapshot_rawvalue_extent(const MASON_RawValue *v) {
+    switch (v->type) {
+    case MASON_VALUE_STRING:
+        return _mason_snapshot_extent_str(v->value.s);
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        return _mason_snapshot_ast_extent(v->value.ast);
+    default:
+        return 0;
+    }
+}
+
+static inline void _mason_snapshot_rawvalue_place(MASON_RawValue *v, char *base, size_t *cursor) {
+    switch (v->type) {
+    case MASON_VALUE_STRING:
+        _mason_snapshot_place_str((const char **)&v->value.s, base, cursor);
+        break;
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        v->value.ast = _mason_snapshot_ast_copy(v->value.ast, base, cursor, true);
+        break;
+    default:
+        break;
+    }
+}
+
+static inline bool _mason_snapshot_rawvalue_fixup(MASON_RawValue *v, char *base, size_t len, size_t depth) {
+    switch (v->type) {
+    case MASON_VALUE_BOOL:
+        return _mason_snapshot_valid_bool(&v->value.b);
+    case MASON_VALUE_STRING:
+        return _mason_snapshot_fixup_str((const char **)&v->value.s, base, len);
+    case MASON_VALUE_OBJECT:
+    case MASON_VALUE_ARRAY:
+        return _mason_snapshot_ast_fixup(&v->value.ast, base, len, depth);
+    default:
+        return true;
+    }
+}
+
+/* Field Extents */
+
+#define _MASON_SNAPSHOT_EXTENT_FIELD(type, name)                                   \
+    {                                                                              \
+        _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))obj->name; \
+        _mason_size += mason_snapshot_extent(&_mason_value);                       \
+    }
+
+#define _MASON_SNAPSHOT_EXTENT_ARRAY_PRIM(type, name)                                     \
+    if (obj->name && obj->name##_count) {                                                 \
+        _mason_size += _mason_snapshot_align(obj->name##_count * sizeof(type));           \
+        for (size_t i = 0; i < obj->name##_count; i++) {                                  \
+            _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))obj->name[i]; \
+            _mason_size += mason_snapshot_extent(&_mason_value);                          \
+        }                                                                                 \
+    }
+
+#define _MASON_SNAPSHOT_EXTENT_ARRAY_MULTI(name)                                          \
+    if (obj->name && obj->name##_count) {                                                 \
+        _mason_size += _mason_snapshot_align(obj->name##_count * sizeof(MASON_RawValue)); \
+        for (size_t i = 0; i < obj->name##_count; i++)                                    \
+            _mason_size += _mason_snapshot_rawvalue_extent(&obj->name[i]);                \
+    }
+
+#define _MASON_SNAPSHOT_EXTENT_OBJECT(type, name) \
+    if (obj->name)                                \
+        _mason_size += _mason_snapshot_align(sizeof(struct type)) + type##_snapshot_extent(obj->name);
+
+#define _MASON_SNAPSHOT_EXTENT_ARRAY_OBJECT(type, name)                         \
+    if (obj->name && obj->name##_count) {                                       \
+        _mason_size += _mason_snapshot_align(obj->name##_count * sizeof(type)); \
+        for (size_t i = 0; i < obj->name##_count; i++)                          \
+            _mason_size += type##_snapshot_extent(&obj->name[i]);               \
+    }
+
+#define _MASON_SNAPSHOT_EXTENT_UNION_CASE(value, type, member)                                                         \
+    _MASON_UNION_CASE(value) {                                                                                         \
+        _mason_size += _mason_snapshot_align(sizeof(struct type)) + type##_snapshot_extent((type *)*_mason_union_ptr); \
+    }
+
+#define _MASON_SNAPSHOT_EXTENT_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                               \
+        _MASON_UNION_SWITCH(tag, name)                 \
+        CASES(_MASON_SNAPSHOT_EXTENT_UNION_CASE)       \
+    }
+
+/* Field Placement (dst is the image's copy, still holding the source pointers) */
+
+#define _MASON_SNAPSHOT_PLACE_FIELD(type, name)                                    \
+    {                                                                              \
+        _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))dst->name; \
+        mason_snapshot_place(&_mason_value, base, cursor);                         \
+        dst->name = (type)_mason_value;                                            \
+    }
+
+#define _MASON_SNAPSHOT_PLACE_ARRAY_PRIM(type, name)                                                            \
+    if (dst->name && dst->name##_count) {                                                                       \
+        uintptr_t _mason_off = _mason_snapshot_copy(base, cursor, dst->name, dst->name##_count * sizeof(type)); \
+        type *_mason_arr = (type *)(base + _mason_off);                                                         \
+        for (size_t i = 0; i < dst->name##_count; i++) {                                                        \
+            _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))_mason_arr[i];                      \
+            mason_snapshot_place(&_mason_value, base, cursor);                                                  \
+            _mason_arr[i] = (type)_mason_value;                                                                 \
+        }                                                                                                       \
+        dst->name = (type *)_mason_off;                                                                         \
+    } else {                                                                                                    \
+        dst->name = NULL;                                                                                       \
+        dst->name##_count = 0;                                                                                  \
+    }
+
+#define _MASON_SNAPSHOT_PLACE_ARRAY_MULTI(name)                                                        \
+    if (dst->name && dst->name##_count) {                                                              \
+        uintptr_t _mason_off =                                                                         \
+            _mason_snapshot_copy(base, cursor, dst->name, dst->name##_count * sizeof(MASON_RawValue)); \
+        MASON_RawValue *_mason_arr = (MASON_RawValue *)(base + _mason_off);                            \
+        for (size_t i = 0; i < dst->name##_count; i++)                                                 \
+            _mason_snapshot_rawvalue_place(&_mason_arr[i], base, cursor);                              \
+        dst->name = (MASON_RawValue *)_mason_off;                                                      \
+    } else {                                                                                           \
+        dst->name = NULL;                                                                              \
+        dst->name##_count = 0;                                                                         \
+    }
+
+#define _MASON_SNAPSHOT_PLACE_OBJECT(type, name)                                                   \
+    if (dst->name) {                                                                               \
+        uintptr_t _mason_off = _mason_snapshot_copy(base, cursor, dst->name, sizeof(struct type)); \
+        type##_snapshot_place((struct type *)(base + _mason_off), base, cursor);                   \
+        dst->name = (struct type *)_mason_off;                                                     \
+    }
+
+#define _MASON_SNAPSHOT_PLACE_ARRAY_OBJECT(type, name)                                                          \
+    if (dst->name && dst->name##_count) {                                                                       \
+        uintptr_t _mason_off = _mason_snapshot_copy(base, cursor, dst->name, dst->name##_count * sizeof(type)); \
+        type *_mason_arr = (type *)(base + _mason_off);                                                         \
+        for (size_t i = 0; i < dst->name##_count; i++)                                                          \
+            type##_snapshot_place(&_mason_arr[i], base, cursor);                                                \
+        dst->name = (type *)_mason_off;                                                                         \
+    } else {                                                                                                    \
+        dst->name = NULL;                                                                                       \
+        dst->name##_count = 0;                                                                                  \
+    }
+
+/* Unions are placed first, while a string tag still points at the source */
+#define _MASON_SNAPSHOT_PLACE_UNION_CASE(value, type, member)                                              \
+    _MASON_UNION_CASE(value) {                                                                             \
+        uintptr_t _mason_off = _mason_snapshot_copy(base, cursor, *_mason_union_ptr, sizeof(struct type)); \
+        type##_snapshot_place((struct type *)(base + _mason_off), base, cursor);                           \
+        *_mason_union_ptr = (void *)_mason_off;                                                            \
+    }
+
+#define _MASON_SNAPSHOT_PLACE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                              \
+        _MASON_UNION_SWITCH(tag, name)                \
+        CASES(_MASON_SNAPSHOT_PLACE_UNION_CASE)       \
+        else {                                        \
+            *_mason_union_ptr = NULL;                 \
+        }                                             \
+    }
+
+/* Field Fixups */
+
+#define _MASON_SNAPSHOT_FIXUP_FIELD(type, name)                                    \
+    {                                                                              \
+        if (!_mason_snapshot_valid(&obj->name))                                    \
+            return false;                                                          \
+        _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))obj->name; \
+        if (!mason_snapshot_fixup(&_mason_value, base, len))                       \
+            return false;                                                          \
+        obj->name = (type)_mason_value;                                            \
+    }
+
+#define _MASON_SNAPSHOT_FIXUP_ARRAY_PRIM(type, name)                                               \
+    if (!_mason_snapshot_resolve((void **)&obj->name, base, len, obj->name##_count, sizeof(type))) \
+        return false;                                                                              \
+    if (!obj->name)                                                                                \
+        obj->name##_count = 0;                                                                     \
+    for (size_t i = 0; i < obj->name##_count; i++) {                                               \
+        if (!_mason_snapshot_valid(&obj->name[i]))                                                 \
+            return false;                                                                          \
+        _MASON_TYPE_ALIAS(type) _mason_value = (_MASON_TYPE_ALIAS(type))obj->name[i];              \
+        if (!mason_snapshot_fixup(&_mason_value, base, len))                                       \
+            return false;                                                                          \
+        obj->name[i] = (type)_mason_value;                                                         \
+    }
+
+#define _MASON_SNAPSHOT_FIXUP_ARRAY_MULTI(name)                                                              \
+    if (!_mason_snapshot_resolve((void **)&obj->name, base, len, obj->name##_count, sizeof(MASON_RawValue))) \
+        return false;                                                                                        \
+    if (!obj->name)                                                                                          \
+        obj->name##_count = 0;                                                                               \
+    for (size_t i = 0; i < obj->name##_count; i++)                                                           \
+        if (!_mason_snapshot_rawvalue_fixup(&obj->name[i], base, len, depth + 1))                            \
+            return false;
+
+#define _MASON_SNAPSHOT_FIXUP_OBJECT(type, name)                                            \
+    if (!_mason_snapshot_resolve((void **)&obj->name, base, len, 1, sizeof(struct type)) || \
+        (obj->name && !type##_snapshot_fixup(obj->name, base, len, depth + 1)))             \
+        return false;
+
+#define _MASON_SNAPSHOT_FIXUP_ARRAY_OBJECT(type, name)                                             \
+    if (!_mason_snapshot_resolve((void **)&obj->name, base, len, obj->name##_count, sizeof(type))) \
+        return false;                                                                              \
+    if (!obj->name)                                                                                \
+        obj->name##_count = 0;                                                                     \
+    for (size_t i = 0; i < obj->name##_count; i++)                                                 \
+        if (!type##_snapshot_fixup(&obj->name[i], base, len, depth + 1))                           \
+            return false;
+
+/* Unions are fixed up last, once a string tag points into the image again */
+#define _MASON_SNAPSHOT_FIXUP_UNION_CASE(value, type, member)                                               \
+    _MASON_UNION_CASE(value) {                                                                              \
+        if (!_mason_snapshot_resolve(_mason_union_ptr, base, len, 1, sizeof(struct type)) ||                \
+            (*_mason_union_ptr && !type##_snapshot_fixup((type *)*_mason_union_ptr, base, len, depth + 1))) \
+            return false;                                                                                   \
+    }
+
+#define _MASON_SNAPSHOT_FIXUP_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                              \
+        _MASON_UNION_SWITCH(tag, name)                \
+        CASES(_MASON_SNAPSHOT_FIXUP_UNION_CASE)       \
+        else {                                        \
+            *_mason_union_ptr = NULL;                 \
+        }                                             \
+    }
+
+/* Layout signature, one string literal per field */
+
+#define _MASON_SNAPSHOT_SIG_FIELD(type, name)        "F " #type " " #name ";"
+#define _MASON_SNAPSHOT_SIG_ARRAY(type, name)        "A " #type " " #name ";"
+#define _MASON_SNAPSHOT_SIG_ARRAY_MULTI(name)        "M " #name ";"
+#define _MASON_SNAPSHOT_SIG_OBJECT(type, name)       "O " #type " " #name ";"
+#define _MASON_SNAPSHOT_SIG_ARRAY_OBJECT(type, name) "L " #type " " #name ";"
+
+#define _MASON_SNAPSHOT_SIG_UNION(tag, name, CASES) "U " #tag " " #name " {" CASES(_MASON_SNAPSHOT_SIG_CASE) "};"
+#define _MASON_SNAPSHOT_SIG_CASE(value, type, member) #value " " #type " " #member ";"
+
+/* Nested layouts, folded into the parent's hash with their sizes */
+
+static inline uint64_t _mason_snapshot_mix(uint64_t h, uint64_t layout, size_t size) {
+    h ^= layout + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return (h ^ size) * 0x100000001b3ull;
+}
+
+#define _MASON_SNAPSHOT_LAYOUT_OBJECT(type, name) \
+    _mason_layout = _mason_snapshot_mix(_mason_layout, type##_snapshot_layout(depth + 1), sizeof(type));
+
+#define _MASON_SNAPSHOT_LAYOUT_UNION_CASE(value, type, member) _MASON_SNAPSHOT_LAYOUT_OBJECT(type, member)
+#define _MASON_SNAPSHOT_LAYOUT_UNION(tag, name, CASES)         CASES(_MASON_SNAPSHOT_LAYOUT_UNION_CASE)
+
+/* X-Macro Expansion Helpers for Snapshots */
+
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_FIELD(type, name)        _MASON_SNAPSHOT_EXTENT_FIELD(type, name)
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY(type, name)        _MASON_SNAPSHOT_EXTENT_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY_MULTI(name)        _MASON_SNAPSHOT_EXTENT_ARRAY_MULTI(name)
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_OBJECT(type, name)       _MASON_SNAPSHOT_EXTENT_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY_OBJECT(type, name) _MASON_SNAPSHOT_EXTENT_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_EXTENT_UNION(tag, name, CASES)  _MASON_SNAPSHOT_EXTENT_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_SNAPSHOT_PLACE_FIELD(type, name)        _MASON_SNAPSHOT_PLACE_FIELD(type, name)
+#define _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY(type, name)        _MASON_SNAPSHOT_PLACE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY_MULTI(name)        _MASON_SNAPSHOT_PLACE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_SNAPSHOT_PLACE_OBJECT(type, name)       _MASON_SNAPSHOT_PLACE_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY_OBJECT(type, name) _MASON_SNAPSHOT_PLACE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_PLACE_UNION(tag, name, CASES)  _MASON_SNAPSHOT_PLACE_UNION(tag, name, CASES)
+
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_FIELD(type, name)        _MASON_SNAPSHOT_FIXUP_FIELD(type, name)
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY(type, name)        _MASON_SNAPSHOT_FIXUP_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY_MULTI(name)        _MASON_SNAPSHOT_FIXUP_ARRAY_MULTI(name)
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_OBJECT(type, name)       _MASON_SNAPSHOT_FIXUP_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY_OBJECT(type, name) _MASON_SNAPSHOT_FIXUP_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_SNAPSHOT_FIXUP_UNION(tag, name, CASES)  _MASON_SNAPSHOT_FIXUP_UNION(tag, name, CASES)
+
+/* Partial snapshot impl */
+#define _MASON_IMPL_SNAPSHOT(struct_name, FIELDS)                                                                   \
+    size_t struct_name##_snapshot_extent(struct_name *obj) {                                                        \
+        size_t _mason_size = 0;                                                                                     \
+        FIELDS(_MASON_EXPAND_SNAPSHOT_EXTENT_FIELD, _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY,                            \
+               _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY_MULTI, _MASON_EXPAND_SNAPSHOT_EXTENT_OBJECT,                     \
+               _MASON_EXPAND_SNAPSHOT_EXTENT_ARRAY_OBJECT,                                                          \
+               _MASON_EXPAND_SNAPSHOT_EXTENT_UNION)                                                                 \
+        return _mason_size;                                                                                         \
+    }                                                                                                               \
+                                                                                                                    \
+    void struct_name##_snapshot_place(struct_name *dst, char *base, size_t *cursor) {                               \
+        struct_name *obj = dst;                                                                                     \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,                \
+               _MASON_EXPAND_NONE, _MASON_EXPAND_SNAPSHOT_PLACE_UNION)                                              \
+        FIELDS(_MASON_EXPAND_SNAPSHOT_PLACE_FIELD, _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY,                              \
+               _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY_MULTI, _MASON_EXPAND_SNAPSHOT_PLACE_OBJECT,                       \
+               _MASON_EXPAND_SNAPSHOT_PLACE_ARRAY_OBJECT,                                                           \
+               _MASON_EXPAND_NONE_UNION)                                                                            \
+        (void)obj;                                                                                                  \
+    }                                                                                                               \
+                                                                                                                    \
+    bool struct_name##_snapshot_fixup(struct_name *obj, char *base, size_t len, size_t depth) {                     \
+        if (depth >= MASON_READER_NESTING_LIMIT)                                                                    \
+            return false;                                                                                           \
+        FIELDS(_MASON_EXPAND_SNAPSHOT_FIXUP_FIELD, _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY,                              \
+               _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY_MULTI, _MASON_EXPAND_SNAPSHOT_FIXUP_OBJECT,                       \
+               _MASON_EXPAND_SNAPSHOT_FIXUP_ARRAY_OBJECT,                                                           \
+               _MASON_EXPAND_NONE_UNION)                                                                            \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,                \
+               _MASON_EXPAND_NONE, _MASON_EXPAND_SNAPSHOT_FIXUP_UNION)                                              \
+        return true;                                                                                                \
+    }                                                                                                               \
+                                                                                                                    \
+    uint64_t struct_name##_snapshot_layout(size_t depth) {                                                          \
+        static _Atomic uint64_t _mason_root_layout;                                                                 \
+        static const char _mason_sig[] = #struct_name ":" FIELDS(                                                   \
+            _MASON_SNAPSHOT_SIG_FIELD, _MASON_SNAPSHOT_SIG_ARRAY, _MASON_SNAPSHOT_SIG_ARRAY_MULTI,                  \
+            _MASON_SNAPSHOT_SIG_OBJECT, _MASON_SNAPSHOT_SIG_ARRAY_OBJECT,                                           \
+            _MASON_SNAPSHOT_SIG_UNION);                                                                             \
+        uint64_t _mason_layout = depth ? 0 : atomic_load_explicit(&_mason_root_layout, memory_order_relaxed);       \
+        if (_mason_layout)                                                                                          \
+            return _mason_layout;                                                                                   \
+        _mason_layout = (uint64_t)_mason_intern_hash(_mason_sig, sizeof(_mason_sig) - 1);                           \
+        if (depth < MASON_SNAPSHOT_LAYOUT_DEPTH) {                                                                  \
+            FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_SNAPSHOT_LAYOUT_OBJECT, \
+                   _MASON_SNAPSHOT_LAYOUT_OBJECT, _MASON_SNAPSHOT_LAYOUT_UNION)                                     \
+        }                                                                                                           \
+        /* Deterministic, so racing first calls store the same value */                                             \
+        if (!depth)                                                                                                 \
+            atomic_store_explicit(&_mason_root_layout, _mason_layout, memory_order_relaxed);                        \
+        return _mason_layout;                                                                                       \
+    }                                                                                                               \
+                                                                                                                    \
+    size_t struct_name##_snapshot_size(struct_name *obj) {                                                          \
+        if (!obj)                                                                                                   \
+            return 0;                                                                                               \
+        return sizeof(mason_snapshot_header) + _mason_snapshot_align(sizeof(struct_name)) +                         \
+               struct_name##_snapshot_extent(obj);                                                                  \
+    }                                                                                                               \
+                                                                                                                    \
+    size_t struct_name##_snapshot_write(struct_name *obj, void *buf, size_t cap) {                                  \
+        size_t size = struct_name##_snapshot_size(obj);                                                             \
+        if (!size || !buf || size > cap || (uintptr_t)buf % MASON_SNAPSHOT_ALIGN)                                   \
+            return 0;                                                                                               \
+        char *base = (char *)buf;                                                                                   \
+        memset(base, 0, size);                                                                                      \
+        mason_snapshot_header *h = (mason_snapshot_header *)base;                                                   \
+        memcpy(h->magic, MASON_SNAPSHOT_MAGIC, sizeof(h->magic));                                                   \
+        h->version = MASON_SNAPSHOT_VERSION;                                                                        \
+        h->root_size = (uint32_t)sizeof(struct_name);                                                               \
+        h->size = size;                                                                                             \
+        h->layout = struct_name##_snapshot_layout(0);                                                               \
+        size_t cursor = sizeof(mason_snapshot_header);                                                              \
+        uintptr_t root = _mason_snapshot_copy(base, &cursor, obj, sizeof(struct_name));                             \
+        struct_name##_snapshot_place((struct_name *)(base + root), base, &cursor);                                  \
+        return cursor;                                                                                              \
+    }                                                                                                               \
+                                                                                                                    \
+    struct_name *struct_name##_snapshot_load(void *image, size_t len) {                                             \
+        char *base = (char *)image;                                                                                 \
+        if (!_mason_snapshot_check(base, len, sizeof(struct_name), struct_name##_snapshot_layout(0)))               \
+            return NULL;                                                                                            \
+        struct_name *obj = (struct_name *)(base + sizeof(mason_snapshot_header));                                   \
+        size_t size = (size_t)((mason_snapshot_header *)base)->size;                                                \
+        return struct_name##_snapshot_fixup(obj, base, size, 0) ? obj : NULL;                                       \
+    }                                                                                                               \
+                                                                                                                    \
+    struct_name *struct_name##_snapshot_from_file(const char *path, mason_file *file) {                             \
+        if (!mason_map_file_writable(path, file))                                                                   \
+            return NULL;                                                                                            \
+        struct_name *obj = struct_name##_snapshot_load((void *)file->data, file->len);                              \
+        if (!obj)                                                                                                   \
+            mason_unmap_file(file);                                                                                 \
+        return obj;                                                                                                 \
+    }
+
+#endif // MASON_SNAPSHOT_H
@@ -0,0 +1,267 @@
+#ifndef MASON_VIEW_H
+#define MASON_VIEW_H
+
+#include <stddef.h>
+
+/* Lazy Views
+ *
+ * Foo_view_from_string_sized scans a document once, validating it and
+ * recording where each known field's value starts and ends, but decodes
+ * nothing. A field is decoded (with the single-pass decoders) the first time it
+ * is read and then cached in the view's embedded Foo. OBJECT fields can also be
+ * opened as nested views so only the parts of a sub-object that are read get
+ * decoded. The input is borrowed and must outlive the view.
+ *
+ * Fields are addressed by their index in Foo_FieldIndex, which the accessor
+ * macros compute from the field name:
+ *
+ *   GatewayEventPayload_view *v = GatewayEventPayload_view_from_string_sized(json, len);
+ *   int32_t op = MASON_VIEW_GET(GatewayEventPayload, v, op);
+ *   IdentifyEventData_view *d = MASON_VIEW_OPEN(GatewayEventPayload, v, d, IdentifyEventData);
+ *   string token = d ? MASON_VIEW_GET(IdentifyEventData, d, token) : NULL;
+ *   GatewayEventPayload_view_free(v); // frees nested views too
+ *
+ * A UNION field loads its tag first, and opens as a view of the struct the tag
+ * selects (MASON_VIEW_OPEN(GatewayEventPayload, v, d, HelloEventData)); check
+ * the tag before picking the view type.
+ *
+ * NOTE: views are not thread-safe, reading a field mutates the cache
+ */
+
+typedef struct {
+    const char *start; // raw value span in the borrowed input
+    size_t len;
+    bool present;
+    bool loaded;
+    bool set; // a FIELD whose value decoded, so a UNION can use it as its tag
+    void *child; // nested view of an OBJECT field, opened on demand
+} mason_view_slot;
+
+#define MASON_VIEW_FIELD(struct_name, field) offsetof(struct_name##_FieldIndex, field)
+
+/* Decodes the field on first use and yields its value */
+#define MASON_VIEW_GET(struct_name, view, field) \
+    (struct_name##_view_load((view), MASON_VIEW_FIELD(struct_name, field))->field)
+
+/* Whether the field's key appeared in the document */
+#define MASON_VIEW_HAS(struct_name, view, field) struct_name##_view_has((view), MASON_VIEW_FIELD(struct_name, field))
+
+/* Nested view of an OBJECT or UNION field, NULL if it is missing or not an object */
+#define MASON_VIEW_OPEN(struct_name, view, field, field_type) \
+    ((field_type##_view *)struct_name##_view_open((view), MASON_VIEW_FIELD(struct_name, field)))
+
+/* Field index layout: one char per field, so offsetof gives the index */
+#define _MASON_INDEX_FIELD(type, name)       char name;
+#define _MASON_INDEX_MULTI(name)             char name;
+#define _MASON_INDEX_UNION(tag, name, CASES) char name;
+
+static inline void _mason_view_record(mason_reader *r, mason_view_slot *slot) {
+    if (!slot) {
+        mason_reader_skip(r);
+        return;
+    }
+    mason_reader_peek(r);
+    slot->start = r->cur;
+    mason_reader_skip(r);
+    slot->len = (size_t)(r->cur - slot->start);
+    slot->present = true;
+}
+
+#define _MASON_VIEW_INDEX(name)                                 \
+    _MASON_KEY_CASE(name) {                                     \
+        _mason_slot = &v->slots[offsetof(_mason_fields, name)]; \
+    }
+
+#define _MASON_VIEW_NAME(name) #name,
+
+#define _MASON_VIEW_OPEN_OBJECT(type, name)                                      \
+    if (field == offsetof(_mason_fields, name)) {                                \
+        if (!slot->child && slot->present && slot->len && slot->start[0] == '{') \
+            slot->child = type##_view_from_string_sized(slot->start, slot->len); \
+        return slot->child;                                                      \
+    }
+
+#define _MASON_VIEW_FREE_OBJECT(type, name) \
+    type##_view_free((type##_view *)v->slots[offsetof(_mason_fields, name)].child);
+
+#define _MASON_VIEW_TAG_FIELD(tag, name, CASES) \
+    if (field == offsetof(_mason_fields, name)) \
+        return offsetof(_mason_fields, tag);
+
+/* A union decoded on its own sees its tag only if the document's tag decoded */
+#define _MASON_VIEW_TAGGED(tag, name, CASES) _mason_set_##tag = _mason_tagged;
+
+#define _MASON_VIEW_FIELD_SET(type, name) _mason_set_##name ||
+
+#define _MASON_VIEW_OPEN_UNION_CASE(value, type, member)                     \
+    _MASON_UNION_CASE(value) {                                               \
+        slot->child = type##_view_from_string_sized(slot->start, slot->len); \
+    }
+
+#define _MASON_VIEW_OPEN_UNION(tag, name, CASES)                                   \
+    if (field == offsetof(_mason_fields, name)) {                                  \
+        if (!slot->child && slot->present && slot->len && slot->start[0] == '{' && \
+            v->slots[offsetof(_mason_fields, tag)].set) {                          \
+            _MASON_UNION_SWITCH(tag, name)                                         \
+            CASES(_MASON_VIEW_OPEN_UNION_CASE)                                     \
+        }                                                                          \
+        return slot->child;                                                        \
+    }
+
+#define _MASON_VIEW_FREE_UNION_CASE(value, type, member) \
+    _MASON_UNION_CASE(value) {                           \
+        type##_view_free((type##_view *)_mason_child);   \
+    }
+
+#define _MASON_VIEW_FREE_UNION(tag, name, CASES)                            \
+    if (v->slots[offsetof(_mason_fields, name)].child) {                    \
+        void *_mason_child = v->slots[offsetof(_mason_fields, name)].child; \
+        _MASON_UNION_SWITCH(tag, name)                                      \
+        CASES(_MASON_VIEW_FREE_UNION_CASE)                                  \
+    }
+
+/* X-Macro Expansion Helpers for Views */
+
+#define _MASON_EXPAND_VIEW_INDEX(type, name)             _MASON_VIEW_INDEX(name)
+#define _MASON_EXPAND_VIEW_INDEX_MULTI(name)             _MASON_VIEW_INDEX(name)
+#define _MASON_EXPAND_VIEW_NAME(type, name)              _MASON_VIEW_NAME(name)
+#define _MASON_EXPAND_VIEW_NAME_MULTI(name)              _MASON_VIEW_NAME(name)
+#define _MASON_EXPAND_VIEW_OPEN_OBJECT(type, name)       _MASON_VIEW_OPEN_OBJECT(type, name)
+#define _MASON_EXPAND_VIEW_FREE_OBJECT(type, name)       _MASON_VIEW_FREE_OBJECT(type, name)
+#define _MASON_EXPAND_VIEW_FIELD_SET(type, name)         _MASON_VIEW_FIELD_SET(type, name)
+#define _MASON_EXPAND_VIEW_NONE(type, name)
+#define _MASON_EXPAND_VIEW_NONE_MULTI(name)
+#define _MASON_EXPAND_VIEW_INDEX_UNION(tag, name, CASES) _MASON_VIEW_INDEX(name)
+#define _MASON_EXPAND_VIEW_NAME_UNION(tag, name, CASES)  _MASON_VIEW_NAME(name)
+#define _MASON_EXPAND_VIEW_TAG_FIELD(tag, name, CASES)   _MASON_VIEW_TAG_FIELD(tag, name, CASES)
+#define _MASON_EXPAND_VIEW_TAGGED(tag, name, CASES)      _MASON_VIEW_TAGGED(tag, name, CASES)
+#define _MASON_EXPAND_VIEW_OPEN_UNION(tag, name, CASES)  _MASON_VIEW_OPEN_UNION(tag, name, CASES)
+#define _MASON_EXPAND_VIEW_FREE_UNION(tag, name, CASES)  _MASON_VIEW_FREE_UNION(tag, name, CASES)
+
+/* Partial view impl */
+#define _MASON_IMPL_VIEW(struct_name, FIELDS)                                                                \
+    struct_name##_view *struct_name##_view_from_string_sized(const char *json_str, size_t len) {             \
+        typedef struct_name##_FieldIndex _mason_fields;                                                      \
+        if (!json_str)                                                                                       \
+            return NULL;                                                                                     \
+        struct_name##_view *v = (struct_name##_view *)MASON_CALLOC(1, sizeof(struct_name##_view));           \
+        if (!v)                                                                                              \
+            return NULL;                                                                                     \
+        v->src = json_str;                                                                                   \
+        v->len = len;                                                                                        \
+        mason_reader _mason_r, *r = &_mason_r;                                                               \
+        mason_reader_init(r, json_str, len);                                                                 \
+        const char *_mason_key;                                                                              \
+        size_t _mason_key_len;                                                                               \
+        bool _mason_first = true;                                                                            \
+        FIELDS(_MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_MULTI,                 \
+               _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_UNION)                 \
+        if (mason_reader_object_begin(r)) {                                                                  \
+            while (mason_reader_next_key(r, &_mason_first, &_mason_key, &_mason_key_len)) {                  \
+                size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                              \
+                mason_view_slot *_mason_slot = NULL;                                                         \
+                if (0) {                                                                                     \
+                }                                                                                            \
+                FIELDS(_MASON_EXPAND_VIEW_INDEX, _MASON_EXPAND_VIEW_INDEX, _MASON_EXPAND_VIEW_INDEX_MULTI,   \
+                       _MASON_EXPAND_VIEW_INDEX, _MASON_EXPAND_VIEW_INDEX, _MASON_EXPAND_VIEW_INDEX_UNION)   \
+                _mason_view_record(r, _mason_slot);                                                          \
+            }                                                                                                \
+        } else {                                                                                             \
+            mason_reader_skip(r);                                                                            \
+        }                                                                                                    \
+        if (r->failed) {                                                                                     \
+            MASON_FREE(v);                                                                                   \
+            return NULL;                                                                                     \
+        }                                                                                                    \
+        return v;                                                                                            \
+    }                                                                                                        \
+                                                                                                             \
+    struct_name##_view *struct_name##_view_from_string(const char *json_str) {                               \
+        if (!json_str)                                                                                       \
+            return NULL;                                                                                     \
+        return struct_name##_view_from_string_sized(json_str, strlen(json_str));                             \
+    }                                                                                                        \
+                                                                                                             \
+    static size_t struct_name##_view_tag_field(size_t field) {                                               \
+        typedef struct_name##_FieldIndex _mason_fields;                                                      \
+        FIELDS(_MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE_MULTI,              \
+               _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_TAG_FIELD)               \
+        (void)field;                                                                                         \
+        (void)sizeof(_mason_fields);                                                                         \
+        return SIZE_MAX;                                                                                     \
+    }                                                                                                        \
+                                                                                                             \
+    static bool struct_name##_view_decode_field(struct_name *obj, mason_reader *r, const char *_mason_key,   \
+                                                bool _mason_tagged) {                                        \
+        size_t _mason_key_len = strlen(_mason_key);                                                          \
+        size_t _mason_tag = _mason_key_tag(_mason_key, _mason_key_len);                                      \
+        FIELDS(_MASON_EXPAND_KEY_SEEN_FIELD, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_MULTI,           \
+               _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN, _MASON_EXPAND_KEY_SEEN_UNION)                 \
+        FIELDS(_MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE_MULTI,              \
+               _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_TAGGED)                  \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,         \
+               _MASON_EXPAND_NONE, _MASON_DECODE_UNION_AT)                                                   \
+        (void)_mason_tagged;                                                                                 \
+        if (0) {                                                                                             \
+        }                                                                                                    \
+        FIELDS(_MASON_EXPAND_DECODE_FIELD, _MASON_EXPAND_DECODE_ARRAY, _MASON_EXPAND_DECODE_ARRAY_MULTI,     \
+               _MASON_EXPAND_DECODE_OBJECT, _MASON_EXPAND_DECODE_ARRAY_OBJECT, _MASON_EXPAND_DECODE_UNION)   \
+        FIELDS(_MASON_EXPAND_NONE, _MASON_EXPAND_NONE, _MASON_EXPAND_NONE_MULTI, _MASON_EXPAND_NONE,         \
+               _MASON_EXPAND_NONE, _MASON_DECODE_UNION_DEFERRED)                                             \
+        return !r->failed && (FIELDS(_MASON_EXPAND_VIEW_FIELD_SET, _MASON_EXPAND_VIEW_NONE,                  \
+                                     _MASON_EXPAND_VIEW_NONE_MULTI, _MASON_EXPAND_VIEW_NONE,                 \
+                                     _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_NONE_UNION) false);              \
+    }                                                                                                        \
+                                                                                                             \
+    struct_name *struct_name##_view_load(struct_name##_view *v, size_t field) {                              \
+        static const char *const _mason_names[] = {                                                          \
+            FIELDS(_MASON_EXPAND_VIEW_NAME, _MASON_EXPAND_VIEW_NAME, _MASON_EXPAND_VIEW_NAME_MULTI,          \
+                   _MASON_EXPAND_VIEW_NAME, _MASON_EXPAND_VIEW_NAME, _MASON_EXPAND_VIEW_NAME_UNION)};        \
+        if (field < sizeof(struct_name##_FieldIndex) && !v->slots[field].loaded) {                           \
+            size_t tag = struct_name##_view_tag_field(field);                                                \
+            bool tagged = tag != SIZE_MAX && struct_name##_view_load(v, tag) && v->slots[tag].set;           \
+            mason_view_slot *slot = &v->slots[field];                                                        \
+            slot->loaded = true;                                                                             \
+            if (slot->present) {                                                                             \
+                mason_reader r;                                                                              \
+                mason_reader_init(&r, slot->start, slot->len);                                               \
+                slot->set = struct_name##_view_decode_field(&v->obj, &r, _mason_names[field], tagged);       \
+            }                                                                                                \
+        }                                                                                                    \
+        return &v->obj;                                                                                      \
+    }                                                                                                        \
+                                                                                                             \
+    bool struct_name##_view_has(struct_name##_view *v, size_t field) {                                       \
+        return v && field < sizeof(struct_name##_FieldIndex) && v->slots[field].present;                     \
+    }                                                                                                        \
+                                                                                                             \
+    void *struct_name##_view_open(struct_name##_view *v, size_t field) {                                     \
+        typedef struct_name##_FieldIndex _mason_fields;                                                      \
+        if (!v || field >= sizeof(struct_name##_FieldIndex))                                                 \
+            return NULL;                                                                                     \
+        mason_view_slot *slot = &v->slots[field];                                                            \
+        struct_name *obj = &v->obj;                                                                          \
+        if (struct_name##_view_tag_field(field) != SIZE_MAX)                                                 \
+            struct_name##_view_load(v, struct_name##_view_tag_field(field));                                 \
+        FIELDS(_MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE_MULTI,              \
+               _MASON_EXPAND_VIEW_OPEN_OBJECT, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_OPEN_UNION)       \
+        (void)slot;                                                                                          \
+        (void)obj;                                                                                           \
+        (void)sizeof(_mason_fields);                                                                         \
+        return NULL;                                                                                         \
+    }                                                                                                        \
+                                                                                                             \
+    void struct_name##_view_free(struct_name##_view *v) {                                                    \
+        typedef struct_name##_FieldIndex _mason_fields;                                                      \
+        if (!v)                                                                                              \
+            return;                                                                                          \
+        struct_name *obj = &v->obj;                                                                          \
+        FIELDS(_MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_NONE_MULTI,              \
+               _MASON_EXPAND_VIEW_FREE_OBJECT, _MASON_EXPAND_VIEW_NONE, _MASON_EXPAND_VIEW_FREE_UNION)       \
+        (void)sizeof(_mason_fields);                                                                         \
+        (void)obj;                                                                                           \
+        struct_name##_free_members(&v->obj);                                                                 \
+        MASON_FREE(v);                                                                                       \
+    }
+
+#endif // MASON_VIEW_H
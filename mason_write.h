@@ -0,0 +1,503 @@
+#ifndef MASON_WRITE_H
+#define MASON_WRITE_H
+
+#include <math.h>
+#include <stdio.h>
+
+/* Growable Output Buffer */
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool failed;
+    bool fixed; // caller-owned storage that never grows
+} mason_buf;
+
+#define MASON_BUF_INITIAL_CAPACITY 256
+
+static inline void mason_buf_init(mason_buf *buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+    buf->failed = false;
+    buf->fixed = false;
+}
+
+/* Writes into `storage` without allocating; output that does not fit (including
+ * the NUL terminator) marks the buffer failed instead of growing it.
+ */
+static inline void mason_buf_init_fixed(mason_buf *buf, char *storage, size_t cap) {
+    buf->data = storage;
+    buf->len = 0;
+    buf->cap = cap;
+    buf->failed = !storage || cap == 0;
+    buf->fixed = true;
+    if (!buf->failed)
+        storage[0] = '\0';
+}
+
+static inline void mason_buf_free(mason_buf *buf) {
+    if (!buf->fixed)
+        MASON_FREE(buf->data);
+    mason_buf_init(buf);
+}
+
+/* Keeps the allocation for reuse */
+static inline void mason_buf_reset(mason_buf *buf) {
+    buf->len = 0;
+    buf->failed = false;
+    if (buf->data)
+        buf->data[0] = '\0';
+}
+
+/* Ensures room for `extra` more bytes plus a NUL terminator */
+static inline bool mason_buf_reserve(mason_buf *buf, size_t extra) {
+    if (buf->failed)
+        return false;
+    size_t need = buf->len + extra + 1;
+    if (need <= buf->cap)
+        return true;
+    if (buf->fixed) {
+        buf->failed = true;
+        return false;
+    }
+    size_t cap = buf->cap ? buf->cap : MASON_BUF_INITIAL_CAPACITY;
+    while (cap < need)
+        cap *= 2;
+    char *data = (char *)MASON_REALLOC(buf->data, cap);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+static inline void mason_buf_append(mason_buf *buf, const char *s, size_t n) {
+    if (!mason_buf_reserve(buf, n))
+        return;
+    memcpy(buf->data + buf->len, s, n);
+    buf->len += n;
+    buf->data[buf->len] = '\0';
+}
+
+static inline void mason_buf_putc(mason_buf *buf, char c) {
+    if (!mason_buf_reserve(buf, 1))
+        return;
+    buf->data[buf->len++] = c;
+    buf->data[buf->len] = '\0';
+}
+
+/* Hands the NUL-terminated contents to the caller and resets the buffer
+ * NOTE: for a fixed buffer this is the caller's storage, or NULL on overflow
+ */
+static inline char *mason_buf_detach(mason_buf *buf) {
+    if (!buf->failed && !buf->data)
+        mason_buf_reserve(buf, 0);
+    if (buf->failed) {
+        mason_buf_free(buf);
+        return NULL;
+    }
+    char *data = buf->data;
+    data[buf->len] = '\0';
+    mason_buf_init(buf);
+    return data;
+}
+
+/* Value Writers
+ * NOTE: output matches cJSON_PrintUnformatted for the same values
+ */
+
+#define _MASON_WRITE_LITERAL(out, lit) mason_buf_append(out, lit, sizeof(lit) - 1)
+
+static inline void _mason_write_uint64(mason_buf *out, uint64_t v, bool negative) {
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (negative)
+        *--p = '-';
+    mason_buf_append(out, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+static inline void mason_write_int32(mason_buf *out, int32_t v) {
+    _mason_write_uint64(out, v < 0 ? (uint64_t)0 - (uint64_t)(int64_t)v : (uint64_t)v, v < 0);
+}
+
+static inline void mason_write_int64(mason_buf *out, int64_t v) {
+    _mason_write_uint64(out, v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v, v < 0);
+}
+
+static inline void mason_write_double(mason_buf *out, double v) {
+    if (isnan(v) || isinf(v)) {
+        _MASON_WRITE_LITERAL(out, "null");
+        return;
+    }
+    /* Same integer shortcut as cJSON's print_number */
+    int as_int = v >= INT32_MAX ? INT32_MAX : v <= INT32_MIN ? INT32_MIN : (int)v;
+    if (v == (double)as_int) {
+        mason_write_int32(out, as_int);
+        return;
+    }
+    char tmp[32];
+    double check = 0;
+    int n = snprintf(tmp, sizeof(tmp), "%1.15g", v);
+    if (sscanf(tmp, "%lg", &check) != 1 || check != v)
+        n = snprintf(tmp, sizeof(tmp), "%1.17g", v);
+    if (n > 0)
+        mason_buf_append(out, tmp, (size_t)n);
+}
+
+static inline void mason_write_string(mason_buf *out, const char *v) {
+    if (!v) {
+        _MASON_WRITE_LITERAL(out, "null");
+        return;
+    }
+    mason_buf_putc(out, '"');
+    // Clean runs between escapes are found a vector at a time and copied whole
+    const char *end = v + strlen(v);
+    for (const char *p = v;;) {
+        const char *run = p;
+        p = mason_scan_escape(p, end);
+        mason_buf_append(out, run, (size_t)(p - run));
+        if (p == end)
+            break;
+        unsigned char c = (unsigned char)*p++;
+        switch (c) {
+        case '"':
+            _MASON_WRITE_LITERAL(out, "\\\"");
+            break;
+        case '\\':
+            _MASON_WRITE_LITERAL(out, "\\\\");
+            break;
+        case '\b':
+            _MASON_WRITE_LITERAL(out, "\\b");
+            break;
+        case '\f':
+            _MASON_WRITE_LITERAL(out, "\\f");
+            break;
+        case '\n':
+            _MASON_WRITE_LITERAL(out, "\\n");
+            break;
+        case '\r':
+            _MASON_WRITE_LITERAL(out, "\\r");
+            break;
+        case '\t':
+            _MASON_WRITE_LITERAL(out, "\\t");
+            break;
+        default: {
+            char esc[7];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            mason_buf_append(out, esc, 6);
+            break;
+        }
+        }
+    }
+    mason_buf_putc(out, '"');
+}
+
+static inline void mason_write_interned(mason_buf *out, mason_interned_t v) {
+    mason_write_string(out, (const char *)v);
+}
+
+static inline void mason_write_bool(mason_buf *out, bool v) {
+    if (v)
+        _MASON_WRITE_LITERAL(out, "true");
+    else
+        _MASON_WRITE_LITERAL(out, "false");
+}
+
+/* Writes an arbitrary JSON handle, used for ARRAY_MULTI AST values */
+static inline void mason_write_ast(mason_buf *out, MASON_Parsed item) {
+    if (!item) {
+        _MASON_WRITE_LITERAL(out, "null");
+        return;
+    }
+    switch (item->type & 0xFF) {
+    case cJSON_False:
+        _MASON_WRITE_LITERAL(out, "false");
+        break;
+    case cJSON_True:
+        _MASON_WRITE_LITERAL(out, "true");
+        break;
+    case cJSON_Number:
+        mason_write_double(out, item->valuedouble);
+        break;
+    case cJSON_String:
+        mason_write_string(out, item->valuestring ? item->valuestring : "");
+        break;
+    case cJSON_Raw:
+        if (item->valuestring)
+            mason_buf_append(out, item->valuestring, strlen(item->valuestring));
+        break;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool is_object = (item->type & 0xFF) == cJSON_Object;
+        mason_buf_putc(out, is_object ? '{' : '[');
+        for (MASON_Parsed child = item->child; child; child = child->next) {
+            if (child != item->child)
+                mason_buf_putc(out, ',');
+            if (is_object) {
+                mason_write_string(out, child->string ? child->string : "");
+                mason_buf_putc(out, ':');
+            }
+            mason_write_ast(out, child);
+        }
+        mason_buf_putc(out, is_object ? '}' : ']');
+        break;
+    }
+    default:
+        _MASON_WRITE_LITERAL(out, "null");
+        break;
+    }
+}
+
+/* Size Hints
+ * NOTE: upper bounds on the text produced by the writers above and by
+ * cJSON_PrintUnformatted
+ */
+
+#define MASON_NUMBER_MAX_CHARS 25 // -2.2250738585072014e-308
+
+static inline size_t mason_size_hint_int32(int32_t v) {
+    (void)v;
+    return 11;
+}
+
+static inline size_t mason_size_hint_int64(int64_t v) {
+    (void)v;
+    return 20; // -9223372036854775808
+}
+
+static inline size_t mason_size_hint_double(double v) {
+    (void)v;
+    return MASON_NUMBER_MAX_CHARS;
+}
+
+/* Every byte may need a \u00XX escape */
+static inline size_t mason_size_hint_string(const char *v) { return v ? 2 + 6 * strlen(v) : 4; }
+static inline size_t mason_size_hint_interned(mason_interned_t v) { return mason_size_hint_string((const char *)v); }
+
+static inline size_t mason_size_hint_bool(bool v) { return v ? 4 : 5; }
+
+static inline size_t mason_size_hint_ast(MASON_Parsed item) {
+    if (!item)
+        return 4;
+    switch (item->type & 0xFF) {
+    case cJSON_False:
+        return 5;
+    case cJSON_Number:
+        return MASON_NUMBER_MAX_CHARS;
+    case cJSON_String:
+        return mason_size_hint_string(item->valuestring ? item->valuestring : "");
+    case cJSON_Raw:
+        return item->valuestring ? strlen(item->valuestring) : 0;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool is_object = (item->type & 0xFF) == cJSON_Object;
+        size_t size = 2;
+        for (MASON_Parsed child = item->child; child; child = child->next) {
+            size += 1 + mason_size_hint_ast(child);
+            if (is_object)
+                size += 1 + mason_size_hint_string(child->string ? child->string : "");
+        }
+        return size;
+    }
+    default:
+        return 4;
+    }
+}
+
+#define mason_size_hint(value) _Generic((value), \
+    int32_t: mason_size_hint_int32,              \
+    int64_t: mason_size_hint_int64,              \
+    double: mason_size_hint_double,              \
+    char *: mason_size_hint_string,              \
+    const char *: mason_size_hint_string,        \
+    mason_interned_t: mason_size_hint_interned,  \
+    _Bool: mason_size_hint_bool)(value)
+
+#define mason_write(out, value) _Generic((value), \
+    int32_t: mason_write_int32,                   \
+    int64_t: mason_write_int64,                   \
+    double: mason_write_double,                   \
+    char *: mason_write_string,                   \
+    const char *: mason_write_string,             \
+    mason_interned_t: mason_write_interned,       \
+    _Bool: mason_write_bool)(out, value)
+
+/* Containers
+ *
+ * Every member/element is written with a leading ',' and the first one is
+ * patched into the opening bracket afterwards, so no per-field "first" state
+ * has to be threaded through the X-macro expansion.
+ */
+
+static inline void mason_write_close(mason_buf *out, size_t start, char open, char close) {
+    if (out->failed)
+        return;
+    if (out->len == start)
+        mason_buf_putc(out, open);
+    else
+        out->data[start] = open;
+    mason_buf_putc(out, close);
+}
+
+/* Key literal is concatenated at compile time: ,"name": */
+#define _MASON_WRITE_KEY(name) _MASON_WRITE_LITERAL(out, ",\"" #name "\":");
+
+/* Field Writers */
+
+#define _MASON_WRITE_FIELD(type, name) \
+    _MASON_WRITE_KEY(name)             \
+    mason_write(out, (_MASON_TYPE_ALIAS(type))obj->name);
+
+#define _MASON_WRITE_ARRAY_PRIM(type, name)                          \
+    _MASON_WRITE_KEY(name) {                                         \
+        size_t _mason_arr = out->len;                                \
+        for (size_t i = 0; i < obj->name##_count; i++) {             \
+            mason_buf_putc(out, ',');                                \
+            mason_write(out, (_MASON_TYPE_ALIAS(type))obj->name[i]); \
+        }                                                            \
+        mason_write_close(out, _mason_arr, '[', ']');                \
+    }
+
+#define _MASON_WRITE_OBJECT(type, name) \
+    if (obj->name) {                    \
+        _MASON_WRITE_KEY(name)          \
+        type##_write(obj->name, out);   \
+    }
+
+#define _MASON_WRITE_ARRAY_OBJECT(type, name)            \
+    _MASON_WRITE_KEY(name) {                             \
+        size_t _mason_arr = out->len;                    \
+        for (size_t i = 0; i < obj->name##_count; i++) { \
+            mason_buf_putc(out, ',');                    \
+            type##_write(&obj->name[i], out);            \
+        }                                                \
+        mason_write_close(out, _mason_arr, '[', ']');    \
+    }
+
+/* The key is taken back when the tag matches no case */
+#define _MASON_WRITE_UNION_CASE(value, type, member)  \
+    _MASON_UNION_CASE(value) {                        \
+        type##_write((type *)*_mason_union_ptr, out); \
+    }
+
+#define _MASON_WRITE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                     \
+        size_t _mason_key_mark = out->len;   \
+        _MASON_WRITE_KEY(name)               \
+        _MASON_UNION_SWITCH(tag, name)       \
+        CASES(_MASON_WRITE_UNION_CASE)       \
+        else                                 \
+            out->len = _mason_key_mark;      \
+    }
+
+/* Size Hint Accumulators */
+
+#define _MASON_KEY_SIZE(name) (sizeof(",\"" #name "\":") - 1)
+
+#define _MASON_SIZE_FIELD(type, name) \
+    size += _MASON_KEY_SIZE(name) + mason_size_hint((_MASON_TYPE_ALIAS(type))obj->name);
+
+#define _MASON_SIZE_ARRAY_PRIM(type, name)         \
+    size += _MASON_KEY_SIZE(name) + 2;             \
+    for (size_t i = 0; i < obj->name##_count; i++) \
+        size += 1 + mason_size_hint((_MASON_TYPE_ALIAS(type))obj->name[i]);
+
+#define _MASON_SIZE_OBJECT(type, name) \
+    if (obj->name)                     \
+        size += _MASON_KEY_SIZE(name) + type##_serialized_size_hint(obj->name);
+
+#define _MASON_SIZE_ARRAY_OBJECT(type, name)       \
+    size += _MASON_KEY_SIZE(name) + 2;             \
+    for (size_t i = 0; i < obj->name##_count; i++) \
+        size += 1 + type##_serialized_size_hint(&obj->name[i]);
+
+#define _MASON_SIZE_UNION_CASE(value, type, member)                     \
+    _MASON_UNION_CASE(value) {                                          \
+        size += type##_serialized_size_hint((type *)*_mason_union_ptr); \
+    }
+
+#define _MASON_SIZE_UNION(tag, name, CASES) \
+    if (obj->name.ptr) {                    \
+        size += _MASON_KEY_SIZE(name);      \
+        _MASON_UNION_SWITCH(tag, name)      \
+        CASES(_MASON_SIZE_UNION_CASE)       \
+    }
+
+/* X-Macro Expansion Helpers for Write */
+
+#define _MASON_EXPAND_WRITE_FIELD(type, name)        _MASON_MASKED(name, _MASON_WRITE_FIELD(type, name))
+#define _MASON_EXPAND_WRITE_ARRAY(type, name)        _MASON_MASKED(name, _MASON_WRITE_ARRAY_PRIM(type, name))
+#define _MASON_EXPAND_WRITE_ARRAY_MULTI(name)        _MASON_MASKED(name, _MASON_WRITE_ARRAY_MULTI(name))
+#define _MASON_EXPAND_WRITE_OBJECT(type, name)       _MASON_MASKED(name, _MASON_WRITE_OBJECT(type, name))
+#define _MASON_EXPAND_WRITE_ARRAY_OBJECT(type, name) _MASON_MASKED(name, _MASON_WRITE_ARRAY_OBJECT(type, name))
+#define _MASON_EXPAND_WRITE_UNION(tag, name, CASES)  _MASON_MASKED(name, _MASON_WRITE_UNION(tag, name, CASES))
+
+#define _MASON_EXPAND_SIZE_FIELD(type, name)        _MASON_SIZE_FIELD(type, name)
+#define _MASON_EXPAND_SIZE_ARRAY(type, name)        _MASON_SIZE_ARRAY_PRIM(type, name)
+#define _MASON_EXPAND_SIZE_ARRAY_MULTI(name)        _MASON_SIZE_ARRAY_MULTI(name)
+#define _MASON_EXPAND_SIZE_OBJECT(type, name)       _MASON_SIZE_OBJECT(type, name)
+#define _MASON_EXPAND_SIZE_ARRAY_OBJECT(type, name) _MASON_SIZE_ARRAY_OBJECT(type, name)
+#define _MASON_EXPAND_SIZE_UNION(tag, name, CASES)  _MASON_SIZE_UNION(tag, name, CASES)
+
+/* Room cJSON_PrintPreallocated needs beyond the printed text */
+#define MASON_PREALLOCATED_SLACK 5
+
+/* Partial write impl
+ * Foo_write_masked writes only the top-level fields selected by the mask, e.g.
+ * the ones a presence update changed (see Field Masks in mason.h).
+ * Foo_write_to_buffer returns the length written, or 0 if the output did not
+ * fit. Foo_serialized_size_hint is enough for it and for Foo_to_buffer,
+ * including the NUL terminator.
+ */
+#define _MASON_IMPL_WRITE(struct_name, FIELDS)                                                        \
+    bool struct_name##_write_masked(struct_name *obj, mason_buf *out, mason_field_mask mask) {        \
+        typedef struct_name##_FieldIndex _mason_fields;                                               \
+        const mason_field_mask _mason_mask = mask;                                                    \
+        if (!obj || !out)                                                                             \
+            return false;                                                                             \
+        size_t _mason_start = out->len;                                                               \
+        FIELDS(_MASON_EXPAND_WRITE_FIELD, _MASON_EXPAND_WRITE_ARRAY, _MASON_EXPAND_WRITE_ARRAY_MULTI, \
+               _MASON_EXPAND_WRITE_OBJECT, _MASON_EXPAND_WRITE_ARRAY_OBJECT,                          \
+               _MASON_EXPAND_WRITE_UNION)                                                             \
+        mason_write_close(out, _mason_start, '{', '}');                                               \
+        return !out->failed;                                                                          \
+    }                                                                                                 \
+                                                                                                      \
+    bool struct_name##_write(struct_name *obj, mason_buf *out) {                                      \
+        return struct_name##_write_masked(obj, out, MASON_FIELDS_ALL);                                \
+    }                                                                                                 \
+                                                                                                      \
+    string struct_name##_to_string_direct(struct_name *obj) {                                         \
+        if (!obj)                                                                                     \
+            return NULL;                                                                              \
+        mason_buf out;                                                                                \
+        mason_buf_init(&out);                                                                         \
+        struct_name##_write(obj, &out);                                                               \
+        return mason_buf_detach(&out);                                                                \
+    }                                                                                                 \
+                                                                                                      \
+    size_t struct_name##_write_to_buffer(struct_name *obj, char *buf, size_t cap) {                   \
+        mason_buf out;                                                                                \
+        mason_buf_init_fixed(&out, buf, cap);                                                         \
+        return struct_name##_write(obj, &out) ? out.len : 0;                                          \
+    }                                                                                                 \
+                                                                                                      \
+    size_t struct_name##_serialized_size_hint(struct_name *obj) {                                     \
+        if (!obj)                                                                                     \
+            return 0;                                                                                 \
+        size_t size = 2 + 1 + MASON_PREALLOCATED_SLACK;                                               \
+        FIELDS(_MASON_EXPAND_SIZE_FIELD, _MASON_EXPAND_SIZE_ARRAY, _MASON_EXPAND_SIZE_ARRAY_MULTI,    \
+               _MASON_EXPAND_SIZE_OBJECT, _MASON_EXPAND_SIZE_ARRAY_OBJECT,                            \
+               _MASON_EXPAND_SIZE_UNION)                                                              \
+        return size;                                                                                  \
+    }
+
+#endif // MASON_WRITE_H
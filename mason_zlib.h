@@ -0,0 +1,181 @@
+#ifndef MASON_ZLIB_H
+#define MASON_ZLIB_H
+
+/* zlib-stream Transport Decompression
+ *
+ * With `compress=zlib-stream` the gateway sends one deflate stream for the
+ * whole connection; each message is flushed with Z_SYNC_FLUSH, so it ends in
+ * the bytes 00 00 FF FF, and may be split over several websocket frames.
+ * mason_inflate_feed inflates every frame as it arrives into one output buffer
+ * that is reused for every message, and reports a complete message once the
+ * flush suffix is seen. Foo_inflate then decodes straight from that buffer,
+ * with no intermediate copy or JSON tree:
+ *
+ *   mason_inflate_ctx *z = mason_inflate_create(); // one per connection
+ *   GatewayEventPayload *event;
+ *   if (GatewayEventPayload_inflate(z, frame, frame_len, &event) == MASON_INFLATE_MESSAGE && event) { ... }
+ *   mason_inflate_destroy(z);
+ *
+ * The message stays in mason_inflate_message() until the next frame is fed, so
+ * other decoders (e.g. Foo_from_etf with `encoding=etf`) can read it too.
+ * Decoding is in place: string_view fields point into the output buffer and are
+ * only valid until the next frame.
+ *
+ * Requires zlib: define MASON_ZLIB_IMPL before including mason.h and link -lz.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    MASON_INFLATE_PARTIAL, // frame consumed, message not complete yet
+    MASON_INFLATE_MESSAGE, // a complete message is available
+    MASON_INFLATE_ERROR    // corrupt stream or out of memory; reconnect and reset
+} mason_inflate_status;
+
+typedef struct mason_inflate_ctx mason_inflate_ctx;
+
+#ifdef MASON_ZLIB_IMPL
+
+#include <limits.h>
+#include <zlib.h>
+
+#define MASON_INFLATE_CHUNK 16384
+
+struct mason_inflate_ctx {
+    z_stream zs;
+    mason_buf out;   // inflated message, reused across messages
+    uint32_t tail;   // last four compressed bytes seen, to spot the flush suffix
+    bool complete;   // out holds a finished message that the next frame replaces
+    bool failed;
+};
+
+/* zlib allocates through the active Mason allocator */
+static inline voidpf _mason_zalloc(voidpf opaque, uInt items, uInt size) {
+    (void)opaque;
+    return MASON_CALLOC(items, size);
+}
+
+static inline void _mason_zfree(voidpf opaque, voidpf ptr) {
+    (void)opaque;
+    MASON_FREE(ptr);
+}
+
+static inline mason_inflate_ctx *mason_inflate_create(void) {
+    mason_inflate_ctx *ctx = (mason_inflate_ctx *)MASON_CALLOC(1, sizeof(mason_inflate_ctx));
+    if (!ctx)
+        return NULL;
+    ctx->zs.zalloc = _mason_zalloc;
+    ctx->zs.zfree = _mason_zfree;
+    if (inflateInit(&ctx->zs) != Z_OK) {
+        MASON_FREE(ctx);
+        return NULL;
+    }
+    mason_buf_init(&ctx->out);
+    return ctx;
+}
+
+/* Starts a new stream (after reconnecting), keeping the output buffer */
+static inline void mason_inflate_reset(mason_inflate_ctx *ctx) {
+    inflateReset(&ctx->zs);
+    mason_buf_reset(&ctx->out);
+    ctx->tail = 0;
+    ctx->complete = false;
+    ctx->failed = false;
+}
+
+static inline void mason_inflate_destroy(mason_inflate_ctx *ctx) {
+    if (!ctx)
+        return;
+    inflateEnd(&ctx->zs);
+    mason_buf_free(&ctx->out);
+    MASON_FREE(ctx);
+}
+
+/* The last complete message, NUL-terminated; NULL while a message is still arriving */
+static inline char *mason_inflate_message(mason_inflate_ctx *ctx, size_t *len) {
+    if (!ctx->complete) {
+        *len = 0;
+        return NULL;
+    }
+    *len = ctx->out.len;
+    return ctx->out.data;
+}
+
+static inline mason_inflate_status mason_inflate_feed(mason_inflate_ctx *ctx, const uint8_t *frame, size_t len) {
+    if (ctx->failed || (!frame && len))
+        return MASON_INFLATE_ERROR;
+    if (ctx->complete) {
+        mason_buf_reset(&ctx->out);
+        ctx->complete = false;
+    }
+    for (size_t i = len > 4 ? len - 4 : 0; i < len; i++)
+        ctx->tail = (ctx->tail << 8) | frame[i];
+
+    /* zlib's avail_in is a uInt, so very large frames go in slices */
+    size_t fed = 0;
+    int rc = Z_OK;
+    while (fed < len || rc == Z_OK) {
+        if (!mason_buf_reserve(&ctx->out, MASON_INFLATE_CHUNK)) {
+            ctx->failed = true;
+            return MASON_INFLATE_ERROR;
+        }
+        size_t slice = len - fed > UINT_MAX ? UINT_MAX : len - fed;
+        ctx->zs.next_in = (Bytef *)(frame + fed);
+        ctx->zs.avail_in = (uInt)slice;
+        ctx->zs.next_out = (Bytef *)(ctx->out.data + ctx->out.len);
+        size_t room = ctx->out.cap - ctx->out.len - 1; // keeps space for the NUL terminator
+        if (room > UINT_MAX)
+            room = UINT_MAX;
+        ctx->zs.avail_out = (uInt)room;
+        rc = inflate(&ctx->zs, Z_SYNC_FLUSH);
+        fed += slice - ctx->zs.avail_in;
+        ctx->out.len += room - ctx->zs.avail_out;
+        if (rc == Z_STREAM_END || (rc == Z_BUF_ERROR && fed == len))
+            break;
+        if (rc != Z_OK) {
+            ctx->failed = true;
+            return MASON_INFLATE_ERROR;
+        }
+        /* Input used up and output not full: everything available is out */
+        if (fed == len && ctx->zs.avail_out)
+            break;
+    }
+    ctx->out.data[ctx->out.len] = '\0';
+
+    if (ctx->tail != 0x0000FFFFu && rc != Z_STREAM_END)
+        return MASON_INFLATE_PARTIAL;
+    if (rc == Z_STREAM_END)
+        inflateReset(&ctx->zs);
+    ctx->complete = true;
+    ctx->tail = 0;
+    return MASON_INFLATE_MESSAGE;
+}
+
+/* Partial inflate impl */
+#define _MASON_IMPL_INFLATE(struct_name, FIELDS)                                                         \
+    mason_inflate_status struct_name##_inflate(mason_inflate_ctx *ctx, const uint8_t *frame, size_t len, \
+                                               struct_name **out) {                                      \
+        *out = NULL;                                                                                     \
+        mason_inflate_status status = mason_inflate_feed(ctx, frame, len);                               \
+        if (status == MASON_INFLATE_MESSAGE)                                                             \
+            *out = struct_name##_decode_inplace(ctx->out.data, ctx->out.len);                            \
+        return status;                                                                                   \
+    }
+
+#else // !MASON_ZLIB_IMPL
+
+#define _MASON_IMPL_INFLATE(struct_name, FIELDS)                                                         \
+    mason_inflate_status struct_name##_inflate(mason_inflate_ctx *ctx, const uint8_t *frame, size_t len, \
+                                               struct_name **out) {                                      \
+        (void)ctx;                                                                                       \
+        (void)frame;                                                                                     \
+        (void)len;                                                                                       \
+        *out = NULL;                                                                                     \
+        fprintf(stderr, "%s_inflate unavailable: define MASON_ZLIB_IMPL\n", #struct_name);               \
+        return MASON_INFLATE_ERROR;                                                                      \
+    }
+
+#endif // MASON_ZLIB_IMPL
+
+#endif // MASON_ZLIB_H